@@ -7,10 +7,34 @@
 
 #include "plotinstance.h"
 
+#include "rt/rtsamplequeue.h"
+
 #include <QMutex>
+#include <QSet>
 #include <QThread>
 #include <QTimer>
 
+namespace
+{
+  /// Share the time array of a newly completed @p curve with another completed curve
+  /// from the same source, where the times are identical. Main thread only.
+  /// @param curve The completed curve.
+  void shareTimes(PlotInstance *curve)
+  {
+    const PlotSource &source = curve->source();
+    for (unsigned i = 0; i < source.curveCount(); ++i)
+    {
+      const PlotInstance *other = source.curve(i);
+      // Completed curves with matching times already share, so stop at the first match.
+      if (other && other != curve && other->dataComplete() && curve->shareTimes(*other))
+      {
+        return;
+      }
+    }
+  }
+}
+
+
 Curves::CurveList::CurveList(QMutex &mutex, const QList<PlotInstance *> &curves)
   : _mutex(&mutex)
   , _curves(&curves)
@@ -82,6 +106,51 @@ Curves::CurveList Curves::realTimeCurves() const
 }
 
 
+void Curves::setDependencies(PlotInstance *curve, const QList<const PlotInstance *> &inputs)
+{
+  QMutexLocker lock(_curvesMutex);
+  _dependencies.insert(curve, inputs);
+}
+
+
+QList<PlotInstance *> Curves::dependents(const QList<const PlotInstance *> &curves) const
+{
+  QMutexLocker lock(_curvesMutex);
+  QSet<const PlotInstance *> visited;
+  for (const PlotInstance *curve : curves)
+  {
+    visited.insert(curve);
+  }
+  QList<PlotInstance *> found;
+  // Expand until no more dependents are found. Graphs are shallow, so this converges quickly.
+  bool expanded = true;
+  while (expanded)
+  {
+    expanded = false;
+    for (auto iter = _dependencies.begin(); iter != _dependencies.end(); ++iter)
+    {
+      if (visited.contains(iter.key()))
+      {
+        continue;
+      }
+
+      for (const PlotInstance *input : iter.value())
+      {
+        if (visited.contains(input))
+        {
+          visited.insert(iter.key());
+          found.append(iter.key());
+          expanded = true;
+          break;
+        }
+      }
+    }
+  }
+
+  return found;
+}
+
+
 unsigned Curves::removeUsingExpression(const PlotExpression *expression)
 {
   if (!expression)
@@ -102,10 +171,15 @@ unsigned Curves::removeUsingExpression(const PlotExpression *expression)
         QMutexLocker llock(_loadingMutex);
         _loadingCurves.removeOne(curve);
       }
+      {
+        // Streaming expressions generate real-time curves.
+        QMutexLocker rtlock(_realTimeMutex);
+        _realTimeCurves.removeOne(curve);
+      }
 
       curve->source().removeCurve(curve);
+      removeDependencies(curve);
 
-      // Don't check real-time curves. They don't support expressions.
       emit curveRemoved(curve);
 
       delete curve;
@@ -220,11 +294,13 @@ void Curves::completeLoading(PlotInstance *curve)
     else
     {
       // On the main thread. migrate whatever data are left to display most current curve.
+      // Mark complete first so the migration is not deferred by a pinned snapshot.
+      curve->setComplete();
       if (curve->migrateBuffer())
       {
         emit curveDataChanged(curve);
       }
-      curve->setComplete();
+      shareTimes(curve);
       emit curveComplete(curve);
     }
 
@@ -241,11 +317,11 @@ void Curves::completeLoading(PlotInstance *curve)
     if (_realTimeCurves.removeOne(curve))
     {
       rtlock.unlock();
+      curve->setComplete();
       if (curve->migrateBuffer())
       {
         emit curveDataChanged(curve);
       }
-      curve->setComplete();
       emit curveComplete(curve);
 
       rtlock.relock();
@@ -271,6 +347,7 @@ bool Curves::removeCurve(const PlotInstance *curve)
   _realTimeCurves.removeOne(c);
   if (_curves.removeOne(c))
   {
+    removeDependencies(curve);
     rtlock.unlock();
     llock.unlock();
     lock.unlock();
@@ -325,6 +402,7 @@ void Curves::clearCurves()
   {
     PlotInstance *curve = _curves.back();
     _curves.pop_back();
+    removeDependencies(curve);
     llock.relock();
     rtlock.relock();
     _loadingCurves.removeOne(curve);
@@ -343,6 +421,26 @@ void Curves::clearCurves()
 }
 
 
+void Curves::addRealTimeQueue(RTSampleQueue *queue)
+{
+  QMutexLocker rtlock(_realTimeMutex);
+  if (!_realTimeQueues.contains(queue))
+  {
+    _realTimeQueues.append(queue);
+  }
+}
+
+
+void Curves::removeRealTimeQueue(RTSampleQueue *queue)
+{
+  QMutexLocker rtlock(_realTimeMutex);
+  if (_realTimeQueues.removeOne(queue))
+  {
+    queue->migrate();
+  }
+}
+
+
 bool Curves::migrateLoadingData()
 {
   QMutexLocker llock(_loadingMutex);
@@ -364,20 +462,35 @@ bool Curves::migrateLoadingData()
       emit curveDataChanged(curve);
       migrated = true;
     }
+    shareTimes(curve);
     emit curveComplete(curve);
   }
   _completedCurves.clear();
   llock.unlock();
 
   QMutexLocker rtlock(_realTimeMutex);
+  for (RTSampleQueue *queue : _realTimeQueues)
+  {
+    queue->migrate();
+  }
+
+  bool realTimeMigrated = false;
   for (PlotInstance *curve : _realTimeCurves)
   {
     if (curve->migrateBuffer())
     {
       emit curveDataChanged(curve);
-      migrated = true;
+      realTimeMigrated = true;
     }
   }
+  rtlock.unlock();
+
+  if (realTimeMigrated)
+  {
+    // Unlocked so streaming expressions can add curves.
+    emit realTimeDataMigrated();
+    migrated = true;
+  }
 
   return migrated;
 }
@@ -445,6 +558,16 @@ bool Curves::restoreProperties(PlotInstance &curve) const
 }
 
 
+void Curves::removeDependencies(const PlotInstance *curve)
+{
+  _dependencies.remove(const_cast<PlotInstance *>(curve));
+  for (QList<const PlotInstance *> &inputs : _dependencies)
+  {
+    inputs.removeAll(curve);
+  }
+}
+
+
 void Curves::addToDeathRow(const PlotInstance *curve)
 {
   QMutexLocker lock(_deathRowMutex);
@@ -18,6 +18,7 @@ class PlotInstance;
 class PlotSource;
 class QMutex;
 class QwtPlotCurve;
+class RTSampleQueue;
 
 typedef QHash<QString, QVariant> VariantMap;
 
@@ -33,6 +34,11 @@ typedef QHash<QString, QVariant> VariantMap;
 /// The @c Curves object is designed to be thread safe to support background loading.
 /// This includes delayed destruction of @c PlotInstance objects as they may be
 /// accessed from different threads.
+///
+/// The model also maintains a dependency graph for curves generated from other curves, such
+/// as expression curves. Generators record the curves each new curve is bound to via
+/// @c setDependencies(). This supports finding the curves affected by a change via
+/// @c dependents() so that only those curves need be regenerated.
 class Curves : public QObject
 {
   Q_OBJECT
@@ -102,6 +108,18 @@ public:
   /// @return The list of real-time curves.
   CurveList realTimeCurves() const;
 
+  /// Record the curves from which @p curve is generated. Thread safe.
+  ///
+  /// The dependencies are released when @p curve is removed.
+  /// @param curve The generated curve.
+  /// @param inputs The curves @p curve is generated from.
+  void setDependencies(PlotInstance *curve, const QList<const PlotInstance *> &inputs);
+
+  /// Find the curves generated from any of @p curves, directly or indirectly. Thread safe.
+  /// @param curves The curves of interest.
+  /// @return The dependent curves, excluding @p curves, in no particular order.
+  QList<PlotInstance *> dependents(const QList<const PlotInstance *> &curves) const;
+
   /// Remove all the curves which where generated from @p expression.
   /// @param expression The expression to look for.
   /// @return The number of curves removed.
@@ -160,9 +178,23 @@ public slots:
   /// Clears all curve data.
   void clearCurves();
 
+  /// Registers a real-time sample queue to be drained by @c migrateLoadingData().
+  ///
+  /// The queue must remain valid until passed to @c removeRealTimeQueue(). Thread safe.
+  /// @param queue The queue to drain.
+  void addRealTimeQueue(RTSampleQueue *queue);
+
+  /// Unregisters a real-time sample queue, migrating any remaining samples into its curves.
+  ///
+  /// The queue producer must have stopped. The queue may be deleted on return. Thread safe.
+  /// @param queue The queue to remove.
+  void removeRealTimeQueue(RTSampleQueue *queue);
+
   /// Migrates data from the back buffer of loading curves into the main display buffer.
   ///
-  /// Invokes @c PlotInstance::migrateBuffer() for each loading curve.
+  /// Invokes @c PlotInstance::migrateBuffer() for each loading curve. Real-time curves
+  /// first have their samples drained from the registered @c RTSampleQueue objects in bulk.
+  /// The @c realTimeDataMigrated() signal is emitted once real-time data have been migrated.
   ///
   /// @return True if some data have been migrated, false when there is nothing to
   ///   migrate.
@@ -198,6 +230,13 @@ signals:
   /// Signals all curve data has been cleared.
   void curvesCleared();
 
+  /// Signals that @c migrateLoadingData() has migrated new samples into real-time curves.
+  ///
+  /// Emitted after @c curveDataChanged() for each affected curve, with no locks held.
+  /// Receivers may add samples to other real-time curves, but must migrate those
+  /// themselves.
+  void realTimeDataMigrated();
+
   /// Signals that all loading curves have completed loading.
   void loadingComplete();
 
@@ -207,6 +246,10 @@ private:
   /// @return True if @c curve is modified as a result.
   bool restoreProperties(PlotInstance &curve) const;
 
+  /// Removes @p curve from the dependency graph. Requires the curves mutex be locked.
+  /// @param curve The curve to remove.
+  void removeDependencies(const PlotInstance *curve);
+
   /// Adds the given curve to death row for deletion and triggers an event to
   /// clear death row.
   /// @param curve The curve to delete.
@@ -220,8 +263,11 @@ private:
   QList<PlotInstance *> _curves;          ///< All curves.
   QList<PlotInstance *> _loadingCurves;   ///< Curves which are loading.
   QList<PlotInstance *> _realTimeCurves;  ///< Real time plots, which never complete unless stopped.
+  QList<RTSampleQueue *> _realTimeQueues; ///< Real time sample queues to drain. Shares the realTimeMutex.
   QList<PlotInstance *> _completedCurves; ///< Curves finished loading, awaiting notification on the main thread. Shares the loadingMutex
   QList<const PlotInstance *> _deathRow;  ///< Death row list. Cleaned up in @c
+  /// Maps generated curves to the curves they are generated from. Shares the curvesMutex.
+  QHash<PlotInstance *, QList<const PlotInstance *>> _dependencies;
   mutable QMutex *_curvesMutex;           ///< Mutex for @c _curves.
   mutable QMutex *_loadingMutex;          ///< Mutex for @c _loadingCurves.
   mutable QMutex *_realTimeMutex;         ///< Mutex for @c _realTimeCurves.
@@ -7,20 +7,132 @@
 
 #include "expr/plotbindingtracker.h"
 #include "expr/plotexpression.h"
+#include "expr/plotexpressionprogram.h"
 #include "plotfile.h"
 #include "plotinstance.h"
+#include "plotresampler.h"
 
 #include "model/curves.h"
 
+#include <QSet>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <vector>
+
+/// The number of samples evaluated in each call to @c PlotExpressionProgram::sampleBlock().
+#define EXPRESSION_BLOCK_SIZE 1024u
+/// The number of expression tasks evaluated per thread between progress updates.
+#define EXPRESSION_TASKS_PER_THREAD 4
+
 struct GenerationMarker
 {
   bool complete;
   int index;
 };
 
+namespace
+{
+  /// A single expression binding to be evaluated into a new curve.
+  ///
+  /// Expression evaluation modifies the expression state (e.g., curve sampling cursors and
+  /// function contexts), so each task has its own bound copy of the expression.
+  struct ExpressionTask
+  {
+    PlotExpression *expression;       ///< Bound copy of the expression. Owned by the task.
+    PlotInstance *curve;              ///< The curve to populate.
+    /// A private copy of @c curve, into which the expression is evaluated. The @c curve then
+    /// shares the results, while the memo supports binding by other expressions. Owned by
+    /// the task until published to the existing curves.
+    PlotInstance *memo;
+    PlotExpressionBindDomain domain;  ///< The domain to sample.
+  };
+
+
+  /// Release the expression copy and any memo held by @p task.
+  /// @param task The task to release.
+  void releaseTask(ExpressionTask &task)
+  {
+    if (task.expression)
+    {
+      task.expression->unbind();
+      delete task.expression;
+      task.expression = nullptr;
+    }
+
+    delete task.memo;
+    task.memo = nullptr;
+  }
+
+
+  /// Evaluate @p task into its memo, then share the results with its curve. Thread safe so
+  /// long as each task is evaluated only once.
+  /// @param task The task to evaluate. The expression is released on completion.
+  /// @param abortFlag Abort flag, checked between sample blocks.
+  void evaluate(ExpressionTask &task, const bool &abortFlag)
+  {
+    std::vector<double> blockTimes(EXPRESSION_BLOCK_SIZE);
+    std::vector<double> blockValues(EXPRESSION_BLOCK_SIZE);
+    std::vector<QPointF> blockPoints(EXPRESSION_BLOCK_SIZE);
+    PlotExpressionProgram program;
+    const PlotExpressionBindDomain &domain = task.domain;
+
+    // Note: if this sampling loop is changed, then the comments on
+    // PlotExpressionBindDomain must be adjusted to reflect the changes.
+    // Be sure to keep the logic and comments in sync.
+    // Compile the bound expression for faster sampling.
+    program.compile(task.expression);
+    // Sample at the union of the bound curve sample times when requested.
+    std::vector<double> nativeTimes;
+    if (domain.nativeTimes && !domain.timeSources.empty())
+    {
+      PlotResampler::mergeTimes(domain.timeSources.data(), domain.timeSources.size(),
+                                domain.domainMin, domain.domainMax, nativeTimes);
+    }
+    const size_t sampleCount = (!nativeTimes.empty()) ? nativeTimes.size() : domain.sampleCount;
+    const double startTime = domain.domainMin;
+    for (size_t blockStart = 0; blockStart < sampleCount && !abortFlag; blockStart += EXPRESSION_BLOCK_SIZE)
+    {
+      const size_t blockSize = std::min<size_t>(EXPRESSION_BLOCK_SIZE, sampleCount - blockStart);
+      if (!nativeTimes.empty())
+      {
+        std::copy(nativeTimes.begin() + blockStart, nativeTimes.begin() + blockStart + blockSize, blockTimes.begin());
+      }
+      else
+      {
+        for (size_t j = 0; j < blockSize; ++j)
+        {
+          const size_t i = blockStart + j;
+          blockTimes[j] = std::min(startTime + i * domain.sampleDelta, domain.domainMax);
+        }
+      }
+
+      program.sampleBlock(blockTimes.data(), blockValues.data(), blockSize);
+
+      for (size_t j = 0; j < blockSize; ++j)
+      {
+        blockPoints[j] = QPointF(blockTimes[j], blockValues[j]);
+      }
+      task.memo->addPoints(blockPoints.data(), blockSize);
+    }
+
+    program.clear();
+    task.expression->unbind();
+    delete task.expression;
+    task.expression = nullptr;
+    // The memo is private to the task, so may be migrated here. The curve is migrated on the
+    // main thread, swapping in the shared results without copying them.
+    task.memo->migrateBuffer();
+    task.curve->shareData(*task.memo);
+  }
+}
+
 PlotExpressionGenerator::PlotExpressionGenerator(Curves *curves, const QList<PlotExpression *> &expressions, const QStringList &sourceNames)
   : PlotGenerator(curves)
   , _marker(new GenerationMarker( { true, 0 }))
+  , _resamplePolicy(PlotResampler::Linear)
+  , _nativeTimes(false)
 {
   init(curves, expressions, sourceNames);
 }
@@ -29,6 +141,8 @@ PlotExpressionGenerator::PlotExpressionGenerator(Curves *curves, const QList<Plo
 PlotExpressionGenerator::PlotExpressionGenerator(Curves *curves, const QList<const PlotExpression *> &expressions, const QStringList &sourceNames)
   : PlotGenerator(curves)
   , _marker(new GenerationMarker( { true, 0 }))
+  , _resamplePolicy(PlotResampler::Linear)
+  , _nativeTimes(false)
 {
   init(curves, expressions, sourceNames);
 }
@@ -56,28 +170,30 @@ int PlotExpressionGenerator::addExpression(const PlotExpression *expression)
   if (_marker->complete)
   {
     return AER_AlreadyComplete;
+  }
 
-    // Ensure it's not already present.
-    bool exists = false;
-    int index = 0;
-    for (const ExpressionPair &expressionPair : _expressions)
+  // Ensure it's not already present.
+  bool exists = false;
+  int index = 0;
+  for (const ExpressionPair &expressionPair : _expressions)
+  {
+    if (expressionPair.original == expression)
     {
-      if (expressionPair.original == expression)
+      // The marker references the expression being processed.
+      if (index <= _marker->index)
       {
-        if (index >= _marker->index)
-        {
-          // Already passed this item.
-          return AER_AlreadyComplete;
-        }
-        exists = true;
+        // Already passed this item.
+        return AER_AlreadyComplete;
       }
-      ++index;
+      exists = true;
+      break;
     }
+    ++index;
+  }
 
-    if (!exists)
-    {
-      _expressions.append({ expression->clone(), expression });
-    }
+  if (!exists)
+  {
+    _expressions.append({ expression->clone(), expression });
   }
   return AER_Queued;
 }
@@ -102,7 +218,8 @@ int PlotExpressionGenerator::addExpressions(const QList<const PlotExpression *>
     {
       if (expressionPair.original == expression)
       {
-        if (index >= _marker->index)
+        // The marker references the expression being processed.
+        if (index <= _marker->index)
         {
           // Already passed this item.
           ++alreadyProcessedCount;
@@ -114,6 +231,7 @@ int PlotExpressionGenerator::addExpressions(const QList<const PlotExpression *>
         exists = true;
         break;
       }
+      ++index;
     }
 
     if (!exists)
@@ -178,93 +296,196 @@ void PlotExpressionGenerator::run()
     int processedCount = 0;
 
     QList<PlotInstance *> newCurves;
-    const int itemCount = std::max(1, _sourceNames.count());
-
-    for (; _marker->index < _expressions.count(); ++_marker->index)
+    QVector<ExpressionTask> tasks;
+    std::vector<int> expressionTaskEnds;
+    const int batchSize = std::max(1, QThreadPool::globalInstance()->maxThreadCount() * EXPRESSION_TASKS_PER_THREAD);
+
+    // Expressions may be added while generating. Repeat until none are pending. Once none are
+    // pending, repeat a chain pass over all the expressions while the previous pass generated
+    // new curves. This binds expressions which reference the curves generated by other
+    // expressions, using the memoised results rather than recalculating them.
+    bool memoised = false;
+    int chainEnd = 0;
+    while (!_abortFlag)
     {
-      int i = _marker->index;
-      lock.unlock();
-
-      if (_abortFlag)
+      const bool chainPass = _marker->index >= _expressions.count();
+      if (chainPass && !memoised)
       {
         break;
       }
 
-      PlotExpression *exp = _expressions[i].expression;
-      const PlotExpression *originalExpression = _expressions[i].original;
-      int itemIndex = 0;
-      emit itemProgress(0);
-      emit itemName(exp->toString());
-      PlotExpressionBindDomain domain;
-      PlotBindingTracker bindTracker;
-      BindResult bindResult;
-
-      bindResult = exp->bind(_existingCurves, bindTracker, domain);
-      while (bindResult > 0)
+      memoised = false;
+      tasks.clear();
+      expressionTaskEnds.clear();
+
+      // Bind the expressions on this thread. This creates the curves and resolves
+      // duplicates in a deterministic order, regardless of the evaluation order below.
+      // Pending expressions advance the marker, while a chain pass revisits the expressions
+      // already processed.
+      int index = (chainPass) ? 0 : _marker->index;
+      chainEnd = (chainPass) ? _marker->index : chainEnd;
+      for (; ((chainPass) ? index < chainEnd : index < _expressions.count()) && !_abortFlag; ++index)
       {
-        // Expression binds. We can create a curve for this. Use the original source if possible.
-        PlotSource *source = nullptr;
-
-        // There will be a 'first plot' only when we have PlotSample references,
-        // which relate to a source (file).
-        if (bindTracker.firstPlot())
+        if (!chainPass)
         {
-          source = &bindTracker.firstPlot()->source();
+          _marker->index = index;
         }
-        else
+        const ExpressionPair expressionPair = _expressions[index];
+        lock.unlock();
+
+        PlotExpression *exp = expressionPair.expression;
+        const PlotExpression *originalExpression = expressionPair.original;
+        emit itemName(exp->toString());
+        PlotExpressionBindDomain domain;
+        PlotBindingTracker bindTracker;
+        BindResult bindResult;
+        bindTracker.setResamplePolicy(_resamplePolicy);
+        bindTracker.setNativeTimes(_nativeTimes);
+
+        bindResult = exp->bind(_existingCurves, bindTracker, domain);
+        while (bindResult > 0)
         {
-          source = new PlotSource(PlotSource::Expression, exp->toString());
-          source->setTimeColumn(0);
-          source->setTimeBase(0);
-        }
+          // Expression binds. We can create a curve for this. Use the original source if possible.
+          PlotSource *source = nullptr;
 
-        PlotInstance *c = new PlotInstance(source);
-        c->setName(exp->toString());
-        c->setExpression(originalExpression);
+          // There will be a 'first plot' only when we have PlotSample references,
+          // which relate to a source (file).
+          if (bindTracker.firstPlot())
+          {
+            source = &bindTracker.firstPlot()->source();
+          }
+          else
+          {
+            source = new PlotSource(PlotSource::Expression, exp->toString());
+            source->setTimeColumn(0);
+            source->setTimeBase(0);
+          }
 
-        const bool explicitTime = exp->explicitTime();
-        c->setExplicitTime(explicitTime);
-        // We may be generating a duplicate curve. This can occur when we load
-        // a file, generate expression curves, then load another file and generate
-        // new expression curves. We may rebind on the first set of curves.
-        if (!curveExists(*c))
-        {
-          newCurves.append(c);
-          emit beginNewCurves();
-          _curves->newCurve(c);
-          emit endNewCurves();
-
-          // Note: if this sampling loop is changed, then the comments on
-          // PlotExpressionBindDomain must be adjusted to reflect the changes.
-          // Be sure to keep the logic and comments in sync.
-          const double startTime = domain.domainMin;
-          for (uint i = 0; i < domain.sampleCount; ++i)
+          PlotInstance *c = new PlotInstance(source);
+          c->setName(exp->toString());
+          c->setExpression(originalExpression);
+
+          const bool explicitTime = exp->explicitTime();
+          c->setExplicitTime(explicitTime);
+          // We may be generating a duplicate curve. This can occur when we load
+          // a file, generate expression curves, then load another file and generate
+          // new expression curves. We may rebind on the first set of curves.
+          bool created = false;
+          if (!curveExists(*c))
+          {
+            // Evaluate using a copy of the expression bound to the same curves.
+            ExpressionTask task = { exp->clone(), c, nullptr, PlotExpressionBindDomain() };
+            PlotBindingTracker retainTracker(true);
+            retainTracker.setResamplePolicy(_resamplePolicy);
+            retainTracker.setNativeTimes(_nativeTimes);
+            QSet<const PlotExpression *> lineage;
+            if (task.expression->bind(_existingCurves, retainTracker, task.domain) > 0 &&
+                resolveLineage(retainTracker.boundPlots(), originalExpression, lineage))
+            {
+              task.memo = new PlotInstance(*c);
+              _memoLineage.insert(task.memo, lineage);
+
+              newCurves.append(c);
+              emit beginNewCurves();
+              _curves->newCurve(c);
+              emit endNewCurves();
+
+              // Record the dependencies on the original curves, not the snapshots.
+              QList<const PlotInstance *> inputs;
+              for (const PlotInstance *input : retainTracker.boundPlots())
+              {
+                if (const PlotInstance *original = _originals.value(input, nullptr))
+                {
+                  inputs.append(original);
+                }
+              }
+              _curves->setDependencies(c, inputs);
+
+              tasks.append(task);
+              created = true;
+            }
+            else
+            {
+              releaseTask(task);
+            }
+          }
+
+          if (!created)
           {
-            double time = std::min(startTime + i * domain.sampleDelta, domain.domainMax);
-            double val = exp->sample(time);
-            c->addPoint(QPointF(time, val));
+            delete c;
+            c = nullptr;
+          }
+
+          exp->unbind();
+          if (bindResult == BoundMaybeMore)
+          {
+            bindTracker.clearFirstPlot();
+            bindResult = exp->bind(_existingCurves, bindTracker, domain);
+          }
+          else
+          {
+            bindResult = BindFailure;
           }
         }
-        else
+
+        expressionTaskEnds.push_back(tasks.count());
+        lock.relock();
+      }
+
+      if (!chainPass)
+      {
+        _marker->index = index;
+      }
+      lock.unlock();
+
+      // Evaluate the tasks across the thread pool. Batching supports progress reporting
+      // and abort while the pool balances the load within each batch. Progress is reported
+      // against the expressions in order as their tasks complete. A chain pass does not
+      // report overall progress as its expressions have already been counted.
+      emit itemProgress(0);
+      size_t expressionIndex = (chainPass) ? expressionTaskEnds.size() : 0;
+      for (int batchStart = 0; batchStart < tasks.count() && !_abortFlag; batchStart += batchSize)
+      {
+        const int batchEnd = std::min(batchStart + batchSize, tasks.count());
+        const bool &abortFlag = _abortFlag;
+        QtConcurrent::blockingMap(tasks.begin() + batchStart, tasks.begin() + batchEnd,
+                                  [&abortFlag](ExpressionTask &task) { evaluate(task, abortFlag); });
+
+        emit itemProgress((100 * batchEnd) / tasks.count());
+        for (; expressionIndex < expressionTaskEnds.size() && expressionTaskEnds[expressionIndex] <= batchEnd; ++expressionIndex)
         {
-          delete c;
-          c = nullptr;
+          emit overallProgress(++processedCount, _expressions.count());
         }
+      }
 
-        exp->unbind();
-        if (bindResult == BoundMaybeMore)
+      if (!_abortFlag)
+      {
+        // Expressions without tasks.
+        for (; expressionIndex < expressionTaskEnds.size(); ++expressionIndex)
         {
-          bindTracker.clearFirstPlot();
-          bindResult = exp->bind(_existingCurves, bindTracker, domain);
+          emit overallProgress(++processedCount, _expressions.count());
         }
-        else
+
+        // Publish the memoised results for binding in the following passes.
+        for (ExpressionTask &task : tasks)
         {
-          bindResult = BindFailure;
+          _existingCurves.append(task.memo);
+          _originals.insert(task.memo, task.curve);
+          task.memo = nullptr;
+          memoised = true;
         }
-        emit itemProgress((100 * ++itemIndex) / (100 * itemCount));
       }
 
-      emit overallProgress(++processedCount, _expressions.count());
+      // Release unevaluated tasks on abort.
+      for (ExpressionTask &task : tasks)
+      {
+        if (task.memo)
+        {
+          _memoLineage.remove(task.memo);
+        }
+        releaseTask(task);
+      }
+
       lock.relock();
     }
 
@@ -303,6 +524,28 @@ void PlotExpressionGenerator::run()
 }
 
 
+bool PlotExpressionGenerator::resolveLineage(const QList<PlotInstance *> &inputs, const PlotExpression *expression,
+                                             QSet<const PlotExpression *> &lineage) const
+{
+  lineage.clear();
+  lineage.insert(expression);
+  for (const PlotInstance *input : inputs)
+  {
+    auto search = _memoLineage.find(input);
+    if (search != _memoLineage.end())
+    {
+      if (search.value().contains(expression))
+      {
+        // Cyclic: the input has been generated from this expression.
+        return false;
+      }
+      lineage.unite(search.value());
+    }
+  }
+  return true;
+}
+
+
 bool PlotExpressionGenerator::curveExists(const PlotInstance &curve) const
 {
   for (const PlotInstance *other : _existingCurves)
@@ -328,10 +571,19 @@ void PlotExpressionGenerator::init(Curves *curves, const QList<T *> &expressions
     _expressions.append({ exp->clone(), exp });
   }
 
-  for (const PlotInstance *curve : curves->curves())
+  // Snapshot the existing curves. The copies share the sample data with the originals.
+  // Live real-time curves are excluded as these are evaluated by RealTimeExpressions.
+  const QList<PlotInstance *> realTimeCurves = curves->realTimeCurves().list();
+  for (PlotInstance *curve : curves->curves())
   {
+    if (realTimeCurves.contains(curve))
+    {
+      continue;
+    }
+
     PlotInstance *c = new PlotInstance(*curve);
     _existingCurves.push_back(c);
+    _originals.insert(c, curve);
   }
 }
 
@@ -9,6 +9,10 @@
 #include "ocurvesconfig.h"
 
 #include "plotgenerator.h"
+#include "plotresampler.h"
+
+#include <QHash>
+#include <QSet>
 
 class QMutex;
 
@@ -27,6 +31,13 @@ class QMutex;
 /// generator object. Instead, generated plots may be out of date or reference an
 /// invalid expression.
 ///
+/// Generation is performed in two phases. First, pending expressions are bound in order
+/// on the generator thread, creating a curve for each new binding. Duplicate detection and
+/// curve creation order are thus deterministic. Each binding yields a task with its own
+/// bound copy of the expression (see @c PlotBindingTracker::retainBindings()). The tasks
+/// are then evaluated concurrently on the global @c QThreadPool, so that multiple expressions
+/// and multiple bindings of the same expression are generated in parallel.
+///
 /// Plot binding is exhaustive, supporting regular expression based @c PlotExpression
 /// trees. However, this can lead to multiple bindings of the same data when referencing
 /// regular expressions from different plots. For example, the expression:
@@ -40,6 +51,25 @@ class QMutex;
 /// - 'samples-a'|'value' - 'samples-b'|'value'
 /// - 'samples-b'|'value' - 'samples-b'|'value'
 ///
+/// Expressions may reference curves generated by other expressions. Once all expressions
+/// have been bound, the expressions are bound again in chain passes so long as the previous
+/// pass generated new curves. Each expression is evaluated into a memo curve, an additional
+/// snapshot which shares its results with the generated curve, so dependent expressions bind
+/// to the results rather than recalculating them. A generated curve is thus populated once its
+/// evaluation is complete. An expression may not bind curves generated from itself, directly
+/// or indirectly.
+///
+/// The curves each new curve is bound to are recorded via @c Curves::setDependencies(). Along
+/// with the duplicate checks, this supports regenerating only the curves affected by a
+/// change, by removing those curves and generating the affected expressions again.
+///
+/// Expressions combining curves with different time bases sample each curve according to the
+/// @c resamplePolicy(). With @c nativeTimes() set, expressions are sampled at the union of
+/// the sample times of their bound curves rather than at a uniform sample rate.
+///
+/// Real-time curves which are still receiving data are not bound. Expressions over these
+/// curves are evaluated incrementally by @c RealTimeExpressions instead.
+///
 /// @note The @c PlotSource for @c PlotInstance objects generated here is the same as
 /// the original source. Expression curves can be distinguished by the fact that
 /// @c PlotInstance::expression() is not null.
@@ -94,6 +124,24 @@ public:
   /// @return One of the values in @c AddExpressionResult.
   int addExpressions(const QList<const PlotExpression *> &expressions);
 
+  /// Set the policy for sampling curves between their sample times. Set before starting.
+  /// @param policy The resampling policy.
+  inline void setResamplePolicy(PlotResampler::Policy policy) { _resamplePolicy = policy; }
+
+  /// Query the policy for sampling curves between their sample times.
+  /// Defaults to @c PlotResampler::Linear.
+  /// @return The resampling policy.
+  inline PlotResampler::Policy resamplePolicy() const { return _resamplePolicy; }
+
+  /// Set whether to sample expressions at the union of the native sample times of their
+  /// bound curves, rather than at a uniform rate. Set before starting.
+  /// @param native True to sample at native times.
+  inline void setNativeTimes(bool native) { _nativeTimes = native; }
+
+  /// Query whether to sample expressions at native times. Defaults to false.
+  /// @return True to sample at native times.
+  inline bool nativeTimes() const { return _nativeTimes; }
+
   /// Aborts generation of @p expression if it has yet to be generated. Thread-safe.
   ///
   /// @return True if the given expression has been removed or was not present. False if
@@ -113,6 +161,17 @@ protected:
   /// @return True if a matching curves exists.
   bool curveExists(const PlotInstance &curve) const;
 
+  /// Resolve the expressions a new curve is generated from, directly or indirectly.
+  ///
+  /// This is @p expression and the lineage of any memoised @p inputs.
+  ///
+  /// @param inputs The curves bound by the new curve.
+  /// @param expression The original expression generating the new curve.
+  /// @param[out] lineage Set to the resolved lineage.
+  /// @return False if the binding is cyclic: an input is generated from @p expression.
+  bool resolveLineage(const QList<PlotInstance *> &inputs, const PlotExpression *expression,
+                      QSet<const PlotExpression *> &lineage) const;
+
 private:
   /// Initialisation function called from the constructors to perform common initialisation.
   /// @tparam T Either @c PlotExpression or <tt>const PlotExpression</tt>.
@@ -135,9 +194,17 @@ private:
   };
 
   QVector<ExpressionPair> _expressions;   ///< Expressions used for evaluation.
-  QList<PlotInstance *> _existingCurves;  ///< A copy of existing curves when loading generated expressions.
+  /// A snapshot of existing curves when loading generated expressions. Copies share the
+  /// curve data (copy-on-write), so this is cheap and safe to read on the generator thread.
+  QList<PlotInstance *> _existingCurves;
+  /// Maps @c _existingCurves items to the curves in the @c Curves model.
+  QHash<const PlotInstance *, PlotInstance *> _originals;
+  /// The expressions each memoised curve in @c _existingCurves is generated from.
+  QHash<const PlotInstance *, QSet<const PlotExpression *>> _memoLineage;
   QStringList _sourceNames;               /// Only for use with plot expressions.
   struct GenerationMarker *_marker;       ///< Tracks generation progress to support @c addExpression() and @c removeExpression().
+  PlotResampler::Policy _resamplePolicy; ///< @c resamplePolicy()
+  bool _nativeTimes;                      ///< @c nativeTimes()
 };
 
 #endif // PLOTEXPRESSIONGENERATOR_H_
@@ -0,0 +1,302 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "plotfilecache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include <cstring>
+
+namespace
+{
+  const char CacheMarker[8] = { 'O', 'C', 'C', 'A', 'C', 'H', 'E', '\0' };
+  const quint32 ByteOrderMarker = 0x01020304u;
+
+  /// Fixed size cache header. Followed by the source path and headings, then the
+  /// column data at @c dataOffset.
+  struct CacheHeader
+  {
+    char marker[8];         ///< @c CacheMarker
+    quint32 version;        ///< @c PlotFileCache::Version
+    quint32 byteOrder;      ///< @c ByteOrderMarker written in native byte order.
+    qint64 sourceSize;      ///< Size of the source file.
+    qint64 sourceModified;  ///< Source file modification time (ms since epoch).
+    quint64 rowCount;       ///< Values per column.
+    quint32 columnCount;    ///< Number of columns.
+    quint32 stringsSize;    ///< Byte size of the strings block following the header.
+    quint64 dataOffset;     ///< Byte offset to the first column. Aligned to a double.
+  };
+
+
+  /// Build the strings block: the source path, then each heading. Each string is
+  /// written as a 32-bit byte count followed by UTF-8 characters.
+  QByteArray encodeStrings(const QString &sourceFile, const QStringList &headings)
+  {
+    QByteArray block;
+    auto append = [&block] (const QString &str)
+    {
+      const QByteArray utf8 = str.toUtf8();
+      const quint32 len = quint32(utf8.size());
+      block.append(reinterpret_cast<const char *>(&len), sizeof(len));
+      block.append(utf8);
+    };
+
+    append(sourceFile);
+    for (const QString &heading : headings)
+    {
+      append(heading);
+    }
+    return block;
+  }
+
+
+  /// Decode the strings block written by @c encodeStrings().
+  bool decodeStrings(const uchar *block, quint32 blockSize, unsigned stringCount, QStringList &strings)
+  {
+    quint32 pos = 0;
+    strings.clear();
+    for (unsigned i = 0; i < stringCount; ++i)
+    {
+      quint32 len = 0;
+      if (pos + sizeof(len) > blockSize)
+      {
+        return false;
+      }
+      memcpy(&len, block + pos, sizeof(len));
+      pos += sizeof(len);
+      if (len > blockSize - pos)
+      {
+        return false;
+      }
+      strings << QString::fromUtf8(reinterpret_cast<const char *>(block + pos), int(len));
+      pos += len;
+    }
+    return true;
+  }
+
+
+  /// Resolve the size and modification time to validate a cache against.
+  void sourceStats(const QString &sourceFile, qint64 &size, qint64 &modified)
+  {
+    QFileInfo info(sourceFile);
+    size = info.size();
+    modified = info.lastModified().toMSecsSinceEpoch();
+  }
+}
+
+
+PlotFileCache::PlotFileCache()
+  : _data(nullptr)
+  , _dataOffset(0)
+  , _rowCount(0)
+  , _writing(false)
+{
+}
+
+
+PlotFileCache::~PlotFileCache()
+{
+  close();
+}
+
+
+QString PlotFileCache::cachePath(const QString &sourceFile)
+{
+  QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (cacheDir.isEmpty())
+  {
+    return QString();
+  }
+
+  // Name the cache by hashing the absolute source path.
+  const QString absPath = QFileInfo(sourceFile).absoluteFilePath();
+  const QByteArray hash = QCryptographicHash::hash(absPath.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return QDir(cacheDir).filePath(QString("occache/%1.occache").arg(QString::fromLatin1(hash)));
+}
+
+
+bool PlotFileCache::open(const QString &sourceFile)
+{
+  close();
+
+  const QString path = cachePath(sourceFile);
+  if (path.isEmpty())
+  {
+    return false;
+  }
+
+  _file.setFileName(path);
+  if (!_file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  const qint64 fileSize = _file.size();
+  if (fileSize < qint64(sizeof(CacheHeader)))
+  {
+    _file.close();
+    return false;
+  }
+
+  uchar *data = _file.map(0, fileSize);
+  if (!data)
+  {
+    _file.close();
+    return false;
+  }
+
+  CacheHeader header;
+  memcpy(&header, data, sizeof(header));
+
+  qint64 sourceSize = 0, sourceModified = 0;
+  sourceStats(sourceFile, sourceSize, sourceModified);
+
+  bool ok = memcmp(header.marker, CacheMarker, sizeof(CacheMarker)) == 0;
+  ok = ok && header.version == Version && header.byteOrder == ByteOrderMarker;
+  ok = ok && header.sourceSize == sourceSize && header.sourceModified == sourceModified;
+  ok = ok && header.dataOffset >= sizeof(header) + header.stringsSize;
+  ok = ok && header.dataOffset % sizeof(double) == 0;
+  ok = ok && header.dataOffset <= quint64(fileSize);
+  // Each string needs at least its byte count.
+  ok = ok && header.columnCount < header.stringsSize / sizeof(quint32);
+  // Validate the data size by division, as a corrupt header may overflow the product.
+  ok = ok && (!header.columnCount ||
+              header.rowCount <= (quint64(fileSize) - header.dataOffset) / sizeof(double) / header.columnCount);
+
+  QStringList strings;
+  ok = ok && decodeStrings(data + sizeof(header), header.stringsSize, header.columnCount + 1, strings);
+  // Guard against hash collisions.
+  ok = ok && strings.first() == QFileInfo(sourceFile).absoluteFilePath();
+
+  if (!ok)
+  {
+    _file.unmap(data);
+    _file.close();
+    return false;
+  }
+
+  strings.removeFirst();
+  _headings = strings;
+  _data = data;
+  _dataOffset = header.dataOffset;
+  _rowCount = header.rowCount;
+  _writing = false;
+  return true;
+}
+
+
+bool PlotFileCache::create(const QString &sourceFile, const QStringList &headings, quint64 rowCount)
+{
+  close();
+
+  _targetPath = cachePath(sourceFile);
+  if (_targetPath.isEmpty() || !QDir().mkpath(QFileInfo(_targetPath).absolutePath()))
+  {
+    return false;
+  }
+
+  const QString absPath = QFileInfo(sourceFile).absoluteFilePath();
+  const QByteArray strings = encodeStrings(absPath, headings);
+
+  CacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.marker, CacheMarker, sizeof(CacheMarker));
+  header.version = Version;
+  header.byteOrder = ByteOrderMarker;
+  sourceStats(sourceFile, header.sourceSize, header.sourceModified);
+  header.rowCount = rowCount;
+  header.columnCount = quint32(headings.size());
+  header.stringsSize = quint32(strings.size());
+  header.dataOffset = sizeof(header) + strings.size();
+  header.dataOffset += (sizeof(double) - header.dataOffset % sizeof(double)) % sizeof(double);
+
+  const qint64 totalSize = qint64(header.dataOffset + rowCount * header.columnCount * sizeof(double));
+
+  _file.setFileName(_targetPath + ".tmp");
+  if (!_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+  {
+    return false;
+  }
+
+  bool ok = _file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header));
+  ok = ok && _file.write(strings) == strings.size();
+  ok = ok && _file.resize(totalSize);
+  if (ok && totalSize > 0)
+  {
+    _data = _file.map(0, totalSize);
+  }
+
+  if (!_data)
+  {
+    _file.close();
+    _file.remove();
+    return false;
+  }
+
+  _headings = headings;
+  _dataOffset = header.dataOffset;
+  _rowCount = rowCount;
+  _writing = true;
+  return true;
+}
+
+
+bool PlotFileCache::commit()
+{
+  if (!_writing || !_data)
+  {
+    return false;
+  }
+
+  _file.unmap(_data);
+  _data = nullptr;
+  _writing = false;
+  _file.close();
+
+  QFile::remove(_targetPath);
+  return _file.rename(_targetPath);
+}
+
+
+void PlotFileCache::close()
+{
+  if (_data)
+  {
+    _file.unmap(_data);
+    _data = nullptr;
+  }
+
+  if (_file.isOpen())
+  {
+    _file.close();
+  }
+
+  if (_writing)
+  {
+    // Uncommitted.
+    _file.remove();
+    _writing = false;
+  }
+
+  _headings.clear();
+  _rowCount = 0;
+  _dataOffset = 0;
+}
+
+
+const double *PlotFileCache::column(unsigned index) const
+{
+  return reinterpret_cast<const double *>(_data + _dataOffset) + index * _rowCount;
+}
+
+
+double *PlotFileCache::writeColumn(unsigned index)
+{
+  return reinterpret_cast<double *>(_data + _dataOffset) + index * _rowCount;
+}
@@ -0,0 +1,117 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef PLOTFILECACHE_H_
+#define PLOTFILECACHE_H_
+
+#include "ocurvesconfig.h"
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+/// @ingroup gen
+/// Supports reading and writing binary, columnar caches of data files (".occache").
+///
+/// A cache holds the raw values parsed from a data file, allowing the file to be
+/// reloaded without parsing the text. The cache contains:
+/// - A header identifying the format version and byte order.
+/// - The size and modification time of the source file, used to validate the cache.
+/// - The source file path and column headings.
+/// - One contiguous array of @c double values for each column, all of the same length.
+///
+/// Values are stored before time and display processing, so the cache is independent
+/// of the @c TimeSampling used to load the file. Caches are only written for files
+/// where every data line contains the same number of items as there are headings.
+///
+/// Cache files are stored in the user cache directory (see @c cachePath()) and are
+/// memory mapped for reading.
+///
+/// To read a cache, call @c open() and on success, access the @c headings() and each
+/// @c column(). To write a cache, call @c create(), populate each @c writeColumn() then
+/// @c commit(). The cache is written to a temporary file until committed.
+class PlotFileCache
+{
+public:
+  /// Cache file format version.
+  enum
+  {
+    Version = 1
+  };
+
+  /// Constructor.
+  PlotFileCache();
+
+  /// Destructor. Discards any uncommitted cache.
+  ~PlotFileCache();
+
+  /// Determine the cache file path for @p sourceFile.
+  /// @param sourceFile The data file path.
+  /// @return The cache file path or an empty string if there is no cache location.
+  static QString cachePath(const QString &sourceFile);
+
+  /// Open and validate the cache for @p sourceFile for reading.
+  ///
+  /// Fails if there is no cache, or if the cache does not match the current
+  /// size or modification time of @p sourceFile.
+  ///
+  /// @param sourceFile The data file path.
+  /// @return True if the cache is valid and open for reading.
+  bool open(const QString &sourceFile);
+
+  /// Create a cache for @p sourceFile with the given dimensions.
+  ///
+  /// The source file size and modification time are recorded immediately.
+  ///
+  /// @param sourceFile The data file path.
+  /// @param headings The column headings.
+  /// @param rowCount The number of values in each column.
+  /// @return True if the cache file has been created and mapped for writing.
+  bool create(const QString &sourceFile, const QStringList &headings, quint64 rowCount);
+
+  /// Commit a cache being written by @c create(). Replaces any existing cache.
+  /// @return True on success.
+  bool commit();
+
+  /// Close the cache, discarding any uncommitted cache.
+  void close();
+
+  /// Is a cache open for reading or writing?
+  /// @return True if open.
+  inline bool isOpen() const { return _data != nullptr; }
+
+  /// Access the column headings.
+  /// @return The headings, one per column.
+  inline const QStringList &headings() const { return _headings; }
+
+  /// Access the number of columns.
+  /// @return The column count.
+  inline unsigned columnCount() const { return unsigned(_headings.size()); }
+
+  /// Access the number of values in each column.
+  /// @return The row count.
+  inline quint64 rowCount() const { return _rowCount; }
+
+  /// Access the values for a column. Only valid while open.
+  /// @param index The column index. Must be less than @c columnCount().
+  /// @return The @c rowCount() values for the column.
+  const double *column(unsigned index) const;
+
+  /// Access the values for a column for writing. Only valid after @c create().
+  /// @param index The column index. Must be less than @c columnCount().
+  /// @return The @c rowCount() values for the column.
+  double *writeColumn(unsigned index);
+
+private:
+  QFile _file;            ///< The cache file.
+  QStringList _headings;  ///< Column headings.
+  uchar *_data;           ///< The mapped cache file.
+  quint64 _dataOffset;    ///< Byte offset to the first column in @c _data.
+  quint64 _rowCount;      ///< Values per column.
+  QString _targetPath;    ///< Final path for a cache being written.
+  bool _writing;          ///< True when writing (after @c create()).
+};
+
+#endif // PLOTFILECACHE_H_
@@ -6,12 +6,30 @@
 #include "plotfileloader.h"
 
 #include "plotfile.h"
+#include "plotfilecache.h"
+#include "plotfilemap.h"
 #include "plotinstance.h"
 
 #include "model/curves.h"
 
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <memory>
+
 #define TARGET_SAMPLES 20000
 
+// Target byte size for each chunk of a memory mapped file.
+#define MAPPED_CHUNK_SIZE (4 * 1024 * 1024)
+// Number of chunks to parse per thread before migrating the parsed values.
+#define MAPPED_CHUNKS_PER_THREAD 2
+
+// Files smaller than this are not cached.
+#define CACHE_MIN_FILE_SIZE (1024 * 1024)
+// Number of rows to migrate from a cache at a time.
+#define CACHE_BLOCK_SIZE (64 * 1024)
+
 #define ITEM_PROGESS_TICKS 1000
 #define OVERALL_PROGRESS_FILE_TICKS 100
 
@@ -27,6 +45,302 @@ namespace
     // Infinite check : value <= max && -value <= max
     return value == value && (value <= maxValue && -value <= maxValue);
   }
+
+
+  /// Tracks the minimum and maximum values of a column over a preview bucket.
+  struct PreviewBucket
+  {
+    QPointF minPoint;   ///< Sample with the minimum value.
+    QPointF maxPoint;   ///< Sample with the maximum value.
+    size_t minLine;     ///< Line number of @c minPoint.
+    size_t maxLine;     ///< Line number of @c maxPoint.
+    bool valid;         ///< Has the bucket been started?
+
+    inline PreviewBucket() : minLine(0), maxLine(0), valid(false) {}
+  };
+
+
+  /// Add a sample from @p line to a preview @p bucket.
+  void addPreviewSample(PreviewBucket &bucket, size_t line, const QPointF &point)
+  {
+    if (!bucket.valid)
+    {
+      bucket.minPoint = bucket.maxPoint = point;
+      bucket.minLine = bucket.maxLine = line;
+      bucket.valid = true;
+      return;
+    }
+
+    if (point.y() < bucket.minPoint.y())
+    {
+      bucket.minPoint = point;
+      bucket.minLine = line;
+    }
+    if (point.y() > bucket.maxPoint.y())
+    {
+      bucket.maxPoint = point;
+      bucket.maxLine = line;
+    }
+  }
+
+
+  /// Merge the @p src bucket, covering later lines, into @p dst.
+  void mergePreviewBucket(PreviewBucket &dst, const PreviewBucket &src)
+  {
+    if (src.valid)
+    {
+      addPreviewSample(dst, src.minLine, src.minPoint);
+      addPreviewSample(dst, src.maxLine, src.maxPoint);
+    }
+  }
+
+
+  /// Add the minimum and maximum samples of @p bucket to @p points in line order
+  /// and reset the bucket.
+  void flushPreviewBucket(PreviewBucket &bucket, std::vector<QPointF> &points)
+  {
+    if (bucket.valid)
+    {
+      if (bucket.minLine < bucket.maxLine)
+      {
+        points.push_back(bucket.minPoint);
+        points.push_back(bucket.maxPoint);
+      }
+      else if (bucket.maxLine < bucket.minLine)
+      {
+        points.push_back(bucket.maxPoint);
+        points.push_back(bucket.minPoint);
+      }
+      else
+      {
+        points.push_back(bucket.minPoint);
+      }
+      bucket.valid = false;
+    }
+  }
+
+
+  /// Assigns data lines to preview buckets. The first and last lines are given their own
+  /// buckets to preserve the data extents. Bucket indices increase with the line number.
+  struct PreviewLayout
+  {
+    size_t bucketLines; ///< Number of lines in each bucket.
+    size_t lastLine;    ///< The last data line.
+
+    /// Resolve the bucket for @p line.
+    /// @param line The line number.
+    /// @return The bucket index.
+    inline size_t bucketOf(size_t line) const
+    {
+      return (line == 0) ? 0 : ((line == lastLine) ? 2 + lastLine / bucketLines : 1 + line / bucketLines);
+    }
+  };
+
+
+  /// The preview buckets of a single chunk.
+  struct ChunkPreview
+  {
+    const PlotFileMap::ChunkData *chunk;  ///< The parsed chunk.
+    size_t firstBucket;   ///< Index of the first bucket spanned by the chunk.
+    /// Extrema for each column of each bucket spanned, indexed by
+    /// <tt>(bucket - firstBucket) * columnCount + column</tt>.
+    std::vector<PreviewBucket> buckets;
+
+    inline ChunkPreview() : chunk(nullptr), firstBucket(0) {}
+  };
+
+
+  /// Reduce the lines of a parsed chunk to the extrema of each column over each preview bucket.
+  /// @param[in,out] preview Identifies the chunk to reduce, in which every line must have been
+  ///   parsed. The bucket extrema are set here.
+  /// @param layout The bucket layout.
+  /// @param columnCount The number of columns to preview.
+  /// @param stride The number of values parsed per line.
+  /// @param timeColumn The time column, one based. Zero to use the line number.
+  void reducePreview(ChunkPreview &preview, const PreviewLayout &layout, size_t columnCount,
+                     unsigned stride, unsigned timeColumn)
+  {
+    const PlotFileMap::ChunkData &chunk = *preview.chunk;
+    preview.buckets.clear();
+    if (chunk.itemCounts.empty())
+    {
+      return;
+    }
+
+    const size_t lastLine = chunk.firstLine + chunk.itemCounts.size() - 1;
+    preview.firstBucket = layout.bucketOf(chunk.firstLine);
+    preview.buckets.resize((layout.bucketOf(lastLine) - preview.firstBucket + 1) * columnCount);
+
+    const double *values = chunk.values.data();
+    size_t line = chunk.firstLine;
+    for (unsigned itemCount : chunk.itemCounts)
+    {
+      const size_t valueCount = std::min<size_t>(itemCount, stride);
+      const double time = (timeColumn > 0 && timeColumn <= valueCount) ? values[timeColumn - 1] : double(line + 1);
+      PreviewBucket *buckets = &preview.buckets[(layout.bucketOf(line) - preview.firstBucket) * columnCount];
+      const size_t indexLimit = std::min(valueCount, columnCount);
+      for (size_t i = 0; i < indexLimit; ++i)
+      {
+        const double value = (canDisplay(values[i])) ? values[i] : 0.0;
+        addPreviewSample(buckets[i], line, QPointF(time, value));
+      }
+
+      values += stride;
+      ++line;
+    }
+  }
+
+
+  /// Full resolution data for a curve, built on the loading thread to replace a preview.
+  struct StagedColumn
+  {
+    PlotInstanceData *data;           ///< The staged data. Ownership passes to the curve.
+    std::vector<double> batchValues;  ///< Values parsed in the current batch.
+    /// Times for the @c batchValues. Only used with @c ownTimes.
+    std::vector<double> batchTimes;
+    /// True once the curve has its own time array. Curves share a single time array
+    /// unless lines are missing values for the curve.
+    bool ownTimes;
+
+    inline StagedColumn() : data(nullptr), ownTimes(false) {}
+  };
+
+
+  /// Add a single line of data values to the @p staged columns.
+  /// @param staged The staged curve data.
+  /// @param sharedTimes The committed times shared by the @p staged columns.
+  /// @param batchTimes Times of the lines staged since the last commit. Appended to.
+  /// @param values The line data values.
+  /// @param valueCount The number of items in @p values.
+  /// @param time The resolved line time.
+  void stageDataLine(std::vector<StagedColumn> &staged, const std::vector<double> &sharedTimes,
+                     std::vector<double> &batchTimes, const double *values, size_t valueCount, double time)
+  {
+    batchTimes.push_back(time);
+    const size_t indexLimit = std::min(valueCount, staged.size());
+    for (size_t i = 0; i < staged.size(); ++i)
+    {
+      StagedColumn &column = staged[i];
+      if (i < indexLimit)
+      {
+        column.batchValues.push_back((canDisplay(values[i])) ? values[i] : 0.0);
+        if (column.ownTimes)
+        {
+          column.batchTimes.push_back(time);
+        }
+      }
+      else if (!column.ownTimes)
+      {
+        // Missing value on an irregular line. The curve can no longer share the time array.
+        column.data->times = std::make_shared<std::vector<double>>(sharedTimes);
+        column.batchTimes.assign(batchTimes.begin(), batchTimes.end() - 1);
+        column.ownTimes = true;
+      }
+    }
+  }
+
+
+  /// Commit the lines staged by @c stageDataLine() to the @p staged curve data, extending the
+  /// level of detail and bounds.
+  /// @param staged The staged curve data.
+  /// @param sharedTimes The times shared by the @p staged columns.
+  /// @param batchTimes Times of the lines staged since the last commit. Cleared.
+  void commitStaged(std::vector<StagedColumn> &staged, std::vector<double> &sharedTimes,
+                    std::vector<double> &batchTimes)
+  {
+    sharedTimes.insert(sharedTimes.end(), batchTimes.begin(), batchTimes.end());
+    batchTimes.clear();
+
+    for (StagedColumn &column : staged)
+    {
+      PlotInstanceData &d = *column.data;
+      const size_t oldSize = d.values.size();
+      const size_t addCount = column.batchValues.size();
+      if (column.ownTimes)
+      {
+        d.times->insert(d.times->end(), column.batchTimes.begin(), column.batchTimes.end());
+        column.batchTimes.clear();
+      }
+      d.values.append(column.batchValues.data(), addCount);
+      column.batchValues.clear();
+      d.lod.update(d.times->data(), d.values, d.values.size());
+      d.updateBounds(oldSize, addCount);
+    }
+  }
+
+
+  /// Add the points collected in @p columns to the matching curves of @p source,
+  /// then clear @p columns.
+  void addColumns(PlotSource &source, std::vector<std::vector<QPointF>> &columns)
+  {
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+      source.curve(unsigned(i))->addPoints(columns[i].data(), columns[i].size());
+      columns[i].clear();
+    }
+  }
+
+
+  /// Split a mapped file into chunks and count the data lines in each chunk.
+  ///
+  /// Chunks following the first empty line are dropped.
+  ///
+  /// @param map The mapped file.
+  /// @param dataStart Byte offset of the first data line.
+  /// @param[out] chunks The chunks with their line counts and first line numbers resolved.
+  /// @return The total number of data lines.
+  size_t countLines(const PlotFileMap &map, qint64 dataStart, QVector<PlotFileMap::ChunkData> &chunks)
+  {
+    QVector<PlotFileMap::Chunk> chunkRanges;
+    map.splitChunks(dataStart, MAPPED_CHUNK_SIZE, chunkRanges);
+
+    chunks.resize(chunkRanges.size());
+    for (int i = 0; i < chunkRanges.size(); ++i)
+    {
+      chunks[i].range = chunkRanges[i];
+    }
+    // Counting is cheap compared to parsing.
+    QtConcurrent::blockingMap(chunks, [&map](PlotFileMap::ChunkData &chunk) { map.countChunk(chunk); });
+
+    size_t lineCount = 0;
+    int chunkCount = 0;
+    for (; chunkCount < chunks.size(); ++chunkCount)
+    {
+      chunks[chunkCount].firstLine = lineCount;
+      lineCount += chunks[chunkCount].lineCount;
+      if (chunks[chunkCount].terminated)
+      {
+        // Empty line. No more data.
+        ++chunkCount;
+        break;
+      }
+    }
+
+    chunks.resize(chunkCount);
+    return lineCount;
+  }
+
+
+  /// Parse the chunks [@p batchStart, @p batchEnd) in parallel into @p batch.
+  /// See @c PlotFileMap::parseChunk().
+  void parseBatch(const PlotFileMap &map, const QVector<PlotFileMap::ChunkData> &chunks, int batchStart, int batchEnd,
+                  unsigned stride, unsigned sampleRate, size_t lastLine, QVector<PlotFileMap::ChunkData> &batch)
+  {
+    batch.resize(batchEnd - batchStart);
+    for (int i = batchStart; i < batchEnd; ++i)
+    {
+      PlotFileMap::ChunkData &chunk = batch[i - batchStart];
+      chunk.range = chunks[i].range;
+      chunk.lineCount = chunks[i].lineCount;
+      chunk.firstLine = chunks[i].firstLine;
+      chunk.terminated = chunks[i].terminated;
+    }
+
+    QtConcurrent::blockingMap(batch, [&map, stride, sampleRate, lastLine](PlotFileMap::ChunkData &chunk)
+    {
+      map.parseChunk(chunk, stride, sampleRate, lastLine);
+    });
+  }
 }
 
 
@@ -34,6 +348,8 @@ PlotFileLoader::PlotFileLoader(Curves *curves, const QStringList &plotFiles, QVe
   : PlotGenerator(curves)
   , _plotFiles(plotFiles)
   , _targetSampleCount(TARGET_SAMPLES)
+  , _loadMode(LoadMapped)
+  , _useCache(true)
   , _loadComplete(false)
 {
   if (timing)
@@ -169,11 +485,20 @@ size_t PlotFileLoader::loadFile(const QString &filePath, const QString &fileName
 
   emit itemName(fileName);
 
-  // Remember, calculateSampleRate(), fileSize() and generateHeadings()
-  // all reset the file position to the start. This is because
-  // seeking under MSC doesn't work in text mode (new lines are counted
+  if (_useCache)
+  {
+    PlotFileCache cache;
+    if (cache.open(filePath))
+    {
+      PlotSource::Ptr source = createCurves(filePath, cache.headings(), timing);
+      loadCached(cache, *source, fileNumber, totalFileCount, timing);
+      return finaliseCurves(*source);
+    }
+  }
+
+  // Remember, fileSize() and generateHeadings() both reset the file position to the start.
+  // This is because seeking under MSC doesn't work in text mode (new lines are counted
   // incorrectly due to /n vs. \r\n differences).
-  int sampleRate = calculateSampleRate(file);
   qint64 fileSize = file.fileSize();
   QStringList headings;
   if (!file.generateHeadings(headings))
@@ -181,101 +506,334 @@ size_t PlotFileLoader::loadFile(const QString &filePath, const QString &fileName
     return 0;
   }
 
-  size_t columnCount = headings.count();
-
-  // Create and add new plots for the curves we are loading.
-  PlotSource::Ptr source(new PlotSource(PlotSource::File, filePath, unsigned(columnCount)));
-
-  source->deriveName();
-  source->setTimeScale(timing.scale);
-  // Remember: 1 based index for time column.
-  source->setTimeColumn((timing.column <= columnCount) ? timing.column : 0);
-
-  emit beginNewCurves();
-  for (unsigned i = 0; !_abortFlag && i < columnCount; ++i)
+  if (_loadMode == LoadMapped)
   {
-    PlotInstance *c = new PlotInstance(source);
-    c->setName(headings[i].trimmed());  // Ensure new lines are also removed.
-    source->addCurve(c);
-    _curves->newCurve(c);
+    PlotFileMap map(filePath);
+    if (map.isOpen())
+    {
+      // generateHeadings() leaves the stream at the start of the file if there is no headings line.
+      const qint64 dataStart = map.dataStart(file.streamPos() != 0);
+      QVector<PlotFileMap::ChunkData> chunks;
+      const size_t lineCount = countLines(map, dataStart, chunks);
+      PlotSource::Ptr source = createCurves(filePath, headings, timing);
+
+      // Publish a preview of large files while the full resolution data are loaded.
+      const bool preview = _targetSampleCount > 0 && lineCount > _targetSampleCount;
+      PlotFileCache cache;
+      const bool writeCache = _useCache && fileSize >= CACHE_MIN_FILE_SIZE;
+      loadMapped(map, chunks, lineCount, *source, fileNumber, totalFileCount, timing,
+                 (writeCache) ? &cache : nullptr, preview);
+      return finaliseCurves(*source);
+    }
+    // else fall back to streaming.
   }
-  emit endNewCurves();
 
-  int pointIndex = 0;
+  // Create and add new plots for the curves we are loading.
+  PlotSource::Ptr source = createCurves(filePath, headings, timing);
+
+  std::vector<std::vector<QPointF>> columns(source->curveCount());
   qint64 progressIncrement = fileSize;
   progressIncrement = progressIncrement / ITEM_PROGESS_TICKS + !!(progressIncrement % ITEM_PROGESS_TICKS);
-  unsigned sample = 0;
-  double nextSample = 0;
+  size_t lineCount = 0;
   double time = 0;
   bool first = true;
   std::vector<double> dataLine;
   qint64 pos = file.filePos();
   while (file.readLine() && !_abortFlag)
   {
-    // May not sample every line, but make sure the first and last lines are sampled.
-    // The position vs. size test is attempting to estimate the end of file
-    // allowing for a trailing newline (or two).
     pos = file.filePos();
-    if (++sample >= nextSample || pos >= fileSize - 4)
+    file.dataLine(dataLine);
+
+    addDataLine(*source, columns, dataLine.data(), dataLine.size(), timing, time, first);
+
+    if (++lineCount % ITEM_PROGESS_TICKS == 0)
     {
-      nextSample += sampleRate;
-      file.dataLine(dataLine);
+      addColumns(*source, columns);
+      updateProgress(pos, progressIncrement, fileNumber, totalFileCount);
+    }
+  }
+
+  addColumns(*source, columns);
+
+  emit itemProgress(int(pos / progressIncrement));
+  emit overallProgress(fileNumber * OVERALL_PROGRESS_FILE_TICKS, totalFileCount * OVERALL_PROGRESS_FILE_TICKS);
+
+  return finaliseCurves(*source);
+}
+
+
+void PlotFileLoader::loadMapped(const PlotFileMap &map, const QVector<PlotFileMap::ChunkData> &chunks, size_t lineCount,
+                                PlotSource &source, int fileNumber, int totalFileCount, const TimeSampling &timing,
+                                PlotFileCache *cache, bool preview)
+{
+  const size_t columnCount = source.curveCount();
+  // Parse enough values to cover the time column, even if it exceeds the column count.
+  const unsigned stride = unsigned(std::max<size_t>(columnCount, timing.column));
+
+  qint64 progressIncrement = map.fileSize();
+  progressIncrement = progressIncrement / ITEM_PROGESS_TICKS + !!(progressIncrement % ITEM_PROGESS_TICKS);
+
+  // Start the cache now we know the line count.
+  QStringList headings;
+  for (unsigned i = 0; i < columnCount; ++i)
+  {
+    headings << source.curve(i)->name();
+  }
+
+  if (cache && !cache->create(source.fullName(), headings, lineCount))
+  {
+    cache = nullptr;
+  }
+
+  // Points added to the curves: the full resolution data, or the preview.
+  std::vector<std::vector<QPointF>> columns(columnCount);
+  // With a preview, the full resolution data are staged privately then swapped in. The curves
+  // share a single time array, and the level of detail and bounds are built as we go.
+  std::vector<StagedColumn> staged((preview) ? columnCount : 0u);
+  std::shared_ptr<std::vector<double>> sharedTimes;
+  std::vector<double> batchTimes;
+  if (preview)
+  {
+    sharedTimes = std::make_shared<std::vector<double>>();
+    sharedTimes->reserve(lineCount);
+    for (unsigned i = 0; i < columnCount; ++i)
+    {
+      // Keep times at full precision, as createCurves() does.
+      staged[i].data = new PlotInstanceData((i + 1 == source.timeColumn()) ? PlotSampleEncoding() : _sampleEncoding);
+      staged[i].data->times = sharedTimes;
+    }
+  }
+
+  const size_t lastLine = (lineCount) ? lineCount - 1 : 0;
 
-      size_t indexLimit = qMin(dataLine.size(), columnCount);
-      if (timing.column > 0 && timing.column <= dataLine.size())
+  // Preview bucket layout. Each bucket contributes its minimum and maximum values.
+  const size_t bucketCount = std::max<size_t>(1u, _targetSampleCount / 2);
+  PreviewLayout layout;
+  layout.bucketLines = std::max<size_t>(1u, (lineCount + bucketCount - 1) / bucketCount);
+  layout.lastLine = lastLine;
+  std::vector<PreviewBucket> buckets((preview) ? columnCount : 0u);
+  std::vector<ChunkPreview> previews;
+  size_t currentBucket = 0;
+
+  // Process a limited number of chunks at a time to bound the memory overhead of the
+  // parsed, but not yet migrated values.
+  const int batchSize = std::max(1, QThreadPool::globalInstance()->maxThreadCount() * MAPPED_CHUNKS_PER_THREAD);
+  QVector<PlotFileMap::ChunkData> batch;
+  batch.reserve(batchSize);
+
+  double time = 0;
+  bool first = true;
+  for (int batchStart = 0; batchStart < chunks.size() && !_abortFlag; batchStart += batchSize)
+  {
+    const int batchEnd = std::min(batchStart + batchSize, chunks.size());
+    parseBatch(map, chunks, batchStart, batchEnd, stride, 1, lastLine, batch);
+
+    if (preview)
+    {
+      // Reduce each parsed chunk to its bucket extrema in parallel.
+      previews.resize(batch.size());
+      for (int i = 0; i < batch.size(); ++i)
       {
-        time = dataLine[timing.column - 1];
+        previews[i].chunk = &batch[i];
       }
-      else
+      const unsigned timeColumn = timing.column;
+      QtConcurrent::blockingMap(previews, [&layout, columnCount, stride, timeColumn](ChunkPreview &chunkPreview)
       {
-        ++time;
+        reducePreview(chunkPreview, layout, columnCount, stride, timeColumn);
+      });
+
+      // Fold in file order. Buckets may span chunks.
+      for (const ChunkPreview &chunkPreview : previews)
+      {
+        const size_t spanned = (columnCount) ? chunkPreview.buckets.size() / columnCount : 0;
+        for (size_t b = 0; b < spanned; ++b)
+        {
+          const size_t bucketIndex = chunkPreview.firstBucket + b;
+          if (bucketIndex != currentBucket)
+          {
+            for (size_t i = 0; i < columnCount; ++i)
+            {
+              flushPreviewBucket(buckets[i], columns[i]);
+            }
+            currentBucket = bucketIndex;
+          }
+
+          for (size_t i = 0; i < columnCount; ++i)
+          {
+            mergePreviewBucket(buckets[i], chunkPreview.buckets[b * columnCount + i]);
+          }
+        }
       }
+    }
 
-      if (first)
+    // Migrate in file order.
+    for (const PlotFileMap::ChunkData &chunk : batch)
+    {
+      const double *values = chunk.values.data();
+      size_t line = chunk.firstLine;
+      for (unsigned itemCount : chunk.itemCounts)
       {
-        if (timing.column && (timing.flags & RelativeTime))
+        // Pass the time column even when it exceeds the column count. The curves are limited below.
+        const size_t valueCount = std::min<size_t>(itemCount, stride);
+        if (preview)
         {
-          source->setTimeBase(time);
+          resolveLineTime(source, values, valueCount, timing, time, first);
+          stageDataLine(staged, *sharedTimes, batchTimes, values, valueCount, time);
         }
         else
         {
-          source->setTimeBase(timing.base);
+          addDataLine(source, columns, values, valueCount, timing, time, first);
         }
-        first = false;
-      }
 
-      for (unsigned i = 0; i < indexLimit; ++i)
-      {
-        PlotInstance &c = *source->curve(i);
-        double value = dataLine[i];
-        // Unsuccessful conversion, NaN or infinite results in a zero value for better plotting
-        // and range handling.
-        value = (canDisplay(value)) ? value : 0.0;
-        c.addPoint(QPointF(time, value));
+        if (cache)
+        {
+          if (itemCount == columnCount)
+          {
+            for (unsigned i = 0; i < columnCount; ++i)
+            {
+              cache->writeColumn(i)[line] = values[i];
+            }
+          }
+          else
+          {
+            // Irregular line. Can't cache.
+            cache->close();
+            cache = nullptr;
+          }
+        }
+
+        values += stride;
+        ++line;
       }
+    }
+
+    if (preview)
+    {
+      commitStaged(staged, *sharedTimes, batchTimes);
+    }
+    addColumns(source, columns);
+
+    updateProgress(batch.last().range.end, progressIncrement, fileNumber, totalFileCount);
+  }
+
+  // The final preview bucket need not be flushed: the staged data replace the preview now.
+  for (unsigned i = 0; i < staged.size(); ++i)
+  {
+    if (!_abortFlag)
+    {
+      source.curve(i)->replaceData(staged[i].data);
+    }
+    else
+    {
+      delete staged[i].data;
+    }
+    staged[i].data = nullptr;
+  }
 
-      first = false;
+  if (cache && !_abortFlag)
+  {
+    cache->commit();
+  }
+
+  emit itemProgress(ITEM_PROGESS_TICKS);
+  emit overallProgress(fileNumber * OVERALL_PROGRESS_FILE_TICKS, totalFileCount * OVERALL_PROGRESS_FILE_TICKS);
+}
 
-      ++pointIndex;
-      if (pointIndex % ITEM_PROGESS_TICKS)
+
+void PlotFileLoader::loadCached(const PlotFileCache &cache, PlotSource &source, int fileNumber, int totalFileCount,
+                                const TimeSampling &timing)
+{
+  const unsigned columnCount = source.curveCount();
+  const quint64 rowCount = cache.rowCount();
+  const double *timeColumn = (timing.column > 0 && timing.column <= cache.columnCount()) ?
+                             cache.column(timing.column - 1) : nullptr;
+
+  if (rowCount)
+  {
+    // Resolve the time base as addDataLine() does for the first line.
+    const double firstTime = (timeColumn) ? timeColumn[0] : 1.0;
+    source.setTimeBase((timing.column && (timing.flags & RelativeTime)) ? firstTime : timing.base);
+  }
+
+  // Add points in blocks, one column at a time.
+  std::vector<double> times;
+  std::vector<QPointF> points;
+  double time = 0;
+  for (quint64 blockStart = 0; blockStart < rowCount && !_abortFlag; blockStart += CACHE_BLOCK_SIZE)
+  {
+    const quint64 blockEnd = std::min<quint64>(blockStart + CACHE_BLOCK_SIZE, rowCount);
+    times.clear();
+    for (quint64 row = blockStart; row < blockEnd; ++row)
+    {
+      time = (timeColumn) ? timeColumn[row] : time + 1.0;
+      times.push_back(time);
+    }
+
+    for (unsigned i = 0; i < columnCount; ++i)
+    {
+      const double *values = cache.column(i);
+      points.clear();
+      for (quint64 row = blockStart; row < blockEnd; ++row)
       {
-        emit itemProgress(int(pos / progressIncrement));
-        const int overallCurrent = (fileNumber - 1) * OVERALL_PROGRESS_FILE_TICKS + (pos / progressIncrement) / (ITEM_PROGESS_TICKS / OVERALL_PROGRESS_FILE_TICKS);
-        const int overallTotal = totalFileCount * OVERALL_PROGRESS_FILE_TICKS;
-        emit overallProgress(overallCurrent, overallTotal);
+        const double value = values[row];
+        points.push_back(QPointF(times[size_t(row - blockStart)], (canDisplay(value)) ? value : 0.0));
       }
+      source.curve(i)->addPoints(points.data(), points.size());
     }
+
+    const int progress = int(blockEnd * ITEM_PROGESS_TICKS / rowCount);
+    emit itemProgress(progress);
+    const int overallCurrent = (fileNumber - 1) * OVERALL_PROGRESS_FILE_TICKS + progress / (ITEM_PROGESS_TICKS / OVERALL_PROGRESS_FILE_TICKS);
+    emit overallProgress(overallCurrent, totalFileCount * OVERALL_PROGRESS_FILE_TICKS);
   }
 
-  emit itemProgress(int(pos / progressIncrement));
+  emit itemProgress(ITEM_PROGESS_TICKS);
   emit overallProgress(fileNumber * OVERALL_PROGRESS_FILE_TICKS, totalFileCount * OVERALL_PROGRESS_FILE_TICKS);
+}
+
+
+PlotSource::Ptr PlotFileLoader::createCurves(const QString &filePath, const QStringList &headings, const TimeSampling &timing)
+{
+  size_t columnCount = headings.count();
+
+  // Create and add new plots for the curves we are loading.
+  PlotSource::Ptr source(new PlotSource(PlotSource::File, filePath, unsigned(columnCount)));
+
+  source->deriveName();
+  source->setTimeScale(timing.scale);
+  // Remember: 1 based index for time column.
+  source->setTimeColumn((timing.column <= columnCount) ? timing.column : 0);
+  source->setSampleEncoding(_sampleEncoding);
+
+  emit beginNewCurves();
+  for (unsigned i = 0; !_abortFlag && i < columnCount; ++i)
+  {
+    PlotInstance *c = new PlotInstance(source);
+    if (i + 1 == source->timeColumn())
+    {
+      // Keep times at full precision.
+      c->setSampleEncoding(PlotSampleEncoding());
+    }
+    c->setName(headings[i].trimmed());  // Ensure new lines are also removed.
+    source->addCurve(c);
+    _curves->newCurve(c);
+  }
+  emit endNewCurves();
+
+  return source;
+}
+
+
+size_t PlotFileLoader::finaliseCurves(PlotSource &source)
+{
+  const unsigned columnCount = source.curveCount();
 
   // Done reading.
   if (!_abortFlag)
   {
     for (unsigned i = 0; i < columnCount; ++i)
     {
-      PlotInstance *c = source->curve(i);
+      PlotInstance *c = source.curve(i);
       _curves->completeLoading(c);
     }
 
@@ -284,37 +842,61 @@ size_t PlotFileLoader::loadFile(const QString &filePath, const QString &fileName
 
   for (unsigned i = 0; i < columnCount; ++i)
   {
-    PlotInstance *c = source->curve(i);
+    PlotInstance *c = source.curve(i);
     _curves->removeCurve(c);
   }
   return 0;
 }
 
 
-double PlotFileLoader::calculateSampleRate(PlotFile &file)
+void PlotFileLoader::addDataLine(PlotSource &source, std::vector<std::vector<QPointF>> &columns,
+                                 const double *values, size_t valueCount,
+                                 const TimeSampling &timing, double &time, bool &first)
 {
-  double rate = 1; // Every sample.
+  resolveLineTime(source, values, valueCount, timing, time, first);
 
-  file.streamSeek(0);
+  const size_t indexLimit = qMin<size_t>(valueCount, columns.size());
+  for (unsigned i = 0; i < indexLimit; ++i)
+  {
+    double value = values[i];
+    // Unsuccessful conversion, NaN or infinite results in a zero value for better plotting
+    // and range handling.
+    value = (canDisplay(value)) ? value : 0.0;
+    columns[i].push_back(QPointF(time, value));
+  }
+}
 
-  // Read two lines in case the first is headings.
-  // Use the line size to estimate the sample count.
-  file.readLine();
-  file.readLine();
-  QString line = file.currentLine();
-  qint64 fileSize = file.fileSize();
 
-  int lineLength = line.length();
-  if (lineLength && fileSize)
+void PlotFileLoader::resolveLineTime(PlotSource &source, const double *values, size_t valueCount,
+                                     const TimeSampling &timing, double &time, bool &first)
+{
+  if (timing.column > 0 && timing.column <= valueCount)
+  {
+    time = values[timing.column - 1];
+  }
+  else
   {
-    // Estimate file size.
-    qint64 estimatedElementCount = fileSize / lineLength;
+    ++time;
+  }
 
-    if (_targetSampleCount > 0 && estimatedElementCount > _targetSampleCount)
+  if (first)
+  {
+    if (timing.column && (timing.flags & RelativeTime))
+    {
+      source.setTimeBase(time);
+    }
+    else
     {
-      rate = double(estimatedElementCount) / _targetSampleCount;
+      source.setTimeBase(timing.base);
     }
+    first = false;
   }
+}
+
 
-  return rate;
+void PlotFileLoader::updateProgress(qint64 pos, qint64 progressIncrement, int fileNumber, int totalFileCount)
+{
+  emit itemProgress(int(pos / progressIncrement));
+  const int overallCurrent = (fileNumber - 1) * OVERALL_PROGRESS_FILE_TICKS + (pos / progressIncrement) / (ITEM_PROGESS_TICKS / OVERALL_PROGRESS_FILE_TICKS);
+  emit overallProgress(overallCurrent, totalFileCount * OVERALL_PROGRESS_FILE_TICKS);
 }
@@ -10,9 +10,17 @@
 
 #include "plotgenerator.h"
 
+#include "plotfilemap.h"
+#include "plotsource.h"
 #include "timesampling.h"
 
+#include <QPointF>
 #include <QStringList>
+#include <QVector>
+
+#include <vector>
+
+class PlotFileCache;
 
 /// @ingroup gen
 /// A plot generator which loads data from CSV style text files.
@@ -20,14 +28,19 @@
 /// Data loading is supported by the @c PlotFile class. See that class for more details
 /// of how data are loaded.
 ///
-/// The file loader may optionally down-sample the data file by skipping data lines.
-/// This is controlled by the @c targetSampleCount(). A crude estimate is made of the
-/// number of lines in the data file and lines are skipped to attempt to meet the target.
-/// The line count estimate is made by determining the length of the first data line and
-/// dividing the file by this value. All samples are loaded if the estimate does not
-/// exceed the target.
+/// Files are always loaded at full resolution, but large files are loaded progressively.
+/// The data lines of a @c LoadMapped file are first counted. When there are more lines
+/// than the @c targetSampleCount(), the curves show a reduced preview while the file loads.
+/// The preview divides the file into buckets of lines and adds the minimum and maximum
+/// value of each column in each bucket, keeping the first and last lines. The file is parsed
+/// once: each parsed chunk is reduced to its bucket extrema in parallel, so no spikes are
+/// lost, while the same values are staged at full resolution into private
+/// @c PlotInstanceData, with one time array shared by the curves of the file. The staged
+/// data are swapped into each @c PlotInstance without copying once the file is loaded
+/// (see @c PlotInstance::replaceData()), then the curves are completed.
 ///
-/// The first and last data lines are always preserved.
+/// A @c targetSampleCount() of zero disables the preview. Cached and @c LoadStream
+/// files are loaded without a preview.
 ///
 /// General usage is to construct the generator with the files to load,
 /// the @c start() the thread. Additional files may be queued using @c append(),
@@ -35,10 +48,29 @@
 ///
 /// Each file may optionally be given its own @c TimeSampling to set the time
 /// column, time scale and base time.
+///
+/// Files are loaded using @c LoadMapped by default. This memory maps each file
+/// (see @c PlotFileMap) and parses newline aligned chunks of the file in parallel
+/// using the global @c QThreadPool. Data values are then added to the curves in
+/// file order, yielding the same results as @c LoadStream. Files which cannot be
+/// mapped, or which use a 16 or 32-bit unicode encoding, fall back to @c LoadStream.
+///
+/// When @c useCache() is set, a @c PlotFileCache is written for files loaded at full
+/// resolution using @c LoadMapped. Subsequent loads of the same, unmodified file read
+/// the cache instead of parsing the file.
 class PlotFileLoader : public PlotGenerator
 {
   Q_OBJECT
 public:
+  /// Supported file loading modes.
+  enum LoadMode
+  {
+    /// Read the file line by line via @c PlotFile.
+    LoadStream,
+    /// Memory map the file and parse in parallel via @c PlotFileMap.
+    LoadMapped
+  };
+
   /// Creates a loader for the given file set.
   /// @param curves The @c Curves model to add curves to.
   /// @param plotFiles The list of files to load.
@@ -60,15 +92,40 @@ public:
   ///   has already completed loading.
   bool append(const QStringList &plotFiles, QVector<TimeSampling> *timing = nullptr);
 
-  /// Set the target maximum number of sample points in a curve. This limits the
-  /// number of loaded samples for large files.
-  /// @param target The target sample count.
+  /// Set the target number of sample points in a curve preview. Files with more
+  /// data lines are previewed before loading at full resolution.
+  /// @param target The target preview sample count. Zero to disable previews.
   inline void setTargetSampleCount(uint target) { _targetSampleCount = target; }
 
-  /// Access the target sample count.
-  /// @return The target number of samples per @c PlotInstance.
+  /// Access the target preview sample count.
+  /// @return The target number of preview samples per @c PlotInstance.
   inline uint targetSampleCount() const { return _targetSampleCount; }
 
+  /// Set the file loading mode. See @c LoadMode.
+  /// @param mode The mode to load files with.
+  inline void setLoadMode(LoadMode mode) { _loadMode = mode; }
+
+  /// Access the file loading mode.
+  /// @return The current @c LoadMode.
+  inline LoadMode loadMode() const { return _loadMode; }
+
+  /// Enable or disable reading and writing @c PlotFileCache files.
+  /// @param cache True to use caches.
+  inline void setUseCache(bool cache) { _useCache = cache; }
+
+  /// Are @c PlotFileCache files read and written?
+  /// @return True if using caches.
+  inline bool useCache() const { return _useCache; }
+
+  /// Set the value encoding for loaded curves. The time column is always stored at
+  /// full precision.
+  /// @param encoding The sample encoding.
+  inline void setSampleEncoding(const PlotSampleEncoding &encoding) { _sampleEncoding = encoding; }
+
+  /// Access the value encoding for loaded curves.
+  /// @return The sample encoding.
+  inline const PlotSampleEncoding &sampleEncoding() const { return _sampleEncoding; }
+
   /// True.
   /// @return true.
   virtual inline bool isFileLoad() const override { return true; }
@@ -79,6 +136,7 @@ protected:
 
 private:
   /// Load file data from @p filePath.
+  ///
   /// @param filePath The path to the file to load, directory and file name.
   /// @param fileName Just the file name part of the file path.
   /// @param fileNumber A progress value, indicating the number of this file
@@ -88,21 +146,90 @@ private:
   ///     if loading has been aborted.
   size_t loadFile(const QString &filePath, const QString &fileName, int fileNumber, int totalFileCount, const TimeSampling &timing);
 
-  /// Calculates an estimated sample rate for sub-sampling the file.
-  /// Supports @c targetSampleCount().
+  /// Load the data lines of a memory mapped file at full resolution, parsing in parallel.
+  ///
+  /// Supports @c loadFile() for @c LoadMapped.
   ///
-  /// The file position is reset to the start after calling because
-  /// if seek issues with MSC and text mode files (newline handling
-  /// throws the position).
+  /// @param map The mapped file.
+  /// @param chunks The file chunks with line counts resolved.
+  /// @param lineCount The total number of data lines in @p chunks.
+  /// @param source The source to populate. Curves must already be created.
+  /// @param fileNumber See @c loadFile().
+  /// @param totalFileCount See @c loadFile().
+  /// @param timing See @c loadFile().
+  /// @param cache Optional cache to write.
+  /// @param preview True to add a min/max preview to the curves while staging the full
+  ///   resolution data privately, replacing the preview once all data are loaded. False to
+  ///   add data to the curves as they are parsed. See class documentation.
+  void loadMapped(const PlotFileMap &map, const QVector<PlotFileMap::ChunkData> &chunks, size_t lineCount,
+                  PlotSource &source, int fileNumber, int totalFileCount, const TimeSampling &timing,
+                  PlotFileCache *cache, bool preview);
+
+  /// Load data from a valid @c PlotFileCache.
   ///
-  /// @return The number of lines per sample to record.
-  double calculateSampleRate(PlotFile &file);
+  /// @param cache The open cache.
+  /// @param source The source to populate. Curves must already be created.
+  /// @param fileNumber See @c loadFile().
+  /// @param totalFileCount See @c loadFile().
+  /// @param timing See @c loadFile().
+  void loadCached(const PlotFileCache &cache, PlotSource &source, int fileNumber, int totalFileCount,
+                  const TimeSampling &timing);
+
+  /// Create the @c PlotSource and @c PlotInstance objects for a data file.
+  /// @param filePath The data file path.
+  /// @param headings Headings for each column.
+  /// @param timing Time sampling for the file.
+  /// @return The new source.
+  PlotSource::Ptr createCurves(const QString &filePath, const QStringList &headings, const TimeSampling &timing);
+
+  /// Finalise loading curves for @p source, completing the curves, or removing them
+  /// on abort.
+  /// @param source The source to finalise.
+  /// @return The number of curves loaded (zero on abort).
+  size_t finaliseCurves(PlotSource &source);
+
+  /// Add a single line of data values to the @p columns for the curves of @p source.
+  ///
+  /// Resolves the sample time and time base, and filters values which cannot be displayed.
+  ///
+  /// @param source The source to add data to.
+  /// @param columns Points for each curve in @p source. Values are appended here.
+  /// @param values The line data values.
+  /// @param valueCount The number of items in @p values.
+  /// @param timing Time sampling for the file.
+  /// @param[in,out] time The current time value. Updated to the time of this line.
+  /// @param[in,out] first True for the first line. Cleared on return.
+  void addDataLine(PlotSource &source, std::vector<std::vector<QPointF>> &columns,
+                   const double *values, size_t valueCount,
+                   const TimeSampling &timing, double &time, bool &first);
+
+  /// Resolve the sample time for a single line of data values, and the time base for the
+  /// @p first line.
+  ///
+  /// @param source The source to set the time base for.
+  /// @param values The line data values.
+  /// @param valueCount The number of items in @p values.
+  /// @param timing Time sampling for the file.
+  /// @param[in,out] time The current time value. Updated to the time of this line.
+  /// @param[in,out] first True for the first line. Cleared on return.
+  void resolveLineTime(PlotSource &source, const double *values, size_t valueCount,
+                       const TimeSampling &timing, double &time, bool &first);
+
+  /// Emit progress for reaching byte @p pos of a file.
+  /// @param pos The current file position.
+  /// @param progressIncrement File bytes per item progress tick.
+  /// @param fileNumber See @c loadFile().
+  /// @param totalFileCount See @c loadFile().
+  void updateProgress(qint64 pos, qint64 progressIncrement, int fileNumber, int totalFileCount);
 
   QStringList _plotFiles; ///< List of files to load.
   /// @c TimeSampling details for each plot file. Contains one entry for each item in
   /// @c _plotFiles. Explicitly tracked to support late additions via @c append().
   QVector<TimeSampling> _plotTiming;
-  uint _targetSampleCount;  ///< Target samples per @c PlotInstance.
+  uint _targetSampleCount;  ///< Target preview samples per @c PlotInstance.
+  LoadMode _loadMode;       ///< File loading mode.
+  PlotSampleEncoding _sampleEncoding; ///< Value encoding for loaded curves.
+  bool _useCache;           ///< Read and write @c PlotFileCache files?
   bool _loadComplete;       ///< True when the loading loop has completed.
 };
 
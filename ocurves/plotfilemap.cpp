@@ -0,0 +1,363 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "plotfilemap.h"
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+  /// Exact powers of 10 which may be used for correctly rounded fast conversion.
+  const double ExactPowers10[] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+    1e21, 1e22
+  };
+  const int MaxExactPower10 = 22;
+  // Maximum significant digits for an exact double conversion (< 2^53).
+  const int MaxFastDigits = 15;
+
+  inline bool isDelimiter(char ch)
+  {
+    switch (ch)
+    {
+    case ' ':
+    case '\t':
+    case ',':
+    case '\n':
+    case '\r':
+      return true;
+    default:
+      break;
+    }
+    return false;
+  }
+
+
+  inline bool isDigit(char ch)
+  {
+    return ch >= '0' && ch <= '9';
+  }
+
+
+  /// Fast path conversion for @c PlotFileMap::toDouble().
+  /// @return True on success, false when the slow path is required.
+  bool fastToDouble(const char *begin, const char *end, double &value)
+  {
+    const char *ch = begin;
+    bool negative = false;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool haveDigits = false;
+
+    if (ch < end && (*ch == '-' || *ch == '+'))
+    {
+      negative = *ch == '-';
+      ++ch;
+    }
+
+    for (; ch < end && isDigit(*ch); ++ch)
+    {
+      haveDigits = true;
+      if (mantissa || *ch != '0')
+      {
+        if (++digits > MaxFastDigits)
+        {
+          return false;
+        }
+        mantissa = mantissa * 10 + (*ch - '0');
+      }
+    }
+
+    if (ch < end && *ch == '.')
+    {
+      ++ch;
+      for (; ch < end && isDigit(*ch); ++ch)
+      {
+        haveDigits = true;
+        if (mantissa || *ch != '0')
+        {
+          if (++digits > MaxFastDigits)
+          {
+            return false;
+          }
+          mantissa = mantissa * 10 + (*ch - '0');
+        }
+        --exponent;
+      }
+    }
+
+    if (!haveDigits)
+    {
+      return false;
+    }
+
+    if (ch < end && (*ch == 'e' || *ch == 'E'))
+    {
+      ++ch;
+      bool negativeExp = false;
+      if (ch < end && (*ch == '-' || *ch == '+'))
+      {
+        negativeExp = *ch == '-';
+        ++ch;
+      }
+
+      if (ch == end)
+      {
+        return false;
+      }
+
+      int exp = 0;
+      for (; ch < end && isDigit(*ch); ++ch)
+      {
+        // Large exponents will fail the range check below anyway.
+        if (exp < 1000)
+        {
+          exp = exp * 10 + (*ch - '0');
+        }
+      }
+      exponent += (negativeExp) ? -exp : exp;
+    }
+
+    if (ch != end)
+    {
+      // Unexpected characters.
+      return false;
+    }
+
+    if (mantissa == 0)
+    {
+      value = (negative) ? -0.0 : 0.0;
+      return true;
+    }
+
+    if (exponent < -MaxExactPower10 || exponent > MaxExactPower10)
+    {
+      return false;
+    }
+
+    value = double(mantissa);
+    value = (exponent < 0) ? value / ExactPowers10[-exponent] : value * ExactPowers10[exponent];
+    value = (negative) ? -value : value;
+    return true;
+  }
+
+
+  /// Find the end of the line starting at @p ch. Returns the address of the newline or @p end.
+  inline const char *findLineEnd(const char *ch, const char *end)
+  {
+    const char *newline = static_cast<const char *>(std::memchr(ch, '\n', size_t(end - ch)));
+    return (newline) ? newline : end;
+  }
+
+
+  /// Check if the line [@p begin, @p end) is empty, ignoring a carriage return.
+  inline bool emptyLine(const char *begin, const char *end)
+  {
+    return begin == end || (end - begin == 1 && *begin == '\r');
+  }
+}
+
+
+PlotFileMap::ChunkData::ChunkData()
+  : lineCount(0)
+  , firstLine(0)
+  , terminated(false)
+{
+  range.begin = range.end = 0;
+}
+
+
+PlotFileMap::PlotFileMap(const QString &fileName)
+  : _file(fileName)
+  , _data(nullptr)
+  , _size(0)
+  , _supported(false)
+{
+  if (_file.open(QIODevice::ReadOnly))
+  {
+    _size = _file.size();
+    if (_size > 0)
+    {
+      _data = reinterpret_cast<const char *>(_file.map(0, _size));
+    }
+  }
+
+  if (_data)
+  {
+    // Reject UTF-16/UTF-32 byte order marks.
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(_data);
+    _supported = !(_size >= 2 && ((bytes[0] == 0xFFu && bytes[1] == 0xFEu) || (bytes[0] == 0xFEu && bytes[1] == 0xFFu)));
+    _supported = _supported && !(_size >= 4 && bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0xFEu && bytes[3] == 0xFFu);
+  }
+}
+
+
+PlotFileMap::~PlotFileMap()
+{
+  if (_data)
+  {
+    _file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(_data)));
+  }
+}
+
+
+bool PlotFileMap::isOpen() const
+{
+  return _data && _supported;
+}
+
+
+qint64 PlotFileMap::dataStart(bool hasHeadings) const
+{
+  qint64 start = 0;
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(_data);
+
+  // Skip UTF-8 byte order mark.
+  if (_size >= 3 && bytes[0] == 0xEFu && bytes[1] == 0xBBu && bytes[2] == 0xBFu)
+  {
+    start = 3;
+  }
+
+  if (hasHeadings)
+  {
+    const char *end = _data + _size;
+    const char *lineEnd = findLineEnd(_data + start, end);
+    start = (lineEnd < end) ? lineEnd - _data + 1 : _size;
+  }
+
+  return start;
+}
+
+
+void PlotFileMap::splitChunks(qint64 from, qint64 chunkSize, QVector<Chunk> &chunks) const
+{
+  chunks.clear();
+  const char *end = _data + _size;
+  Chunk chunk;
+  chunk.begin = from;
+  while (chunk.begin < _size)
+  {
+    chunk.end = std::min(chunk.begin + chunkSize, _size);
+    if (chunk.end < _size)
+    {
+      // Align to the start of the next line.
+      const char *lineEnd = findLineEnd(_data + chunk.end - 1, end);
+      chunk.end = (lineEnd < end) ? lineEnd - _data + 1 : _size;
+    }
+    chunks.append(chunk);
+    chunk.begin = chunk.end;
+  }
+}
+
+
+void PlotFileMap::countChunk(ChunkData &chunk) const
+{
+  const char *ch = _data + chunk.range.begin;
+  const char *end = _data + chunk.range.end;
+  chunk.lineCount = 0;
+  chunk.terminated = false;
+  while (ch < end)
+  {
+    const char *lineEnd = findLineEnd(ch, end);
+    if (emptyLine(ch, lineEnd))
+    {
+      chunk.terminated = true;
+      return;
+    }
+    ++chunk.lineCount;
+    ch = lineEnd + 1;
+  }
+}
+
+
+void PlotFileMap::parseChunk(ChunkData &chunk, unsigned stride, unsigned sampleRate, size_t lastLine) const
+{
+  const char *ch = _data + chunk.range.begin;
+  const char *end = _data + chunk.range.end;
+
+  chunk.values.clear();
+  chunk.itemCounts.clear();
+
+  if (sampleRate <= 1)
+  {
+    chunk.values.reserve(chunk.lineCount * stride);
+    chunk.itemCounts.reserve(chunk.lineCount);
+  }
+
+  for (size_t i = 0; i < chunk.lineCount && ch < end; ++i)
+  {
+    const char *lineEnd = findLineEnd(ch, end);
+    const size_t line = chunk.firstLine + i;
+    if (line == lastLine || sampleLine(line, sampleRate))
+    {
+      const size_t offset = chunk.values.size();
+      chunk.values.resize(offset + stride, 0.0);
+      chunk.itemCounts.push_back(parseLine(ch, lineEnd, chunk.values.data() + offset, stride));
+    }
+    ch = lineEnd + 1;
+  }
+}
+
+
+unsigned PlotFileMap::parseLine(const char *begin, const char *end, double *values, unsigned maxValues)
+{
+  unsigned count = 0;
+  const char *ch = begin;
+  while (ch < end)
+  {
+    // Skip delimiters.
+    while (ch < end && isDelimiter(*ch))
+    {
+      ++ch;
+    }
+
+    if (ch == end)
+    {
+      break;
+    }
+
+    const char *item = ch;
+    while (ch < end && !isDelimiter(*ch))
+    {
+      ++ch;
+    }
+
+    if (count < maxValues)
+    {
+      values[count] = toDouble(item, ch);
+    }
+    ++count;
+  }
+
+  // Zero fill missing items.
+  for (unsigned i = count; i < maxValues; ++i)
+  {
+    values[i] = 0.0;
+  }
+
+  return count;
+}
+
+
+double PlotFileMap::toDouble(const char *begin, const char *end)
+{
+  double value = 0;
+  if (fastToDouble(begin, end, value))
+  {
+    return value;
+  }
+
+  // Slow path: exponents and long mantissas, NaN and infinity. Always uses the C locale.
+  bool ok = false;
+  value = QByteArray::fromRawData(begin, int(end - begin)).toDouble(&ok);
+  return (ok) ? value : 0.0;
+}
@@ -0,0 +1,155 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef PLOTFILEMAP_H_
+#define PLOTFILEMAP_H_
+
+#include "ocurvesconfig.h"
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include <vector>
+
+/// @ingroup gen
+/// A memory mapped view of a CSV style data file, supporting parallel parsing.
+///
+/// This is a companion to @c PlotFile, parsing the same data format, but working
+/// directly on the mapped bytes rather than decoding each line into a @c QString.
+/// The data section of the file may be split into newline aligned chunks using
+/// @c splitChunks() and each chunk parsed independently (and concurrently) by
+/// @c countChunk() and @c parseChunk().
+///
+/// Data lines are split using the same delimiters as @c PlotFile::dataLine() and
+/// values are always parsed using the C locale. Heading detection remains the
+/// responsibility of @c PlotFile::generateHeadings().
+///
+/// Only 8-bit encodings (ASCII, UTF-8 and Latin1) are supported. @c isOpen() fails
+/// for files with a UTF-16 or UTF-32 byte order mark. Such files must be loaded
+/// via @c PlotFile.
+class PlotFileMap
+{
+public:
+  /// Identifies a newline aligned byte range in the mapped file.
+  struct Chunk
+  {
+    qint64 begin;   ///< Offset of the first byte in the chunk. Always at the start of a line.
+    qint64 end;     ///< Offset one past the last byte. Just beyond a newline or at end of file.
+  };
+
+  /// Tracks parsing of a single @c Chunk.
+  struct ChunkData
+  {
+    Chunk range;                      ///< The bytes to parse.
+    /// The number of lines in the chunk, as set by @c countChunk(). Lines beyond an
+    /// empty line are excluded.
+    size_t lineCount;
+    /// Global line number of the first line in the chunk. Set by the caller between
+    /// @c countChunk() and @c parseChunk() and used to select lines to parse.
+    size_t firstLine;
+    bool terminated;                  ///< True if an empty line was encountered in the chunk.
+    /// Parsed values. Holds @c stride values for each parsed line.
+    std::vector<double> values;
+    /// The number of values parsed for each line. May be less than or exceed @c stride.
+    std::vector<unsigned> itemCounts;
+
+    /// Constructor.
+    ChunkData();
+  };
+
+  /// Opens and maps @p fileName.
+  /// @param fileName The file to map.
+  PlotFileMap(const QString &fileName);
+
+  /// Destructor, unmapping the file.
+  ~PlotFileMap();
+
+  /// Is the file open and mapped with a supported encoding?
+  /// @return True if the file is mapped and usable.
+  bool isOpen() const;
+
+  /// Returns the overall file size in bytes.
+  /// @return The file size in bytes.
+  inline qint64 fileSize() const { return _size; }
+
+  /// Determine the byte offset of the first data line.
+  ///
+  /// This skips any UTF-8 byte order mark and, when @p hasHeadings is set, the
+  /// first line of the file.
+  ///
+  /// @param hasHeadings True if the first line contains headings. This is the case
+  ///   when @c PlotFile::generateHeadings() did not rewind to the start of the file.
+  /// @return The byte offset of the first data line.
+  qint64 dataStart(bool hasHeadings) const;
+
+  /// Split the range [@p from, @c fileSize()) into chunks of approximately
+  /// @p chunkSize bytes. Each chunk boundary is moved forward to the start of the next line.
+  /// @param from The byte offset to start from. Must be at the start of a line.
+  /// @param chunkSize The target chunk size in bytes.
+  /// @param chunks Populated with the chunks. Existing content is cleared.
+  void splitChunks(qint64 from, qint64 chunkSize, QVector<Chunk> &chunks) const;
+
+  /// Count the lines in @p chunk, setting @c ChunkData::lineCount and
+  /// @c ChunkData::terminated. Thread safe.
+  ///
+  /// An empty line terminates the data, as it does for @c PlotFile::readLine().
+  ///
+  /// @param chunk The chunk to count lines in.
+  void countChunk(ChunkData &chunk) const;
+
+  /// Parse the data values from @p chunk. Thread safe.
+  ///
+  /// Only lines for which the global line number - @c ChunkData::firstLine plus the
+  /// local line index - satisfies the sampling rate are parsed. Line numbers are
+  /// zero based and line zero is always parsed as is every @p sampleRate line number
+  /// thereafter, less one. This matches the @c PlotFileLoader decimation. Every line
+  /// is parsed when @p sampleRate is 1. Additionally, @p lastLine is always parsed.
+  ///
+  /// @param chunk The chunk to parse. Must have been counted with @c countChunk().
+  /// @param stride The number of values to store for each line. Excess values are
+  ///   dropped, missing values zero filled.
+  /// @param sampleRate Parse every Nth line.
+  /// @param lastLine The global number of the final line to be parsed.
+  void parseChunk(ChunkData &chunk, unsigned stride, unsigned sampleRate, size_t lastLine) const;
+
+  /// Parse a single data line.
+  /// @param begin The first character of the line.
+  /// @param end The end of the line (exclusive).
+  /// @param values Array to parse into.
+  /// @param maxValues The capacity of @p values.
+  /// @return The number of items in the line. May exceed @p maxValues in which case
+  ///   the excess items are skipped.
+  static unsigned parseLine(const char *begin, const char *end, double *values, unsigned maxValues);
+
+  /// Convert the text in [@p begin, @p end) to a double value, as does
+  /// @c QLocale::toDouble() for the C locale.
+  ///
+  /// A fast path handles the common case of decimal values with up to 15 significant
+  /// digits and small exponents, where the result is exact. Other values are converted
+  /// by Qt's correctly rounded conversion.
+  ///
+  /// @param begin The first character to convert.
+  /// @param end The end of the string (exclusive).
+  /// @return The converted value, or zero on failure.
+  static double toDouble(const char *begin, const char *end);
+
+  /// Is line number @p line to be sampled at the given @p sampleRate?
+  /// @param line The zero based line number.
+  /// @param sampleRate The line sampling rate.
+  /// @return True if the line is to be sampled.
+  static inline bool sampleLine(size_t line, unsigned sampleRate)
+  {
+    return sampleRate <= 1 || line == 0 || (line + 1) % sampleRate == 0;
+  }
+
+private:
+  QFile _file;          ///< The file object.
+  const char *_data;    ///< Mapped file data.
+  qint64 _size;         ///< Size of the mapped region.
+  bool _supported;      ///< False if the encoding is not supported.
+};
+
+#endif // PLOTFILEMAP_H_
@@ -13,7 +13,9 @@
 enum QwtRttiExt
 {
   /// @c PlotDataCurve type.
-  Rtti_PlotDataCurve = QwtPlotItem::Rtti_PlotUserItem
+  Rtti_PlotDataCurve = QwtPlotItem::Rtti_PlotUserItem,
+  /// @c PlotRasterItem type.
+  Rtti_PlotRasterItem
 };
 
 #endif // QWTRTTIEXT_H_
@@ -0,0 +1,383 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "realtimeexpressions.h"
+
+#include "expr/plotbindingtracker.h"
+#include "expr/plotexpression.h"
+#include "expr/plotexpressionprogram.h"
+#include "plotinstance.h"
+#include "plotinstancesampler.h"
+
+#include "model/curves.h"
+
+#include <QTimer>
+
+#include <algorithm>
+
+/// The number of samples evaluated in each call to @c PlotExpressionProgram::sampleBlock().
+#define STREAM_BLOCK_SIZE 1024u
+
+struct RealTimeExpressions::Binding
+{
+  const PlotExpression *original;     ///< The original expression.
+  PlotExpression *expression;         ///< Bound copy of the expression. Retains function state.
+  PlotExpressionProgram program;      ///< Compiled from @c expression.
+  QList<PlotInstance *> inputs;       ///< The curves bound by @c expression.
+  PlotInstanceSampler driver;         ///< Samples the real-time curve driving evaluation.
+  PlotInstance *output;               ///< The generated curve.
+  /// The driver's @c PlotInstance::appendedCount() when last evaluated.
+  std::uint64_t evaluatedCount;
+
+  /// Constructor.
+  /// @param original The original expression.
+  /// @param expression The bound copy of @p original. Takes ownership.
+  /// @param driver The real-time curve driving evaluation.
+  inline Binding(const PlotExpression *original, PlotExpression *expression, const PlotInstance *driver)
+    : original(original)
+    , expression(expression)
+    , driver(driver)
+    , output(nullptr)
+    , evaluatedCount(driver->appendedCount() - driver->sampleCount())
+  {
+    program.compile(expression);
+  }
+
+  /// Destructor. Releases the expression.
+  inline ~Binding()
+  {
+    program.clear();
+    expression->unbind();
+    delete expression;
+  }
+};
+
+
+namespace
+{
+  /// Check for a curve named @p name in @p source.
+  /// @param curves The curves model to search.
+  /// @param source The source to match.
+  /// @param name The curve name to match.
+  /// @return True if a matching curve exists.
+  bool curveExists(const Curves &curves, const PlotSource &source, const QString &name)
+  {
+    for (const PlotInstance *curve : curves.curves())
+    {
+      if (&curve->source() == &source && curve->name() == name)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+
+RealTimeExpressions::RealTimeExpressions(Curves *curves, QObject *parent)
+  : QObject(parent)
+  , _curves(curves)
+  , _blockTimes(STREAM_BLOCK_SIZE)
+  , _blockValues(STREAM_BLOCK_SIZE)
+  , _blockPoints(STREAM_BLOCK_SIZE)
+  , _bindingsDirty(false)
+  , _addingOutput(false)
+{
+  connect(_curves, &Curves::realTimeDataMigrated, this, &RealTimeExpressions::update);
+  connect(_curves, &Curves::curveAdded, this, &RealTimeExpressions::curveAdded);
+  connect(_curves, &Curves::curveComplete, this, &RealTimeExpressions::curveComplete);
+  connect(_curves, &Curves::curveRemoved, this, &RealTimeExpressions::curveRemoved);
+  connect(_curves, &Curves::curvesCleared, this, &RealTimeExpressions::curvesCleared);
+}
+
+
+RealTimeExpressions::~RealTimeExpressions()
+{
+  qDeleteAll(_bindings);
+}
+
+
+void RealTimeExpressions::addExpression(const PlotExpression *expression)
+{
+  if (expression && !_expressions.contains(expression))
+  {
+    _expressions.append(expression);
+    _bindingsDirty = true;
+  }
+}
+
+
+void RealTimeExpressions::removeExpression(const PlotExpression *expression)
+{
+  _expressions.removeAll(expression);
+
+  QList<const PlotInstance *> outputs;
+  for (const Binding *binding : _bindings)
+  {
+    if (binding->original == expression)
+    {
+      outputs.append(binding->output);
+    }
+  }
+
+  // The bindings are released by curveRemoved().
+  for (const PlotInstance *output : outputs)
+  {
+    _curves->removeCurve(output);
+  }
+}
+
+
+void RealTimeExpressions::update()
+{
+  if (_bindingsDirty)
+  {
+    _bindingsDirty = false;
+    bindAll();
+  }
+
+  for (Binding *binding : _bindings)
+  {
+    // Migrate even without new results to flush samples deferred while the output was drawn.
+    evaluate(*binding);
+    if (binding->output->migrateBuffer())
+    {
+      _curves->invalidate(binding->output);
+    }
+  }
+}
+
+
+void RealTimeExpressions::curveAdded(PlotInstance *)
+{
+  if (!_addingOutput)
+  {
+    _bindingsDirty = true;
+  }
+}
+
+
+void RealTimeExpressions::curveComplete(PlotInstance *curve)
+{
+  for (int i = _bindings.count() - 1; i >= 0; --i)
+  {
+    if (_bindings[i]->inputs.contains(curve))
+    {
+      endBinding(i);
+    }
+  }
+}
+
+
+void RealTimeExpressions::curveRemoved(const PlotInstance *curve)
+{
+  // Only compare the pointer. The curve may already be deleted.
+  PlotInstance *removed = const_cast<PlotInstance *>(curve);
+  _endedOutputs.removeAll(removed);
+  for (int i = _bindings.count() - 1; i >= 0; --i)
+  {
+    Binding *binding = _bindings[i];
+    if (binding->output == removed)
+    {
+      // Rebind if the expression remains, such as when regenerating expressions.
+      _bindingsDirty = _bindingsDirty || _expressions.contains(binding->original);
+      _bindings.removeAt(i);
+      delete binding;
+    }
+    else if (binding->inputs.contains(removed))
+    {
+      endBinding(i);
+    }
+  }
+}
+
+
+void RealTimeExpressions::curvesCleared()
+{
+  qDeleteAll(_bindings);
+  _bindings.clear();
+  _endedOutputs.clear();
+}
+
+
+void RealTimeExpressions::completeEnded()
+{
+  const QList<PlotInstance *> outputs = _endedOutputs;
+  _endedOutputs.clear();
+  for (PlotInstance *output : outputs)
+  {
+    _curves->completeLoading(output);
+  }
+}
+
+
+void RealTimeExpressions::bindAll()
+{
+  if (_expressions.empty())
+  {
+    return;
+  }
+
+  // Bind to any curves, but only real-time curves may drive a binding. Exclude generated
+  // curves so expressions cannot bind their own output.
+  QList<PlotInstance *> curves = _curves->curves().list();
+  QList<PlotInstance *> realTimeCurves = _curves->realTimeCurves().list();
+  auto generated = [this] (const PlotInstance *curve) { return isOutput(curve); };
+  curves.erase(std::remove_if(curves.begin(), curves.end(), generated), curves.end());
+  realTimeCurves.erase(std::remove_if(realTimeCurves.begin(), realTimeCurves.end(), generated),
+                       realTimeCurves.end());
+
+  if (realTimeCurves.empty())
+  {
+    return;
+  }
+
+  for (const PlotExpression *expression : _expressions)
+  {
+    bind(expression, curves, realTimeCurves);
+  }
+}
+
+
+void RealTimeExpressions::bind(const PlotExpression *expression, const QList<PlotInstance *> &curves,
+                               const QList<PlotInstance *> &realTimeCurves)
+{
+  // Enumerate the bindings using a copy, leaving the original expression unbound.
+  PlotExpression *exp = expression->clone();
+  PlotExpressionBindDomain domain;
+  PlotBindingTracker bindTracker;
+  BindResult bindResult = exp->bind(curves, bindTracker, domain);
+  while (bindResult > 0)
+  {
+    // Bind a copy of the current binding. This identifies the curves for this binding alone
+    // and the copy is retained for evaluation.
+    PlotExpression *bound = exp->clone();
+    PlotBindingTracker retainTracker(true);
+    PlotExpressionBindDomain retainDomain;
+    PlotInstance *driver = nullptr;
+    // Explicit time expressions, such as spectra, define their own domain rather than
+    // following the driving curve.
+    if (bound->bind(curves, retainTracker, retainDomain) > 0 && !bound->explicitTime())
+    {
+      for (PlotInstance *curve : retainTracker.boundPlots())
+      {
+        if (realTimeCurves.contains(curve))
+        {
+          driver = curve;
+          break;
+        }
+      }
+    }
+
+    const QString name = exp->toString();
+    if (driver && !curveExists(*_curves, driver->source(), name))
+    {
+      Binding *binding = new Binding(expression, bound, driver);
+      binding->inputs = retainTracker.boundPlots();
+
+      PlotInstance *output = new PlotInstance(&driver->source());
+      output->setName(name);
+      output->setExpression(expression);
+      output->setExplicitTime(true);
+      // Derived values may not suit a reduced precision encoding of the source.
+      output->setSampleEncoding(PlotSampleEncoding());
+      output->makeRingBuffer(std::max<size_t>(driver->values().capacity(), 1u));
+      binding->output = output;
+      _bindings.append(binding);
+
+      _addingOutput = true;
+      _curves->newCurve(output);
+      _addingOutput = false;
+
+      QList<const PlotInstance *> inputs;
+      for (const PlotInstance *input : binding->inputs)
+      {
+        inputs.append(input);
+      }
+      _curves->setDependencies(output, inputs);
+    }
+    else
+    {
+      bound->unbind();
+      delete bound;
+    }
+
+    exp->unbind();
+    if (bindResult == BoundMaybeMore)
+    {
+      bindTracker.clearFirstPlot();
+      bindResult = exp->bind(curves, bindTracker, domain);
+    }
+    else
+    {
+      bindResult = BindFailure;
+    }
+  }
+
+  delete exp;
+}
+
+
+bool RealTimeExpressions::evaluate(Binding &binding)
+{
+  const PlotInstanceSampler &driver = binding.driver;
+  const PlotInstance &driverCurve = *driver.curve();
+  const size_t count = driver.size();
+
+  // The new samples are those appended since the last evaluation, which are the most recent
+  // samples. Identifying them by count rather than time keeps samples which share, or
+  // precede, the last evaluated time. Any evicted from the ring buffer are skipped.
+  const std::uint64_t appended = driverCurve.appendedCount();
+  const std::uint64_t newCount = std::min<std::uint64_t>(appended - binding.evaluatedCount, count);
+  binding.evaluatedCount = appended;
+  if (!newCount)
+  {
+    return false;
+  }
+
+  const size_t first = count - size_t(newCount);
+
+  for (size_t blockStart = first; blockStart < count; blockStart += STREAM_BLOCK_SIZE)
+  {
+    const size_t blockSize = std::min<size_t>(STREAM_BLOCK_SIZE, count - blockStart);
+    for (size_t j = 0; j < blockSize; ++j)
+    {
+      _blockTimes[j] = driver.sample(blockStart + j).x();
+    }
+
+    binding.program.sampleBlock(_blockTimes.data(), _blockValues.data(), blockSize);
+
+    for (size_t j = 0; j < blockSize; ++j)
+    {
+      _blockPoints[j] = QPointF(_blockTimes[j], _blockValues[j]);
+    }
+    binding.output->addPoints(_blockPoints.data(), blockSize);
+  }
+
+  return true;
+}
+
+
+void RealTimeExpressions::endBinding(int index)
+{
+  Binding *binding = _bindings.takeAt(index);
+  _endedOutputs.append(binding->output);
+  delete binding;
+  // Complete on a later event as the curves model may be locked while signalling.
+  QTimer::singleShot(0, this, SLOT(completeEnded()));
+}
+
+
+bool RealTimeExpressions::isOutput(const PlotInstance *curve) const
+{
+  for (const Binding *binding : _bindings)
+  {
+    if (binding->output == curve)
+    {
+      return true;
+    }
+  }
+  return _endedOutputs.contains(const_cast<PlotInstance *>(curve));
+}
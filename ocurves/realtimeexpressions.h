@@ -0,0 +1,137 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef REALTIMEEXPRESSIONS_H_
+#define REALTIMEEXPRESSIONS_H_
+
+#include "ocurvesconfig.h"
+
+#include <QList>
+#include <QObject>
+#include <QPointF>
+
+#include <vector>
+
+class Curves;
+class PlotExpression;
+class PlotInstance;
+
+/// @ingroup realtime
+/// Incrementally evaluates @c PlotExpression objects over real-time curves.
+///
+/// Real-time curves are continually updated, so a one-off evaluation by the
+/// @c PlotExpressionGenerator is immediately out of date. Instead, this class evaluates
+/// expressions bound to real-time curves as new samples are migrated, appending only the
+/// new results.
+///
+/// Each binding of an expression is driven by the first real-time curve it binds. The
+/// expression is sampled at the time of each new sample in the driving curve, with any other
+/// curves interpolated at these times as for any other expression. Results are written to a
+/// ring buffer curve with the same capacity as the driving curve, and from the same source.
+///
+/// Each binding retains its own bound copy of the expression and the compiled
+/// @c PlotExpressionProgram across updates. Stateful functions, such as moving averages,
+/// thus carry their state from one update to the next. The cost of an update is
+/// proportional to the number of new samples rather than the length of the history.
+///
+/// Updates are driven by @c Curves::realTimeDataMigrated(). Bindings are resolved on the
+/// next update after expressions or curves are added. A new binding first evaluates the
+/// existing history of the driving curve. New driving samples are identified by
+/// @c PlotInstance::appendedCount(), so samples sharing or preceding the last evaluated
+/// time are still evaluated.
+///
+/// Expressions with explicit time, such as slices and spectra, are not bound as they do
+/// not follow the sample times of the driving curve.
+///
+/// A binding ends when any of the curves it references completes or is removed. Its output
+/// curve is then completed, retaining the generated data.
+///
+/// Main thread only.
+class RealTimeExpressions : public QObject
+{
+  Q_OBJECT
+public:
+  /// Constructor.
+  /// @param curves The curves model to bind to and to add generated curves to.
+  /// @param parent The owning object.
+  RealTimeExpressions(Curves *curves, QObject *parent = nullptr);
+
+  /// Destructor. Generated curves remain in the @c Curves model.
+  ~RealTimeExpressions();
+
+  /// Adds an expression to evaluate over real-time curves.
+  ///
+  /// The expression is bound on the next @c update(). The caller retains ownership and
+  /// @p expression must remain valid until removed.
+  /// @param expression The expression to add.
+  void addExpression(const PlotExpression *expression);
+
+  /// Stops evaluating @p expression and removes the curves it has generated.
+  /// @param expression The expression to remove.
+  void removeExpression(const PlotExpression *expression);
+
+public slots:
+  /// Resolves any new bindings, then evaluates the new samples for all bindings.
+  void update();
+
+private slots:
+  /// Flags new bindings may be available.
+  /// @param curve The added curve.
+  void curveAdded(PlotInstance *curve);
+
+  /// Ends the bindings referencing @p curve.
+  /// @param curve The completed curve.
+  void curveComplete(PlotInstance *curve);
+
+  /// Releases the bindings referencing or generating @p curve.
+  /// @param curve The removed curve. May no longer be valid.
+  void curveRemoved(const PlotInstance *curve);
+
+  /// Releases all bindings.
+  void curvesCleared();
+
+  /// Completes the output curves for ended bindings.
+  void completeEnded();
+
+private:
+  /// A bound expression and its output curve. Implementation detail.
+  struct Binding;
+
+  /// Binds all expressions, adding new bindings.
+  void bindAll();
+
+  /// Adds the new bindings of @p expression.
+  /// @param expression The expression to bind.
+  /// @param curves The curves to bind to.
+  /// @param realTimeCurves The real-time curves from @p curves which may drive a binding.
+  void bind(const PlotExpression *expression, const QList<PlotInstance *> &curves,
+            const QList<PlotInstance *> &realTimeCurves);
+
+  /// Evaluates the new samples for @p binding, adding results to its output curve.
+  /// @param binding The binding to evaluate.
+  /// @return True if any samples have been added.
+  bool evaluate(Binding &binding);
+
+  /// Ends the binding at @p index. The output curve is completed on a later event.
+  /// @param index The index of the binding in @c _bindings.
+  void endBinding(int index);
+
+  /// Checks if @p curve has been generated by a binding.
+  /// @param curve The curve to check.
+  /// @return True if @p curve is an output curve.
+  bool isOutput(const PlotInstance *curve) const;
+
+  Curves *_curves;                          ///< Curves model.
+  QList<const PlotExpression *> _expressions; ///< Expressions to evaluate.
+  QList<Binding *> _bindings;               ///< Active bindings.
+  QList<PlotInstance *> _endedOutputs;      ///< Outputs of ended bindings awaiting completion.
+  std::vector<double> _blockTimes;          ///< Sample times for evaluating a block.
+  std::vector<double> _blockValues;         ///< Sample values for evaluating a block.
+  std::vector<QPointF> _blockPoints;        ///< Samples for adding a block.
+  bool _bindingsDirty;                      ///< True if new bindings may be available.
+  bool _addingOutput;                       ///< True while adding an output curve.
+};
+
+#endif // REALTIMEEXPRESSIONS_H_
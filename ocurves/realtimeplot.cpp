@@ -13,21 +13,54 @@
 #include "rt/realtimeconnection.h"
 #include "rt/realtimesourceloader.h"
 #include "rt/rtmessage.h"
+#include "rt/rtsamplequeue.h"
 
 #include <QDateTime>
 #include <QHash>
 #include <QMutex>
 #include <QRegExp>
 
+#include <algorithm>
+
+
+class RealTimePlot::SourceReader : public QThread
+{
+public:
+  SourceReader(RealTimePlot &plot, RealTimePlotInfo &rtplot)
+    : _plot(plot)
+    , _rtplot(rtplot)
+  {
+  }
+
+protected:
+  void run() override
+  {
+    _plot.readSource(_rtplot);
+  }
+
+private:
+  RealTimePlot &_plot;
+  RealTimePlotInfo &_rtplot;
+};
+
 
 RealTimePlot::RealTimePlotInfo::RealTimePlotInfo()
-  : spec(nullptr)
+  : startTime(0)
+  , spec(nullptr)
+  , readBuffer(MAX_READ_BUFFER_SIZE)
+  , queue(nullptr)
+  , reader(nullptr)
+  , samplesDropped(0)
+  , clockOffset(0)
+  , jitter(0)
 {
 }
 
 
 RealTimePlot::RealTimePlotInfo::~RealTimePlotInfo()
 {
+  delete reader;
+  delete queue;
   delete spec;
 }
 
@@ -80,112 +113,201 @@ void RealTimePlot::stop()
 }
 
 
+void RealTimePlot::sourceStats(QVector<SourceStats> &stats) const
+{
+  QMutexLocker guard(_dataMutex);
+  stats.clear();
+  for (const RealTimePlotInfo *rtplot : _sources)
+  {
+    QMutexLocker statsGuard(&rtplot->statsMutex);
+    if (!rtplot->name.isEmpty())
+    {
+      stats.append({ rtplot->name, rtplot->stats, rtplot->samplesDropped, rtplot->clockOffset, rtplot->jitter });
+    }
+  }
+}
+
+
 void RealTimePlot::run()
 {
   QMutexLocker guard(_dataMutex);
   guard.unlock();
 
+  QElapsedTimer clock;
   qint64 startTime = QDateTime::currentMSecsSinceEpoch();
+  clock.start();
 
-  loadSpecs(startTime);
+  loadSpecs(startTime, clock);
 
-  while (!_abortFlag)
+  bool running = true;
+  while (running)
   {
-    std::vector<double> sampleLine;
+    running = !_abortFlag;
     guard.relock();
 
-    if (_stopRequested)
+    // Retire sources which have disconnected, or all sources when stopping. Readers do
+    // not use the lock, so we can safely wait on them here.
+    const bool stopAll = _stopRequested || !running;
+    for (auto iter = _sources.begin(); iter != _sources.end();)
     {
-      for (auto iter = _sources.begin(); iter != _sources.end();)
+      RealTimePlotInfo *rtplot = *iter;
+      if (stopAll)
       {
-        RealTimePlotInfo *rtplot = *iter;
-        rtplot->spec->disconnect();
-        for (unsigned i = 0; i < rtplot->source->curveCount(); ++i)
-        {
-          if (PlotInstance *plot = rtplot->source->curve(i))
-          {
-            _curves->completeLoading(plot);
-          }
-        }
+        rtplot->reader->requestInterruption();
+      }
+
+      if (stopAll || rtplot->reader->isFinished())
+      {
+        rtplot->reader->wait();
+        finishSource(*rtplot);
         iter = _sources.erase(iter);
         delete rtplot;
       }
-      _sources.clear();
-      _stopRequested = false;
+      else
+      {
+        ++iter;
+      }
     }
+    _stopRequested = false;
+    guard.unlock();
 
-    for (auto iter = _sources.begin(); iter != _sources.end();)
+    if (running)
     {
-      RealTimePlotInfo *rtplot = *iter;
+      msleep(READ_WAIT_MS);
+    }
+  }
+}
 
-      if (rtplot->spec->connection()->isConnected())
-      {
-        // Try get new samples.
-        rtplot->spec->connection()->read(rtplot->readBuffer);
-        RTMessage *msg = rtplot->spec->incomingMessage();
 
-        int bytesRead = 0;
-        while ((bytesRead = msg->readMessage(rtplot->readBuffer)) > 0)
+void RealTimePlot::readSource(RealTimePlotInfo &rtplot)
+{
+  // Load here so the connection is opened on the thread which reads it.
+  if (!loadCommFile(rtplot))
+  {
+    return;
+  }
+
+  RealTimeConnection *connection = rtplot.spec->connection();
+  RTMessage *msg = rtplot.spec->incomingMessage();
+  QThread *thread = QThread::currentThread();
+  const unsigned timeColumn = (rtplot.spec->timeSource() == RealTimeCommSpec::SenderTime) ? rtplot.spec->timeColumn() : 0u;
+  const double timeScale = rtplot.spec->timeScale();
+  // Undecoded data are only discarded once they exceed the largest message the connection can deliver.
+  const size_t discardSize = std::max(size_t(MAX_READ_BUFFER_SIZE), connection->maxMessageSize());
+  // Messages with a fixed value count decode straight into the sample queue.
+  const unsigned directCount = msg->valueCount();
+  std::vector<double> sampleLine(directCount);
+  double senderTime = 0;
+
+  // Timestamp data as each chunk is read, such as each datagram.
+  rtplot.readBuffer.setClock(&rtplot.clock);
+  while (!thread->isInterruptionRequested() && connection->isConnected())
+  {
+    // Try get new samples.
+    const bool haveData = connection->read(rtplot.readBuffer) > 0;
+
+    int bytesRead = 0;
+    for (;;)
+    {
+      // Each message takes the receive time of the chunk it starts in.
+      const double receiveTime = rtplot.readBuffer.receiveTime();
+      const double *values = sampleLine.data();
+      unsigned sampleCount = 0;
+      bool reserved = false;
+      if (directCount)
+      {
+        // Decode into the next queue row when there is one. Otherwise decode into the sample
+        // line, either to create the plots or to record a dropped row.
+        double *row = (rtplot.queue && rtplot.queue->columnCount() >= directCount) ? rtplot.queue->reserveRow() : nullptr;
+        reserved = row != nullptr;
+        double *target = (reserved) ? row : sampleLine.data();
+        bytesRead = msg->readValues(rtplot.readBuffer.data(), rtplot.readBuffer.size(), target);
+        values = target;
+        sampleCount = directCount;
+      }
+      else
+      {
+        bytesRead = msg->readMessage(rtplot.readBuffer.data(), rtplot.readBuffer.size());
+        if (bytesRead > 0)
         {
-          // Trim the buffer of the processed data
-          rtplot->readBuffer = rtplot->readBuffer.right(rtplot->readBuffer.size() - bytesRead);
-
-          unsigned sampleCount = msg->populateValues(sampleLine);
-
-          // Do we need to create plots based on the first data sample?
-          if (rtplot->source->curveCount() == 0)
-          {
-            // Create plots.
-            if (!msg->headings().empty())
-            {
-              createPlots(*rtplot, msg->headings());
-            }
-            else
-            {
-              createPlots(*rtplot, sampleCount);
-            }
-          }
-
-          double time = 1e-3 * (QDateTime::currentMSecsSinceEpoch() - startTime);
-          unsigned limit = std::min<unsigned>(rtplot->source->curveCount(), sampleCount);
-          for (unsigned i = 0; i < limit; ++i)
-          {
-            if (PlotInstance *plot = rtplot->source->curve(i))
-            {
-              plot->addPoint(QPointF(time, sampleLine[i]));
-            }
-          }
+          sampleCount = msg->populateValues(sampleLine);
+          values = sampleLine.data();
         }
+      }
 
-        // Clear the buffer on error, or if too large without reading any data.
-        if (bytesRead < 0 || rtplot->readBuffer.size() >= MAX_READ_BUFFER_SIZE)
+      if (bytesRead <= 0)
+      {
+        break;
+      }
+
+      // Consume the processed data. This only advances the read cursor.
+      rtplot.readBuffer.consume(size_t(bytesRead));
+
+      // Do we need to create plots based on the first data sample?
+      if (!rtplot.queue)
+      {
+        // Create plots.
+        if (!msg->headings().empty())
         {
-          rtplot->readBuffer.clear();
+          createPlots(rtplot, msg->headings());
         }
+        else
+        {
+          createPlots(rtplot, sampleCount);
+        }
+      }
 
-        ++iter;
+      double time = receiveTime;
+      if (timeColumn && msg->timeValue(timeColumn, sampleLine, senderTime))
+      {
+        time = rtplot.clockSync.align(senderTime * timeScale, receiveTime);
+      }
+
+      if (reserved)
+      {
+        rtplot.queue->commitRow(time, sampleCount);
       }
       else
       {
-        // Disconnected. Remove.
-        rtplot->spec->disconnect();
-        for (unsigned i = 0; i < rtplot->source->curveCount(); ++i)
-        {
-          if (PlotInstance *plot = rtplot->source->curve(i))
-          {
-            _curves->completeLoading(plot);
-          }
-        }
-        iter = _sources.erase(iter);
-        delete rtplot;
+        rtplot.queue->push(time, values, sampleCount);
       }
     }
-    guard.unlock();
+
+    // Clear the buffer on error, or if too large without reading any data.
+    if (bytesRead < 0)
+    {
+      connection->addDiscarded(rtplot.readBuffer.size());
+      rtplot.readBuffer.clear();
+    }
+    else if (rtplot.readBuffer.size() > discardSize)
+    {
+      connection->addTruncated(rtplot.readBuffer.size());
+      rtplot.readBuffer.clear();
+    }
+
+    {
+      QMutexLocker statsGuard(&rtplot.statsMutex);
+      rtplot.stats = connection->stats();
+      rtplot.samplesDropped = (rtplot.queue) ? rtplot.queue->dropped() : 0;
+      rtplot.clockOffset = rtplot.clockSync.offset();
+      rtplot.jitter = rtplot.clockSync.jitter();
+    }
+
+    // Block until more data arrive rather than spinning on an idle connection.
+    if (!haveData)
+    {
+      connection->waitForData(READ_WAIT_MS);
+    }
   }
+
+  // Close and release the connection on the thread which owns it.
+  rtplot.spec->disconnect();
+  delete rtplot.spec;
+  rtplot.spec = nullptr;
 }
 
 
-unsigned RealTimePlot::loadSpecs(double startTime)
+unsigned RealTimePlot::loadSpecs(qint64 startTime, const QElapsedTimer &clock)
 {
   QMutexLocker guard(_dataMutex);
 
@@ -197,66 +319,85 @@ unsigned RealTimePlot::loadSpecs(double startTime)
   QStringList connectionFiles = _connectionFiles;
   _connectionFiles.clear();
 
-  guard.unlock();
-
-  unsigned loaded = 0;
-  if (!connectionFiles.empty())
+  unsigned started = 0;
+  for (const QString &file : connectionFiles)
   {
-    for (const QString &file : connectionFiles)
-    {
-      if (RealTimePlotInfo *rtplot = loadCommFile(file))
-      {
-        rtplot->source->setTimeBase(startTime);
-        ++loaded;
-      }
-    }
+    RealTimePlotInfo *rtplot = new RealTimePlotInfo;
+    rtplot->filePath = file;
+    rtplot->startTime = startTime;
+    rtplot->clock = clock;
+    rtplot->reader = new SourceReader(*this, *rtplot);
+    _sources.push_back(rtplot);
+    rtplot->reader->start();
+    ++started;
   }
 
-  return loaded;
+  return started;
 }
 
 
-RealTimePlot::RealTimePlotInfo *RealTimePlot::loadCommFile(const QString &filePath)
+bool RealTimePlot::loadCommFile(RealTimePlotInfo &rtplot)
 {
-  QFile file(filePath);
+  QFile file(rtplot.filePath);
   file.open(QFile::ReadOnly);
 
   if (!file.isOpen())
   {
     // TODO: log error
-    return nullptr;
+    return false;
   }
 
   RealTimeSourceLoader loader;
-  RealTimeCommSpec *spec = loader.load(filePath);
+  RealTimeCommSpec *spec = loader.load(rtplot.filePath);
   if (!spec)
   {
     // TODO: log error
-    return nullptr;
+    return false;
   }
 
-  RealTimePlotInfo *rtplot = new RealTimePlotInfo;
-  rtplot->spec = spec;
-  rtplot->source = new PlotSource(PlotSource::RealTime, spec->connection()->name());
+  rtplot.spec = spec;
+  rtplot.source = new PlotSource(PlotSource::RealTime, spec->connection()->name());
+  rtplot.source->setTimeBase(rtplot.startTime);
+  rtplot.source->setTimeColumn(rtplot.spec->timeColumn());
+  rtplot.source->setTimeScale(rtplot.spec->timeScale());
+  rtplot.source->setSampleEncoding(rtplot.spec->sampleEncoding());
 
   if (!spec->incomingMessage()->headings().empty())
   {
     // Have headings. Create plots.
-    createPlots(*rtplot, spec->incomingMessage()->headings());
+    createPlots(rtplot, spec->incomingMessage()->headings());
   }
   // else no headings. Create plots by first sample line.
 
-  rtplot->source->setTimeColumn(rtplot->spec->timeColumn());
-  rtplot->source->setTimeScale(rtplot->spec->timeScale());
-  _sources.push_back(rtplot);
+  QMutexLocker statsGuard(&rtplot.statsMutex);
+  rtplot.name = rtplot.source->name();
+
+  return true;
+}
+
+
+void RealTimePlot::finishSource(RealTimePlotInfo &rtplot)
+{
+  if (rtplot.queue)
+  {
+    _curves->removeRealTimeQueue(rtplot.queue);
+  }
 
-  return rtplot;
+  if (rtplot.source)
+  {
+    for (unsigned i = 0; i < rtplot.source->curveCount(); ++i)
+    {
+      if (PlotInstance *plot = rtplot.source->curve(i))
+      {
+        _curves->completeLoading(plot);
+      }
+    }
+  }
 }
 
 
 void RealTimePlot::createPlots(RealTimePlotInfo &rtplot, unsigned count, const QStringList *headings)
 {
-  //rtplot.plots.resize(count);
   emit beginNewCurves();
   for (unsigned i = 0; i < count; ++i)
   {
@@ -269,6 +410,11 @@ void RealTimePlot::createPlots(RealTimePlotInfo &rtplot, unsigned count, const Q
     _curves->newCurve(plot);
   }
   emit endNewCurves();
+
+  const size_t rowSize = sizeof(double) * (count + 2);
+  const size_t rows = std::max<size_t>(SAMPLE_QUEUE_SIZE / rowSize, MIN_SAMPLE_QUEUE_ROWS);
+  rtplot.queue = new RTSampleQueue(rtplot.source, count, rows);
+  _curves->addRealTimeQueue(rtplot.queue);
 }
 
 
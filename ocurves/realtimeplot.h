@@ -11,9 +11,15 @@
 #include "plotgenerator.h"
 #include "plotsource.h"
 
+#include "rt/realtimeconnection.h"
+#include "rt/rtclocksync.h"
+#include "rt/rtreadbuffer.h"
+
+#include <QElapsedTimer>
 #include <QMutex>
 
 class Curves;
+class RTSampleQueue;
 class QSerialPort;
 class QAbstractSocket;
 class QMutex;
@@ -30,11 +36,25 @@ These files are loaded by the @c RealTimePlot class. The XML file identifies the
 The serial example below uses the string data format, while the network section shows the a binary
 format example. Either is valid in either block. The \<headings\> element is optional.
 
+Samples are timestamped with a high resolution, monotonic clock when data are read from the
+connection. Each datagram, or each read for stream connections, is timestamped separately and
+each message takes the time of the data it starts in (see @c RTReadBuffer). Alternatively, setting the \<time\> source to "sender" uses the sender's time
+column or field instead, multiplied by the time scale to give seconds. Sender times are
+aligned to the local clock by estimating the clock offset (see @c RTClockSync). This preserves
+the sender's sample spacing, while the difference from the receive time measures jitter.
+
+The \<buffer\> size sets the number of samples retained per curve. Values may optionally be
+stored with reduced precision to retain a longer history: "float32" halves the memory, while
+"int16" and "int32" store values quantised as (value - offset) / scale. Times are always
+stored at full precision. See @c PlotSampleEncoding.
+
 @code
 <connection>
   <serial port="portname" baud="9600">
-    <buffer size="xxx"/>
-    <time column="1" scale="1.0"/>
+    <!-- Optional encoding: double (default), float32, int16 or int32 -->
+    <buffer size="xxx" encoding="int16" scale="0.001" offset="0"/>
+    <!-- Optional time column (one-based). Ignored unless source="sender" -->
+    <time column="1" scale="1.0" source="receive|sender"/>
     <comms format="utf-8">
       <onconnect>abcdefg</onconnect>
       <headings>
@@ -46,7 +66,10 @@ format example. Either is valid in either block. The \<headings\> element is opt
   </serial>
   <network ip="ipv4" port="1234" protocol="udp|tcp">
     <buffer size="xxx"/>
-    <time field="timestamp" scale="1.0e-6"/>
+    <!-- Optional: socket receive buffer size in bytes (UDP only) -->
+    <socket receivebuffer="4194304"/>
+    <!-- Use the timestamp field scaled to seconds, aligned to the local clock -->
+    <time field="timestamp" scale="1.0e-6" source="sender"/>
     <comms format="binary">
       <onconnect>
         <!-- Data structure sent when connection is made -->
@@ -109,6 +132,14 @@ class RealTimeCommSpec;
 /// be cleared by calling @c stop(), leaving the thread running, ready for more
 /// @c appendLoad() calls. Alternatively the entire thread aborted @c abortLoad()
 /// or @c quit().
+///
+/// Each connection is serviced by its own reader thread, which loads the comm-spec,
+/// opens the connection and decodes incoming messages. Decoded samples are pushed into
+/// an @c RTSampleQueue for the source, which the main thread drains in bulk via
+/// @c Curves::migrateLoadingData(). Readers block waiting for data on their own
+/// connection (see @c READ_WAIT_MS) so a busy connection never delays another.
+/// The generator thread itself only monitors the readers, retiring sources as they
+/// disconnect or on @c stop().
 class RealTimePlot : public PlotGenerator
 {
   Q_OBJECT
@@ -116,20 +147,48 @@ public:
   enum
   {
     DEFAULT_SAMPLE_LIMIT = 1000000, ///< Default sample buffer size limit (element count).
-    MAX_READ_BUFFER_SIZE = 4 * 1024 ///< Default read buffer size (bytes).
+    /// Default read buffer size (bytes). Undecoded data beyond this, or the connection's
+    /// @c RealTimeConnection::maxMessageSize() if larger, are discarded.
+    MAX_READ_BUFFER_SIZE = 4 * 1024,
+    /// Maximum time a reader thread blocks waiting for new data (milliseconds). Also the
+    /// interval at which the generator thread checks the readers. This bounds the
+    /// latency in responding to @c stop().
+    READ_WAIT_MS = 10,
+    /// Target memory for each source's @c RTSampleQueue (bytes). This must cover the samples
+    /// received between main thread updates, or samples are dropped.
+    SAMPLE_QUEUE_SIZE = 4 * 1024 * 1024,
+    MIN_SAMPLE_QUEUE_ROWS = 1024  ///< Minimum row capacity of an @c RTSampleQueue.
   };
 
+  /// Reader thread servicing a single connection.
+  class SourceReader;
+
   /// Data tracked about a real time source.
+  ///
+  /// The @c spec, @c source and @c queue are set up by the @c reader thread, which has
+  /// sole access to the @c spec and @c readBuffer.
   struct RealTimePlotInfo
   {
+    QString filePath;       ///< The comm-spec file.
+    qint64 startTime;       ///< Time base for the source (ms since epoch).
+    QElapsedTimer clock;    ///< Monotonic receive clock, started at @c startTime.
+    RTClockSync clockSync;  ///< Aligns sender timestamps to the @c clock.
     PlotSource::Ptr source; ///< The source
     RealTimeCommSpec *spec; ///< Communications specification.
-    QByteArray readBuffer;  ///< Read buffer.
+    RTReadBuffer readBuffer;  ///< Read buffer, reused for each read.
+    RTSampleQueue *queue;   ///< Decoded samples awaiting migration. Created with the curves.
+    SourceReader *reader;   ///< The reader thread for this source.
+    mutable QMutex statsMutex;      ///< Guards the statistics snapshot below.
+    QString name;                   ///< Source name, published once loaded.
+    RealTimeConnectionStats stats;  ///< Snapshot of the connection statistics.
+    quint64 samplesDropped;         ///< Snapshot of @c RTSampleQueue::dropped().
+    double clockOffset;             ///< Snapshot of @c RTClockSync::offset().
+    double jitter;                  ///< Snapshot of @c RTClockSync::jitter().
 
     /// Constructor
     RealTimePlotInfo();
 
-    /// Deletes the @c spec.
+    /// Deletes the @c spec, @c queue and @c reader.
     ~RealTimePlotInfo();
   };
 
@@ -153,25 +212,59 @@ public:
   /// Stop current real-time plots without terminating the thread.
   void stop();
 
+  /// Receive statistics for a real-time source.
+  struct SourceStats
+  {
+    QString name;                   ///< The source name.
+    RealTimeConnectionStats stats;  ///< Connection statistics.
+    quint64 samplesDropped;         ///< Samples dropped due to a full @c RTSampleQueue.
+    /// Estimated sender clock offset (seconds). Zero unless using sender time.
+    double clockOffset;
+    /// Estimated delivery jitter (seconds). Zero unless using sender time.
+    double jitter;
+  };
+
+  /// Collect the receive statistics for the currently connected sources. Thread safe.
+  ///
+  /// This may be used to check for dropped or truncated data. Statistics are a snapshot
+  /// published by each reader thread after each read.
+  ///
+  /// @param stats Populated with the statistics for each source.
+  void sourceStats(QVector<SourceStats> &stats) const;
+
 protected:
   /// Run loop.
   void run() override;
 
 private:
-  /// Load the pending connection files initiating real-time data loading.
+  /// Load the pending connection files, starting a reader thread for each.
   /// @param startTime The current time value (for time-stamping).
-  /// @return The number of additional sources loaded.
-  unsigned loadSpecs(double startTime);
+  /// @param clock The monotonic clock, started at @p startTime.
+  /// @return The number of additional sources started.
+  unsigned loadSpecs(qint64 startTime, const QElapsedTimer &clock);
+
+  /// Reader thread entry point: load and service the connection for @p rtplot until it
+  /// disconnects or the reader is interrupted.
+  /// @param rtplot The source to read.
+  void readSource(RealTimePlotInfo &rtplot);
+
+  /// Load the real-time XML comm-spec file for @p rtplot. Called on the reader thread
+  /// so the connection is opened on the thread which reads it.
+  /// @param rtplot The source to load. Sets the @c spec and @c source on success.
+  /// @return True on success.
+  bool loadCommFile(RealTimePlotInfo &rtplot);
 
-  /// Load a single real-time XML comm-spec file.
-  /// @param filePath The path to the file to load.
-  /// @return A valid @c RealTimePlotInfo object on success, null on failure.
-  RealTimePlotInfo *loadCommFile(const QString &filePath);
+  /// Retire a source once its reader thread has finished. Remaining queued samples
+  /// are migrated and the curves completed.
+  /// @param rtplot The source to retire.
+  void finishSource(RealTimePlotInfo &rtplot);
 
   /// Create the @c PlotInstance objects for @c rtplot.
   ///
   /// Called either immediately if there are headings specified in the incoming @c RTMessage.
   /// Otherwise called after the first data line (to ensure column count is known).
+  /// Also creates the sample @c RTSampleQueue and registers it with the @c Curves model.
+  /// Called on the reader thread.
   ///
   /// @param rtplot Real-time info.
   /// @param count Number of columns for the plot.
@@ -183,7 +276,7 @@ private:
   void createPlots(RealTimePlotInfo &rtplot, const QStringList &headings);
 
   QStringList _connectionFiles;         ///< Pending loading list.
-  QList<RealTimePlotInfo *> _sources;   ///< Loaded sources.
+  QList<RealTimePlotInfo *> _sources;   ///< Active sources. Modified only on the generator thread.
   bool _stopRequested;                  ///< True if @c stop() has been requested.
 };
 
@@ -16,6 +16,7 @@ RealTimeCommSpec::RealTimeCommSpec()
   , _bufferSize(1000000u)
   , _timeColumn(0)
   , _timeScale(1)
+  , _timeSource(ReceiveTime)
 {
 }
 
@@ -8,6 +8,8 @@
 
 #include "ocurvesconfig.h"
 
+#include "plotsamplecolumn.h"
+
 class RealTimeConnection;
 class RTMessage;
 
@@ -37,6 +39,17 @@ class RTMessage;
 class RealTimeCommSpec
 {
 public:
+  /// Identifies how incoming samples are timestamped.
+  enum TimeSource
+  {
+    /// Use the local, monotonic time at which the data were read from the connection.
+    ReceiveTime,
+    /// Use the sender's time field (see @c timeColumn()), aligned to the receive
+    /// clock by estimating the clock offset. Falls back to @c ReceiveTime when there
+    /// is no time column.
+    SenderTime
+  };
+
   /// Create an empty comm-spec.
   RealTimeCommSpec();
 
@@ -100,6 +113,17 @@ public:
   /// @return The requested buffer size in data sample elements.
   unsigned bufferSize() const;
 
+  /// Set the value encoding for the associated @c PlotInstance objects. Reduced precision
+  /// encodings extend the history which fits in memory.
+  ///
+  /// As with @c bufferSize(), the comm-spec only holds this information.
+  /// @param encoding The sample encoding.
+  void setSampleEncoding(const PlotSampleEncoding &encoding);
+
+  /// Access the value encoding for the associated @c PlotInstance objects.
+  /// @return The sample encoding.
+  const PlotSampleEncoding &sampleEncoding() const;
+
   /// Set the expected time column number.
   ///
   /// This identifies the time column for incoming data. It is a one-based index with
@@ -126,6 +150,14 @@ public:
   /// @return The time scaling multiplier.
   double timeScale() const;
 
+  /// Set how incoming samples are timestamped.
+  /// @param source The time source.
+  void setTimeSource(TimeSource source);
+
+  /// Query how incoming samples are timestamped.
+  /// @return The time source.
+  TimeSource timeSource() const;
+
   /// Send disconnect message and disconnect the connection.
   ///
   /// This is a convenience function for managing disconnection.
@@ -143,8 +175,10 @@ private:
   RTMessage *_disconnectMsg;        ///< Message to send on disconnect. May be null.
   RTMessage *_incomingMsg;          ///< Processes incoming data. Must not be null.
   unsigned _bufferSize;             ///< Expected data samples buffer size for associated @c PlotInstance objects.
+  PlotSampleEncoding _sampleEncoding; ///< Value encoding for associated @c PlotInstance objects.
   unsigned _timeColumn;             ///< 1-base index into the time column. Zero for none.
   double _timeScale;                ///< Scaling value applied to the time column.
+  TimeSource _timeSource;           ///< How incoming samples are timestamped.
 };
 
 inline RealTimeConnection *RealTimeCommSpec::connection() const
@@ -183,6 +217,18 @@ inline unsigned RealTimeCommSpec::bufferSize() const
 }
 
 
+inline void RealTimeCommSpec::setSampleEncoding(const PlotSampleEncoding &encoding)
+{
+  _sampleEncoding = encoding;
+}
+
+
+inline const PlotSampleEncoding &RealTimeCommSpec::sampleEncoding() const
+{
+  return _sampleEncoding;
+}
+
+
 inline void RealTimeCommSpec::setTimeColumn(unsigned columnNumber)
 {
   _timeColumn = columnNumber;
@@ -206,4 +252,16 @@ inline double RealTimeCommSpec::timeScale() const
   return _timeScale;
 }
 
+
+inline void RealTimeCommSpec::setTimeSource(TimeSource source)
+{
+  _timeSource = source;
+}
+
+
+inline RealTimeCommSpec::TimeSource RealTimeCommSpec::timeSource() const
+{
+  return _timeSource;
+}
+
 #endif // REALTIMECOMMSPEC_H_
@@ -11,6 +11,25 @@
 #include <QString>
 #include <QVector>
 
+class RTReadBuffer;
+
+/// @ingroup realtime
+/// Receive statistics for a @c RealTimeConnection.
+///
+/// Used to verify ingestion keeps up with the incoming data rate.
+struct RealTimeConnectionStats
+{
+  quint64 bytesReceived;    ///< Total bytes read.
+  quint64 packetsReceived;  ///< Number of datagrams, or successful reads for stream connections.
+  quint64 packetsTruncated; ///< Number of datagrams truncated on reading, or messages discarded as oversize. See @c RealTimeConnection::addTruncated().
+  quint64 readErrors;       ///< Number of failed reads. Any data pending for the read are lost.
+  quint64 bytesDiscarded;   ///< Bytes received, but discarded without decoding. See @c RealTimeConnection::addDiscarded().
+
+  /// Constructor, zeroing all counters.
+  inline RealTimeConnectionStats()
+    : bytesReceived(0), packetsReceived(0), packetsTruncated(0), readErrors(0), bytesDiscarded(0) {}
+};
+
 /// @ingroup realtime
 /// This is the base class for data source which provides data in real time.
 class RealTimeConnection
@@ -34,9 +53,43 @@ public:
   /// @param buffer The buffer to send.
   virtual int send(const QByteArray &buffer) = 0;
 
-  /// Read data into the given buffer.
+  /// Read available data, appending to the given buffer.
+  ///
+  /// Implementations may bound the data read per call, leaving the remainder for the next
+  /// call, so callers should read again while data are read.
   /// @param buffer The buffer to read into.
-  virtual int read(QByteArray &buffer) = 0;
+  /// @return The number of bytes read, or negative on error.
+  virtual int read(RTReadBuffer &buffer) = 0;
+
+  /// Block until data are available to @c read() or @p timeout elapses.
+  ///
+  /// Must be called from the thread which opened the connection. May return
+  /// early without data, such as when disconnected.
+  ///
+  /// @param timeout The maximum time to wait (milliseconds).
+  /// @return True if data are available to read.
+  virtual bool waitForData(int timeout) = 0;
+
+  /// Query the largest message the connection can deliver in a single read, such as the
+  /// maximum datagram size. Readers must not discard undecoded data smaller than this.
+  /// @return The maximum message size (bytes), or zero if the connection imposes no limit.
+  virtual size_t maxMessageSize() const { return 0; }
+
+  /// Access the receive statistics for the connection.
+  /// @return The receive statistics.
+  inline const RealTimeConnectionStats &stats() const { return _stats; }
+
+  /// Record received data which the reader has discarded without decoding.
+  /// @param byteCount The number of bytes discarded.
+  inline void addDiscarded(quint64 byteCount) { _stats.bytesDiscarded += byteCount; }
+
+  /// Record an oversize message which the reader has discarded without decoding.
+  /// Counted as a truncated packet as well as discarded bytes.
+  /// @param byteCount The number of bytes discarded.
+  inline void addTruncated(quint64 byteCount) { ++_stats.packetsTruncated; _stats.bytesDiscarded += byteCount; }
+
+protected:
+  RealTimeConnectionStats _stats; ///< Receive statistics. Maintained by @c read() implementations.
 };
 
 
@@ -6,6 +6,7 @@
 #include "realtimeserialconnection.h"
 
 #include "plotfile.h"
+#include "rtreadbuffer.h"
 
 #include <QSerialPort>
 
@@ -66,19 +67,41 @@ int RealTimeSerialConnection::send(const QByteArray &buffer)
 }
 
 
-int RealTimeSerialConnection::read(QByteArray &buffer)
+int RealTimeSerialConnection::read(RTReadBuffer &buffer)
 {
   if (!_port || !_port->isOpen())
   {
     return 0;
   }
 
-  QByteArray newBytes = _port->readAll();
-  if (newBytes.size())
+  const qint64 available = _port->bytesAvailable();
+  if (available <= 0)
   {
-    buffer.append(newBytes);
-    return newBytes.size();
+    return 0;
+  }
+
+  // Read directly into the buffer.
+  const qint64 read = _port->read(buffer.reserve(size_t(available)), available);
+  if (read > 0)
+  {
+    buffer.commit(size_t(read));
+    _stats.bytesReceived += quint64(read);
+    ++_stats.packetsReceived;
+  }
+  else if (read < 0)
+  {
+    ++_stats.readErrors;
+  }
+  return int(read);
+}
+
+
+bool RealTimeSerialConnection::waitForData(int timeout)
+{
+  if (!_port || !_port->isOpen())
+  {
+    return false;
   }
 
-  return 0;
+  return _port->bytesAvailable() > 0 || _port->waitForReadyRead(timeout);
 }
@@ -144,8 +144,11 @@ RealTimeCommSpec *RealTimeSourceLoader::parseNetwork(QDomElement &element)
   }
   else if (protocol.compare("udp") == 0)
   {
+    // Optional socket receive buffer size.
+    QDomElement socketElem = element.firstChildElement("socket");
+    const int receiveBufferSize = socketElem.attribute("receivebuffer").toInt();
     RealTimeUdpConnection *source = new RealTimeUdpConnection();
-    if (!source->open(QHostAddress(address), port))
+    if (!source->open(QHostAddress(address), port, receiveBufferSize))
     {
       delete source;
       delete spec;
@@ -175,6 +178,17 @@ bool RealTimeSourceLoader::parseCommon(QDomElement &element, RealTimeCommSpec &s
   {
     spec.setBufferSize(64 * 1024);
   }
+
+  // Unrecognised encodings leave the default: double.
+  PlotSampleEncoding encoding;
+  PlotSampleEncoding::typeFromName(bufferElem.attribute("encoding"), encoding.type);
+  encoding.scale = bufferElem.attribute("scale").toDouble(&ok);
+  if (!ok || encoding.scale == 0)
+  {
+    encoding.scale = 1;
+  }
+  encoding.offset = bufferElem.attribute("offset").toDouble();
+  spec.setSampleEncoding(encoding);
   spec.setTimeColumn(timeElem.attribute("column").toUInt());
   timeFieldName = timeElem.attribute("field");
   spec.setTimeScale(timeElem.attribute("scale").toDouble(&ok));
@@ -182,6 +196,8 @@ bool RealTimeSourceLoader::parseCommon(QDomElement &element, RealTimeCommSpec &s
   {
     spec.setTimeScale(1);
   }
+  spec.setTimeSource((timeElem.attribute("source").compare("sender") == 0) ?
+                     RealTimeCommSpec::SenderTime : RealTimeCommSpec::ReceiveTime);
 
   return true;
 }
@@ -386,5 +402,7 @@ RTBinaryMessage *RealTimeSourceLoader::parseBinaryStruct(QDomElement &element)
     field = field.nextSiblingElement("field");
   }
 
+  // Resolve the field layout for decoding.
+  msg->compile();
   return msg;
 }
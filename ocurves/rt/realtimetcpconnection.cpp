@@ -6,6 +6,7 @@
 #include "realtimetcpconnection.h"
 
 #include "plotfile.h"
+#include "rtreadbuffer.h"
 
 #include <QTcpSocket>
 
@@ -64,7 +65,7 @@ int RealTimeTcpConnection::send(const QByteArray &buffer)
 }
 
 
-int RealTimeTcpConnection::read(QByteArray &buffer)
+int RealTimeTcpConnection::read(RTReadBuffer &buffer)
 {
   if (!_socket || _socket->state() != QAbstractSocket::ConnectedState)
   {
@@ -72,12 +73,34 @@ int RealTimeTcpConnection::read(QByteArray &buffer)
   }
 
   _socket->waitForReadyRead(0);
-  QByteArray newBytes = _socket->readAll();
-  if (newBytes.size())
+  const qint64 available = _socket->bytesAvailable();
+  if (available <= 0)
   {
-    buffer.append(newBytes);
-    return newBytes.size();
+    return 0;
   }
 
-  return 0;
+  // Read directly into the buffer.
+  const qint64 read = _socket->read(buffer.reserve(size_t(available)), available);
+  if (read > 0)
+  {
+    buffer.commit(size_t(read));
+    _stats.bytesReceived += quint64(read);
+    ++_stats.packetsReceived;
+  }
+  else if (read < 0)
+  {
+    ++_stats.readErrors;
+  }
+  return int(read);
+}
+
+
+bool RealTimeTcpConnection::waitForData(int timeout)
+{
+  if (!_socket || _socket->state() != QAbstractSocket::ConnectedState)
+  {
+    return false;
+  }
+
+  return _socket->bytesAvailable() > 0 || _socket->waitForReadyRead(timeout);
 }
@@ -54,9 +54,15 @@ public:
   /// @param buffer The buffer to send.
   int send(const QByteArray &buffer) override;
 
-  /// Read data into the given buffer.
+  /// Read available data, appending to the given buffer.
   /// @param buffer The buffer to read into.
-  int read(QByteArray &buffer) override;
+  /// @return The number of bytes read, or negative on error.
+  int read(RTReadBuffer &buffer) override;
+
+  /// Block until data are available to @c read() or @p timeout elapses.
+  /// @param timeout The maximum time to wait (milliseconds).
+  /// @return True if data are available to read.
+  bool waitForData(int timeout) override;
 
 private:
   QTcpSocket *_socket;            ///< TCP connection.
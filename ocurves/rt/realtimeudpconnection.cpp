@@ -6,8 +6,16 @@
 #include "realtimeudpconnection.h"
 
 #include "plotfile.h"
+#include "rtreadbuffer.h"
 
 #include <QUdpSocket>
+#include <QVariant>
+
+/// The maximum UDP payload. Also the read size used when a datagram size cannot be determined.
+#define UDP_MAX_DATAGRAM_SIZE 65507
+/// Bytes read by a single @c read() call before returning, so the caller may decode the data
+/// read so far. Further datagrams are left pending for the next call.
+#define UDP_READ_LIMIT (4 * UDP_MAX_DATAGRAM_SIZE)
 
 RealTimeUdpConnection::RealTimeUdpConnection()
   : _socket(nullptr)
@@ -28,13 +36,23 @@ QString RealTimeUdpConnection::name() const
 }
 
 
-bool RealTimeUdpConnection::open(const QHostAddress &address, quint16 port)
+bool RealTimeUdpConnection::open(const QHostAddress &address, quint16 port, int receiveBufferSize)
 {
   disconnect();
   _socket = new QUdpSocket;
   _address = address;
   _port = port;
-  return _socket->bind(port);
+  if (!_socket->bind(port))
+  {
+    return false;
+  }
+
+  if (receiveBufferSize > 0)
+  {
+    _socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, receiveBufferSize);
+  }
+
+  return true;
 }
 
 
@@ -66,19 +84,54 @@ int RealTimeUdpConnection::send(const QByteArray &buffer)
 }
 
 
-int RealTimeUdpConnection::read(QByteArray &buffer)
+int RealTimeUdpConnection::read(RTReadBuffer &buffer)
 {
   if (!_socket)
   {
     return -1;
   }
 
-  const unsigned BufferSize = 1024;
-  char bytes[BufferSize];
-  int read = int(_socket->readDatagram(bytes, BufferSize));
-  if (read > 0)
+  // Drain pending datagrams up to the read limit, reading each directly into the buffer.
+  int totalRead = 0;
+  while (totalRead < UDP_READ_LIMIT && _socket->hasPendingDatagrams())
+  {
+    const qint64 datagramSize = _socket->pendingDatagramSize();
+    const qint64 readSize = (datagramSize >= 0) ? datagramSize : UDP_MAX_DATAGRAM_SIZE;
+    char *bytes = buffer.reserve(size_t(readSize));
+    const qint64 read = _socket->readDatagram(bytes, readSize);
+    if (read < 0)
+    {
+      ++_stats.readErrors;
+      return (totalRead) ? totalRead : -1;
+    }
+
+    if (read < datagramSize)
+    {
+      ++_stats.packetsTruncated;
+    }
+
+    buffer.commit(size_t(read));
+    _stats.bytesReceived += quint64(read);
+    ++_stats.packetsReceived;
+    totalRead += int(read);
+  }
+
+  return totalRead;
+}
+
+
+bool RealTimeUdpConnection::waitForData(int timeout)
+{
+  if (!_socket)
   {
-    buffer.append(bytes, read);
+    return false;
   }
-  return read;
+
+  return _socket->hasPendingDatagrams() || _socket->waitForReadyRead(timeout);
+}
+
+
+size_t RealTimeUdpConnection::maxMessageSize() const
+{
+  return UDP_MAX_DATAGRAM_SIZE;
 }
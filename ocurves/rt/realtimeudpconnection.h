@@ -39,8 +39,10 @@ public:
   ///
   /// @param address The target address.
   /// @param port The connection port.
+  /// @param receiveBufferSize Requested socket receive buffer size (bytes). Zero to use
+  ///   the system default. A larger buffer absorbs bursts from high rate senders.
   /// @return True if the connection is successfully established.
-  bool open(const QHostAddress &address, quint16 port);
+  bool open(const QHostAddress &address, quint16 port, int receiveBufferSize = 0);
 
   /// Is the port open for communication?
   /// @return True if open.
@@ -53,9 +55,25 @@ public:
   /// @param buffer The buffer to send.
   int send(const QByteArray &buffer) override;
 
-  /// Read data into the given buffer.
+  /// Read pending datagrams, appending to the given buffer.
+  ///
+  /// Each datagram is read in full, sized by @c QUdpSocket::pendingDatagramSize(). Reading
+  /// stops after a bounded number of bytes, leaving any further datagrams pending, so the
+  /// caller can decode the data before the buffer grows under sustained load.
+  /// Datagram counts and truncation are recorded in the @c stats().
+  ///
   /// @param buffer The buffer to read into.
-  int read(QByteArray &buffer) override;
+  /// @return The number of bytes read, or negative on error.
+  int read(RTReadBuffer &buffer) override;
+
+  /// Block until data are available to @c read() or @p timeout elapses.
+  /// @param timeout The maximum time to wait (milliseconds).
+  /// @return True if data are available to read.
+  bool waitForData(int timeout) override;
+
+  /// Reports the maximum UDP payload size.
+  /// @return The maximum datagram size (bytes).
+  size_t maxMessageSize() const override;
 
 private:
   QUdpSocket *_socket;
@@ -6,6 +6,10 @@
 #include "rtbinarymessage.h"
 
 #include <QDataStream>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cstring>
 
 const unsigned RTBinaryMessage::TypeSizes[] =
 {
@@ -25,9 +29,47 @@ const unsigned RTBinaryMessage::TypeSizes[] =
   8
 };
 
+namespace
+{
+  /// Matches @c RTBinaryMessage::DecodeFunc.
+  typedef double (*DecodeFunction)(const char *data);
+
+  /// Decode a value of type @c T from @p data, optionally reversing the byte order.
+  template <typename T, bool Swap>
+  double decodeValue(const char *data)
+  {
+    T value;
+    if (Swap)
+    {
+      char bytes[sizeof(T)];
+      for (size_t i = 0; i < sizeof(T); ++i)
+      {
+        bytes[i] = data[sizeof(T) - 1 - i];
+      }
+      memcpy(&value, bytes, sizeof(T));
+    }
+    else
+    {
+      memcpy(&value, data, sizeof(T));
+    }
+    return double(value);
+  }
+
+
+  /// Select the decode function for type @c T.
+  template <typename T>
+  inline DecodeFunction decoder(bool swap)
+  {
+    return (swap) ? &decodeValue<T, true> : &decodeValue<T, false>;
+  }
+}
+
+
 RTBinaryMessage::RTBinaryMessage(bool littleEndian)
-  : _messageMinSize(0)
+  : _planTail(0)
+  , _messageMinSize(0)
   , _littleEndian(littleEndian)
+  , _planValid(false)
 {
 }
 
@@ -45,23 +87,149 @@ void RTBinaryMessage::setMessage(QByteArray &buffer)
 }
 
 
-int RTBinaryMessage::readMessage(const QByteArray &source)
+int RTBinaryMessage::readMessage(const char *data, size_t size)
 {
-  if (unsigned(source.size()) < _messageMinSize)
+  if (!_planValid)
   {
-    return 0;
+    compile();
   }
 
-  QDataStream stream(source);
-  stream.setByteOrder((_littleEndian) ? QDataStream::LittleEndian : QDataStream::BigEndian);
+  return int(decode(data, size, _headingValues.data()));
+}
 
-  int read = 0;
-  for (Field &field : _fields)
+
+void RTBinaryMessage::compile()
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+  const bool swap = !_littleEndian;
+#else  // Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+  const bool swap = _littleEndian;
+#endif // Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+
+  _plan.clear();
+  // Offset from the current base. The base is fixed at zero until a padding step must be
+  // resolved while decoding.
+  unsigned offset = 0;
+  bool dynamicBase = false;
+  int headingIndex = 0;
+  for (int i = 0; i < _fields.count(); ++i)
   {
-    read += readField(stream, field, read);
+    const Field &field = _fields[i];
+    DecodeStep step = { nullptr, field.type, offset, TypeSizes[field.type], i, -1, -1 };
+    if (field.heading)
+    {
+      step.heading = headingIndex++;
+    }
+
+    switch (field.type)
+    {
+    case Padding:
+      offset += field.value.toUInt();
+      continue;
+
+    case PadTo:
+      if (!dynamicBase)
+      {
+        offset = std::max(offset, field.value.toUInt());
+        continue;
+      }
+      step.size = field.value.toUInt();
+      break;
+
+    case PadByField:
+    case PadToField:
+      step.type = (field.type == PadByField) ? PadByField : PadTo;
+      step.padField = fieldIndex(field.value.toString());
+      dynamicBase = true;
+      break;
+
+    case Int8:    step.decode = decoder<qint8>(swap); break;
+    case Int16:   step.decode = decoder<qint16>(swap); break;
+    case Int32:   step.decode = decoder<qint32>(swap); break;
+    case Int64:   step.decode = decoder<qint64>(swap); break;
+    case Uint8:   step.decode = decoder<quint8>(swap); break;
+    case Uint16:  step.decode = decoder<quint16>(swap); break;
+    case Uint32:  step.decode = decoder<quint32>(swap); break;
+    case Uint64:  step.decode = decoder<quint64>(swap); break;
+    case Float32: step.decode = decoder<float>(swap); break;
+    case Float64: step.decode = decoder<double>(swap); break;
+    default:
+      continue;
+    }
+
+    _plan.push_back(step);
+    if (step.decode)
+    {
+      offset += step.size;
+    }
+    else
+    {
+      // Padding resolved while decoding. Following offsets are relative to the new base.
+      offset = 0;
+    }
   }
 
-  return stream.status() == QDataStream::Ok ? read : -1;
+  _planTail = offset;
+  _planValid = true;
+}
+
+
+size_t RTBinaryMessage::decode(const char *data, size_t size, double *values)
+{
+  if (!_planValid)
+  {
+    compile();
+  }
+
+  if (size < _messageMinSize)
+  {
+    return 0;
+  }
+
+  size_t base = 0;
+  for (const DecodeStep &step : _plan)
+  {
+    const size_t pos = base + step.offset;
+    if (step.decode)
+    {
+      if (pos + step.size > size)
+      {
+        return 0;
+      }
+
+      const double value = step.decode(data + pos);
+      _values[step.field] = value;
+      if (step.heading >= 0)
+      {
+        values[step.heading] = value;
+      }
+    }
+    else
+    {
+      size_t padding = step.size;
+      if (step.padField >= 0)
+      {
+        const double fieldValue = _values[step.padField];
+        padding = (fieldValue > 0) ? size_t(fieldValue) : 0u;
+      }
+      base = (step.type == PadByField) ? pos + padding : std::max(pos, padding);
+    }
+  }
+
+  const size_t messageSize = base + _planTail;
+  return (messageSize <= size) ? messageSize : 0u;
+}
+
+
+unsigned RTBinaryMessage::valueCount() const
+{
+  return unsigned(_headings.count());
+}
+
+
+int RTBinaryMessage::readValues(const char *data, size_t size, double *values)
+{
+  return int(decode(data, size, values));
 }
 
 
@@ -73,17 +241,20 @@ QStringList RTBinaryMessage::headings() const
 
 unsigned RTBinaryMessage::populateValues(std::vector<double> &values) const
 {
-  values.resize(_headings.size());
-  unsigned index = 0;
-  for (const Field &field : _fields)
+  values.assign(_headingValues.begin(), _headingValues.end());
+  return unsigned(values.size());
+}
+
+
+bool RTBinaryMessage::timeValue(unsigned timeColumn, const std::vector<double> &/*values*/, double &time) const
+{
+  if (timeColumn == 0 || timeColumn > _values.size())
   {
-    if (field.heading)
-    {
-      values[index++] = field.value.toDouble();
-    }
+    return false;
   }
 
-  return unsigned(values.size());
+  time = _values[timeColumn - 1];
+  return true;
 }
 
 
@@ -95,11 +266,14 @@ void RTBinaryMessage::addField(const QString &name, FieldType type, bool heading
   field.value = value;
   field.heading = heading;
   _fields << field;
+  _values.push_back(value.toDouble());
   _messageMinSize += TypeSizes[field.type];
   if (heading)
   {
     _headings << name;
+    _headingValues.push_back(value.toDouble());
   }
+  _planValid = false;
 }
 
 
@@ -251,166 +425,10 @@ uint RTBinaryMessage::writeField(QDataStream &stream, const Field &field, uint p
 }
 
 
-int RTBinaryMessage::readField(QDataStream &stream, Field &field, uint pos)
-{
-  switch (field.type)
-  {
-  case Padding:
-    {
-      uint paddingSize = field.value.toUInt();
-      quint8 pad = 0;
-      uint read = 0;
-      while (read < paddingSize && stream.status() == QDataStream::Ok)
-      {
-        stream >> pad;
-        ++read;
-      }
-
-      return read;
-    }
-    break;
-  case PadTo:
-    {
-      uint paddingSize = field.value.toUInt();
-      quint8 pad = 0;
-      uint read = pos;
-      while (read < paddingSize && stream.status() == QDataStream::Ok)
-      {
-        stream >> pad;
-        ++read;
-      }
-
-      return read;
-    }
-    break;
-  case PadByField:
-    {
-      QString fieldLookup = field.value.toString();
-      uint paddingSize = fieldValueV(fieldLookup).toUInt();
-      quint8 pad = 0;
-      uint read = 0;
-      while (read < paddingSize && stream.status() == QDataStream::Ok)
-      {
-        stream >> pad;
-        ++read;
-      }
-
-      return read;
-    }
-    break;
-  case PadToField:
-    {
-      QString fieldLookup = field.value.toString();
-      uint paddingSize = fieldValueV(fieldLookup).toUInt();
-      quint8 pad = 0;
-      uint read = pos;
-      while (read < paddingSize && stream.status() == QDataStream::Ok)
-      {
-        stream >> pad;
-        ++read;
-      }
-
-      return read;
-    }
-    break;
-  case Int8:
-    {
-      qint8 val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 1 : 0;
-    }
-    break;
-  case Uint8:
-    {
-      quint8 val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 1 : 0;
-    }
-    break;
-  case Int16:
-    {
-      qint16 val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 2 : 0;
-    }
-    break;
-  case Uint16:
-    {
-      quint16 val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 2 : 0;
-    }
-    break;
-  case Int32:
-    {
-      qint32 val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 4 : 0;
-    }
-    break;
-  case Uint32:
-    {
-      quint32 val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 4 : 0;
-    }
-    break;
-  case Int64:
-    {
-      qint64 val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 8 : 0;
-    }
-    break;
-  case Uint64:
-    {
-      quint64 val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 8 : 0;
-    }
-    break;
-  case Float32:
-    {
-      float val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 4 : 0;
-    }
-    break;
-  case Float64:
-    {
-      double val = 0;
-      stream >> val;
-      field.value = val;
-      return stream.status() == QDataStream::Ok ? 8 : 0;
-    }
-    break;
-  default:
-    break;
-  }
-
-  return 0;
-}
-
-
 double RTBinaryMessage::fieldValueD(const QString &key) const
 {
-  for (const Field &field : _fields)
-  {
-    if (field.name.compare(key) == 0)
-    {
-      return field.value.toDouble();
-    }
-  }
-  return 0;
+  const int index = fieldIndex(key);
+  return (index >= 0) ? _values[index] : 0.0;
 }
 
 
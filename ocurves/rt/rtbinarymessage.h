@@ -37,6 +37,13 @@ class QDataStream;
 ///
 /// Registered fields may be marked as headings. Only those marked as such
 /// are reported by @c headings() and @c populateValues().
+///
+/// Reading uses a decode plan built by @c compile() from the registered fields. The
+/// plan resolves field offsets, padding and byte swapping up front, so decoding reads
+/// each field directly from the buffer into a double value without intermediate
+/// streams or @c QVariant conversion. Padding which depends on another field's value
+/// (@c PadByField, @c PadToField) is resolved as each message is decoded. The referenced
+/// field should precede the padding, otherwise the value from the previous message is used.
 class RTBinaryMessage : public RTMessage
 {
 public:
@@ -74,10 +81,43 @@ public:
   /// @param buffer The buffer to write to.
   void setMessage(QByteArray &buffer) override;
 
-  /// Read and update values from the @p buffer.
-  /// @param buffer The buffer to read from.
-  /// @return The number of bytes read on success, negative on error. Zero if nothing to read.
-  int readMessage(const QByteArray &buffer) override;
+  /// Read and update values from @p data.
+  /// @param data The data to read from.
+  /// @param size The number of bytes available in @p data.
+  /// @return The number of bytes read on success, negative on error. Zero if nothing to read
+  ///   or the data do not yet hold a complete message.
+  int readMessage(const char *data, size_t size) override;
+
+  /// Build the decode plan from the registered fields.
+  ///
+  /// Called by the @c RealTimeSourceLoader once all fields have been added. Decoding
+  /// compiles the plan as required, should fields be added later.
+  void compile();
+
+  /// Decode a single message from @p data, writing heading values to @p values.
+  ///
+  /// The most recent field values are also retained for @c fieldValueD(), but not
+  /// for @c populateValues().
+  ///
+  /// @param data The message data.
+  /// @param size The number of bytes available in @p data.
+  /// @param[out] values Populated with the heading field values. Must have capacity
+  ///   for @c headings().count() values.
+  /// @return The message size in bytes or zero if @p data does not hold a complete message.
+  size_t decode(const char *data, size_t size, double *values);
+
+  /// Reports the number of headings, as each message decodes a value for each heading.
+  /// @return The @c headings() count.
+  unsigned valueCount() const override;
+
+  /// Read a message via @c decode(), writing the heading values to @p values.
+  /// @param data The data to read from.
+  /// @param size The number of bytes available in @p data.
+  /// @param[out] values Populated with the heading field values. Must have capacity
+  ///   for @c headings().count() values.
+  /// @return The number of bytes read on success. Zero if the data do not yet hold a
+  ///   complete message.
+  int readValues(const char *data, size_t size, double *values) override;
 
   /// Return the list of headings. This is the list of fields marked as headings.
   /// @return The list of fields used as headings.
@@ -88,6 +128,17 @@ public:
   /// @return The number of values written.
   unsigned populateValues(std::vector<double> &values) const override;
 
+  /// Read the sender's timestamp from the latest message.
+  ///
+  /// Unlike the base implementation, @p timeColumn indexes all fields, not just the
+  /// headings, as set by the @c RealTimeSourceLoader for the time field.
+  ///
+  /// @param timeColumn The one-based field index of the time field.
+  /// @param values Ignored.
+  /// @param[out] time Set to the time field value on success.
+  /// @return True if @p timeColumn is a valid field.
+  bool timeValue(unsigned timeColumn, const std::vector<double> &values, double &time) const override;
+
   /// Registers a field.
   /// @param name The field name. May be used as a heading.
   /// @param type The field type.
@@ -101,11 +152,14 @@ public:
   int fieldIndex(const QString &key) const;
 
   /// Requests a field value by name, converting to a double.
+  ///
+  /// This is the most recently decoded value, or the default value before decoding.
+  ///
   /// @param key The field name requested.
   /// @return The field value converted to a double. Returns zero on any failure.
   double fieldValueD(const QString &key) const;
 
-  /// Requests a field value by name, returning a @c QVariant.
+  /// Requests a field's default value, as written by @c setMessage(), by name.
   /// @param key The field name requested.
   /// @return The field value as a @c QVariant. Returns a null value on any failure, but
   ///   a valid field value may also be null.
@@ -128,16 +182,33 @@ private:
   /// @return The number of bytes written.
   uint writeField(QDataStream &stream, const Field &field, uint pos);
 
-  /// Read a field to the data stream.
-  /// @param stream The stream to read from.
-  /// @param field The field to read into.
-  /// @param pos The position in the stream being read. Used for padding calculations.
-  /// @return The number of bytes read.
-  int readField(QDataStream &stream, Field &field, uint pos);
+  /// Function decoding a field value at a known address.
+  typedef double (*DecodeFunc)(const char *data);
+
+  /// A step in the decode plan.
+  ///
+  /// Value steps decode a field at @c offset from the current base position. Padding
+  /// steps which cannot be resolved when compiling move the base position as each
+  /// message is decoded.
+  struct DecodeStep
+  {
+    DecodeFunc decode;  ///< Value decoder. Null for padding steps.
+    FieldType type;     ///< The field type. @c PadTo or @c PadByField for padding steps.
+    unsigned offset;    ///< Byte offset from the current base position.
+    unsigned size;      ///< Field size in bytes, or the padding amount when @c padField is negative.
+    int field;          ///< Index of the field in @c _fields.
+    int heading;        ///< Heading index of the field or -1 if not a heading.
+    int padField;       ///< For padding steps, the field giving the padding amount or -1.
+  };
 
   QVector<Field> _fields;     ///< Message fields.
+  std::vector<DecodeStep> _plan;        ///< The decode plan. Valid when @c _planValid.
+  std::vector<double> _values;          ///< Most recent value of each field.
+  std::vector<double> _headingValues;   ///< Heading values from @c readMessage().
+  unsigned _planTail;         ///< Bytes following the final base position in the plan.
   unsigned _messageMinSize;   ///< Minimum message size based on the @c _fields.
   bool _littleEndian;         ///< Read/write little Endian?
+  bool _planValid;            ///< True when @c _plan reflects the @c _fields.
   QStringList _headings;      ///< Heading fields extracted into a string list.
 };
 
@@ -0,0 +1,60 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "rtclocksync.h"
+
+#include <cmath>
+
+namespace
+{
+  /// Jitter smoothing factor, per RFC 3550.
+  const double JitterGain = 1.0 / 16.0;
+}
+
+
+RTClockSync::RTClockSync(double window)
+  : _windowDuration(window)
+  , _lastTransit(0)
+  , _delay(0)
+  , _jitter(0)
+{
+}
+
+
+void RTClockSync::reset()
+{
+  _window.clear();
+  _lastTransit = 0;
+  _delay = 0;
+  _jitter = 0;
+}
+
+
+double RTClockSync::align(double senderTime, double receiveTime)
+{
+  const double transit = receiveTime - senderTime;
+
+  if (!_window.empty())
+  {
+    _jitter += (std::abs(transit - _lastTransit) - _jitter) * JitterGain;
+  }
+  _lastTransit = transit;
+
+  // Maintain the sliding window minimum: drop candidates which can no longer be the
+  // minimum, then expire those older than the window.
+  while (!_window.empty() && _window.back().transit >= transit)
+  {
+    _window.pop_back();
+  }
+  _window.push_back({ receiveTime, transit });
+  while (_window.front().receiveTime < receiveTime - _windowDuration)
+  {
+    _window.pop_front();
+  }
+
+  const double offset = _window.front().transit;
+  _delay = transit - offset;
+  return senderTime + offset;
+}
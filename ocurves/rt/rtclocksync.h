@@ -0,0 +1,76 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef RTCLOCKSYNC_H_
+#define RTCLOCKSYNC_H_
+
+#include "ocurvesconfig.h"
+
+#include <deque>
+
+/// @ingroup realtime
+/// Maps sender timestamps onto the local receive clock for a real-time source.
+///
+/// The sender and receiver clocks have an unknown offset. Each message yields a
+/// transit time: the receive time less the sender time. This is the clock offset plus
+/// the transmission delay. The delay is never negative, so the minimum transit time
+/// over a recent window is taken as the clock offset estimate. The window allows the
+/// estimate to follow clock drift.
+///
+/// Aligned times preserve the sender's sample spacing, while the difference between
+/// successive transit times measures the delivery jitter. Jitter is estimated as for
+/// RTP interarrival jitter (RFC 3550): a running average of the absolute change in
+/// transit time.
+///
+/// All times are in seconds.
+class RTClockSync
+{
+public:
+  /// Create a clock synchronisation.
+  /// @param window The time window over which the minimum transit time is tracked.
+  RTClockSync(double window = 10.0);
+
+  /// Reset the offset estimate.
+  void reset();
+
+  /// Update the offset estimate and convert @p senderTime to the receive clock.
+  /// @param senderTime The message timestamp from the sender, scaled to seconds.
+  /// @param receiveTime The local time the message was received.
+  /// @return The @p senderTime on the receive clock.
+  double align(double senderTime, double receiveTime);
+
+  /// Has an offset been estimated yet?
+  /// @return True after the first @c align() call.
+  inline bool isValid() const { return !_window.empty(); }
+
+  /// The current clock offset estimate: receive time minus sender time.
+  /// @return The clock offset.
+  inline double offset() const { return (!_window.empty()) ? _window.front().transit : 0.0; }
+
+  /// The transmission delay of the last message beyond the best observed delay.
+  /// @return The latest excess delay.
+  inline double delay() const { return _delay; }
+
+  /// The current jitter estimate.
+  /// @return The smoothed absolute change in transit time between messages.
+  inline double jitter() const { return _jitter; }
+
+private:
+  /// A transit time observation.
+  struct Sample
+  {
+    double receiveTime; ///< When the observation was made.
+    double transit;     ///< Receive time less sender time.
+  };
+
+  /// Candidate minima in the window, ordered by time with increasing transit times.
+  std::deque<Sample> _window;
+  double _windowDuration; ///< The window duration.
+  double _lastTransit;    ///< Transit time of the previous message.
+  double _delay;          ///< Latest excess delay.
+  double _jitter;         ///< Jitter estimate.
+};
+
+#endif // RTCLOCKSYNC_H_
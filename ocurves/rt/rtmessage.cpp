@@ -9,3 +9,27 @@ RTMessage::~RTMessage()
 {
 
 }
+
+
+unsigned RTMessage::valueCount() const
+{
+  return 0;
+}
+
+
+int RTMessage::readValues(const char *, size_t, double *)
+{
+  return -1;
+}
+
+
+bool RTMessage::timeValue(unsigned timeColumn, const std::vector<double> &values, double &time) const
+{
+  if (timeColumn == 0 || timeColumn > values.size())
+  {
+    return false;
+  }
+
+  time = values[timeColumn - 1];
+  return true;
+}
@@ -23,6 +23,9 @@
 /// - @c populateValues() to get the latest values.
 /// - @c headings() to determine the headings
 ///
+/// Messages with a fixed @c valueCount() may instead be read via @c readValues(), which
+/// decodes directly into the caller's storage.
+///
 /// The @c headings() stops once a valid set of headings is returned. This is to support
 /// string based messaging where the number of headings is not given in advance, but
 /// stops requesting headings once known.
@@ -36,10 +39,14 @@ public:
   /// @param buffer The buffer to write to.
   virtual void setMessage(QByteArray &buffer) = 0;
 
-  /// Called to read incoming data from the given buffer.
-  /// @param buffer The buffer to read from.
+  /// Called to read a message from the start of the incoming data.
+  ///
+  /// The data are generally a view into a @c RTReadBuffer and are not retained.
+  ///
+  /// @param data The incoming data to read from.
+  /// @param size The number of bytes available in @p data.
   /// @return The number of bytes read on success, negative on error. Zero if nothing to read.
-  virtual int readMessage(const QByteArray &buffer) = 0;
+  virtual int readMessage(const char *data, size_t size) = 0;
 
   /// Request the list of headings for the plot.
   /// @return The headings or an empty list if not yet known.
@@ -53,6 +60,38 @@ public:
   /// @param values Resized and populated to the latest values set.
   /// @return The number of values available.
   virtual unsigned populateValues(std::vector<double> &values) const = 0;
+
+  /// Query the number of values each message decodes to via @c readValues().
+  ///
+  /// The default implementation returns zero, as the count is not known in advance.
+  /// @return The value count, or zero if @c readValues() is not supported.
+  virtual unsigned valueCount() const;
+
+  /// Read a message from the start of the incoming data, decoding the values directly to
+  /// @p values instead of retaining them for @c populateValues(). Requires a non-zero
+  /// @c valueCount().
+  ///
+  /// Supporting messages must implement @c timeValue() without reference to its values.
+  ///
+  /// The default implementation is not supported and returns -1.
+  ///
+  /// @param data The incoming data to read from.
+  /// @param size The number of bytes available in @p data.
+  /// @param[out] values Populated with the message values. Must have capacity for
+  ///   @c valueCount() values. May be modified even if no complete message is read.
+  /// @return The number of bytes read on success, negative on error. Zero if nothing to read.
+  virtual int readValues(const char *data, size_t size, double *values);
+
+  /// Read the sender's timestamp for the latest message.
+  ///
+  /// The default implementation treats @p timeColumn as an index into the @p values
+  /// from @c populateValues().
+  ///
+  /// @param timeColumn The one-based time column. See @c RealTimeCommSpec::timeColumn().
+  /// @param values The latest values, as populated by @c populateValues().
+  /// @param[out] time Set to the unscaled time value on success.
+  /// @return True if the message has a value for @p timeColumn.
+  virtual bool timeValue(unsigned timeColumn, const std::vector<double> &values, double &time) const;
 };
 
 
@@ -0,0 +1,102 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "rtreadbuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+RTReadBuffer::RTReadBuffer(size_t capacity)
+  : _buffer(capacity)
+  , _clock(nullptr)
+  , _firstChunk(0)
+  , _readPos(0)
+  , _writePos(0)
+{
+}
+
+
+void RTReadBuffer::consume(size_t byteCount)
+{
+  _readPos += std::min(byteCount, size());
+  if (_readPos == _writePos)
+  {
+    // Empty. Rewind for free.
+    clear();
+    return;
+  }
+
+  while (_firstChunk < _chunks.size() && _chunks[_firstChunk].end <= _readPos)
+  {
+    ++_firstChunk;
+  }
+}
+
+
+char *RTReadBuffer::reserve(size_t byteCount)
+{
+  if (_buffer.size() - _writePos < byteCount)
+  {
+    // Move the unread data to the front to make space.
+    const size_t unread = size();
+    if (_readPos)
+    {
+      memmove(_buffer.data(), _buffer.data() + _readPos, unread);
+      // Drop the read chunks and rebase the remainder.
+      _chunks.erase(_chunks.begin(), _chunks.begin() + _firstChunk);
+      _firstChunk = 0;
+      for (Chunk &chunk : _chunks)
+      {
+        chunk.end -= _readPos;
+      }
+      _readPos = 0;
+      _writePos = unread;
+    }
+
+    if (_buffer.size() - _writePos < byteCount)
+    {
+      _buffer.resize(std::max(_writePos + byteCount, _buffer.size() * 2));
+    }
+  }
+
+  return _buffer.data() + _writePos;
+}
+
+
+void RTReadBuffer::commit(size_t byteCount)
+{
+  const size_t writePos = std::min(_writePos + byteCount, _buffer.size());
+  if (writePos > _writePos)
+  {
+    const double time = (_clock) ? 1e-9 * _clock->nsecsElapsed() : 0.0;
+    if (!_chunks.empty() && _chunks.back().time == time)
+    {
+      _chunks.back().end = writePos;
+    }
+    else
+    {
+      _chunks.push_back({ writePos, time });
+    }
+    _writePos = writePos;
+  }
+}
+
+
+void RTReadBuffer::append(const char *bytes, size_t byteCount)
+{
+  if (byteCount)
+  {
+    memcpy(reserve(byteCount), bytes, byteCount);
+    commit(byteCount);
+  }
+}
+
+
+void RTReadBuffer::clear()
+{
+  _readPos = _writePos = 0;
+  _chunks.clear();
+  _firstChunk = 0;
+}
@@ -0,0 +1,107 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef RTREADBUFFER_H_
+#define RTREADBUFFER_H_
+
+#include "ocurvesconfig.h"
+
+#include <QElapsedTimer>
+
+#include <cstddef>
+#include <vector>
+
+/// @ingroup realtime
+/// A reusable receive buffer for real-time connections, with a read cursor.
+///
+/// Incoming data are appended at the end of the buffer, either by @c append(), or by
+/// writing directly to the memory returned by @c reserve() then calling @c commit().
+/// Data are read from @c data() and removed by @c consume(), which simply advances
+/// the read cursor. Unread data are moved to the front of the buffer only when more
+/// space is required for new data, so the cost of consuming many small messages is
+/// linear in the number of bytes received.
+///
+/// The unread data are always contiguous, so @c RTMessage implementations can decode
+/// directly from @c data(). The buffer memory is retained between reads and is only
+/// reallocated when the unread data exceeds the current capacity.
+///
+/// Each @c commit() is timestamped from the @c setClock() timer, so data received in a
+/// single read call, such as several datagrams, keep their individual receive times.
+/// The @c receiveTime() is that of the chunk holding the first unread byte, which is the
+/// start of the next message.
+class RTReadBuffer
+{
+public:
+  /// Create a buffer with the given initial capacity.
+  /// @param capacity The initial capacity (bytes).
+  RTReadBuffer(size_t capacity = 0);
+
+  /// Access the unread data.
+  /// @return A pointer to the first unread byte.
+  inline const char *data() const { return _buffer.data() + _readPos; }
+
+  /// Query the number of unread bytes.
+  /// @return The number of bytes available at @c data().
+  inline size_t size() const { return _writePos - _readPos; }
+
+  /// Is the buffer empty of unread data?
+  /// @return True if there are no unread bytes.
+  inline bool empty() const { return _writePos == _readPos; }
+
+  /// Set the clock used to timestamp committed data. The clock must outlive the buffer.
+  /// @param clock The receive clock. Null to record zero times.
+  inline void setClock(const QElapsedTimer *clock) { _clock = clock; }
+
+  /// Query the receive time of the first unread byte, as recorded by @c commit().
+  /// @return The receive time (seconds since the clock started), or zero when empty.
+  inline double receiveTime() const { return (_firstChunk < _chunks.size()) ? _chunks[_firstChunk].time : 0.0; }
+
+  /// Query the buffer capacity.
+  /// @return The buffer capacity (bytes).
+  inline size_t capacity() const { return _buffer.size(); }
+
+  /// Mark @p byteCount bytes as read, removing them from the front of the buffer.
+  /// @param byteCount The number of bytes to consume. Clamped to @c size().
+  void consume(size_t byteCount);
+
+  /// Ensure space for @p byteCount additional bytes and return the write location.
+  ///
+  /// Data written are not visible until @c commit() is called. The returned pointer
+  /// is invalidated by any other non-const call.
+  ///
+  /// @param byteCount The number of bytes to write.
+  /// @return The address at which to write up to @p byteCount bytes.
+  char *reserve(size_t byteCount);
+
+  /// Commit bytes written to the memory returned by @c reserve(), timestamping them with
+  /// the current time of the @c setClock() timer.
+  /// @param byteCount The number of bytes written. Must not exceed the reserved amount.
+  void commit(size_t byteCount);
+
+  /// Append @p byteCount bytes from @p bytes.
+  /// @param bytes The data to append.
+  /// @param byteCount The number of bytes to append.
+  void append(const char *bytes, size_t byteCount);
+
+  /// Discard all unread data. The memory is retained.
+  void clear();
+
+private:
+  /// A range of committed bytes and their receive time.
+  struct Chunk
+  {
+    size_t end;   ///< Offset beyond the last byte of the chunk in @c _buffer.
+    double time;  ///< Receive time (seconds).
+  };
+
+  std::vector<char> _buffer;  ///< Buffer memory.
+  std::vector<Chunk> _chunks; ///< Committed chunks in order. Those before @c _firstChunk are read.
+  const QElapsedTimer *_clock;  ///< Timestamps commits. May be null.
+  size_t _firstChunk;         ///< Index of the chunk holding the first unread byte.
+  size_t _readPos;            ///< Offset of the first unread byte.
+  size_t _writePos;           ///< Offset beyond the last unread byte.
+};
+
+#endif // RTREADBUFFER_H_
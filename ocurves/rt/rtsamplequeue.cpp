@@ -0,0 +1,117 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "rtsamplequeue.h"
+
+#include "plotinstance.h"
+
+#include <algorithm>
+
+RTSampleQueue::RTSampleQueue(const PlotSource::Ptr &source, unsigned columnCount, size_t capacity)
+  : _source(source)
+  , _mask(1)
+  , _rowStride(HeaderSize + columnCount)
+  , _columnCount(columnCount)
+  , _writeIndex(0)
+  , _readIndex(0)
+  , _dropped(0)
+{
+  size_t rows = 2;
+  while (rows < capacity)
+  {
+    rows <<= 1;
+  }
+  _mask = rows - 1;
+  _rows.resize(rows * _rowStride);
+}
+
+
+size_t RTSampleQueue::count() const
+{
+  const size_t readIndex = _readIndex.load(std::memory_order_acquire);
+  return _writeIndex.load(std::memory_order_acquire) - readIndex;
+}
+
+
+bool RTSampleQueue::push(double time, const double *values, unsigned valueCount)
+{
+  double *rowValues = reserveRow();
+  if (!rowValues)
+  {
+    _dropped.store(_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return false;
+  }
+
+  valueCount = std::min(valueCount, _columnCount);
+  std::copy(values, values + valueCount, rowValues);
+  commitRow(time, valueCount);
+  return true;
+}
+
+
+double *RTSampleQueue::reserveRow()
+{
+  const size_t writeIndex = _writeIndex.load(std::memory_order_relaxed);
+  if (writeIndex - _readIndex.load(std::memory_order_acquire) > _mask)
+  {
+    return nullptr;
+  }
+
+  return row(writeIndex) + HeaderSize;
+}
+
+
+void RTSampleQueue::commitRow(double time, unsigned valueCount)
+{
+  const size_t writeIndex = _writeIndex.load(std::memory_order_relaxed);
+  double *row = this->row(writeIndex);
+  row[0] = time;
+  row[1] = std::min(valueCount, _columnCount);
+
+  // Publish the row.
+  _writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+
+size_t RTSampleQueue::migrate()
+{
+  const size_t readIndex = _readIndex.load(std::memory_order_relaxed);
+  const size_t rowCount = _writeIndex.load(std::memory_order_acquire) - readIndex;
+  if (!rowCount)
+  {
+    return 0;
+  }
+
+  // Gather each column across all rows and add to the curve in one call.
+  const unsigned columnCount = std::min(_columnCount, _source->curveCount());
+  _points.reserve(rowCount);
+  for (unsigned c = 0; c < columnCount; ++c)
+  {
+    PlotInstance *curve = _source->curve(c);
+    if (!curve)
+    {
+      continue;
+    }
+
+    _points.clear();
+    for (size_t r = 0; r < rowCount; ++r)
+    {
+      const double *row = this->row(readIndex + r);
+      if (c < unsigned(row[1]))
+      {
+        _points.push_back(QPointF(row[0], row[HeaderSize + c]));
+      }
+    }
+
+    if (!_points.empty())
+    {
+      curve->addPoints(_points.data(), _points.size());
+    }
+  }
+
+  // Release the rows back to the producer.
+  _readIndex.store(readIndex + rowCount, std::memory_order_release);
+  return rowCount;
+}
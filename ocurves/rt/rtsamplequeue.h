@@ -0,0 +1,118 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef RTSAMPLEQUEUE_H_
+#define RTSAMPLEQUEUE_H_
+
+#include "ocurvesconfig.h"
+
+#include "plotsource.h"
+
+#include <QPointF>
+
+#include <atomic>
+#include <vector>
+
+/// @ingroup realtime
+/// A lock free, single producer, single consumer queue of decoded real-time samples.
+///
+/// The queue carries sample rows for a single @c PlotSource from a connection's reader
+/// thread (the producer) to the main thread (the consumer). Each row holds a sample
+/// time and a value for each column of the source, where column @c i maps to
+/// @c PlotSource::curve(i).
+///
+/// The producer calls @c push() for each decoded message, or decodes directly into the
+/// queue via @c reserveRow() and @c commitRow(). Rows are dropped when the queue is full,
+/// as tracked by @c dropped(). The consumer periodically calls
+/// @c migrate() to move all queued rows into the curves of the source in bulk. This
+/// is driven by @c Curves::migrateLoadingData(), so each curve is locked once per
+/// update, rather than once per sample.
+///
+/// The queue is a fixed size ring buffer indexed by monotonic read and write counters.
+/// No locks are required so long as there is at most one thread calling @c push() and
+/// one thread calling @c migrate().
+class RTSampleQueue
+{
+public:
+  /// Create a queue for @p source.
+  /// @param source The source to migrate samples into.
+  /// @param columnCount The number of values in each row.
+  /// @param capacity The maximum number of rows held. Rounded up to a power of two.
+  RTSampleQueue(const PlotSource::Ptr &source, unsigned columnCount, size_t capacity);
+
+  /// Access the target source.
+  /// @return The source to migrate samples into.
+  inline const PlotSource::Ptr &source() const { return _source; }
+
+  /// Query the number of values in each row.
+  /// @return The column count.
+  inline unsigned columnCount() const { return _columnCount; }
+
+  /// Query the maximum number of rows the queue can hold.
+  /// @return The row capacity.
+  inline size_t capacity() const { return _mask + 1; }
+
+  /// Query the number of rows dropped because the queue was full. Thread safe.
+  /// @return The dropped row count.
+  inline quint64 dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+  /// Query the number of rows awaiting migration. Thread safe, but only a snapshot.
+  /// @return The number of queued rows.
+  size_t count() const;
+
+  /// Push a sample row. Producer thread only.
+  ///
+  /// Up to @c columnCount() @p values are queued. Curves beyond @p valueCount receive
+  /// no sample for this row.
+  ///
+  /// @param time The sample time for all values.
+  /// @param values The column values.
+  /// @param valueCount The number of elements in @p values.
+  /// @return True if the row was queued, false if the queue is full and the row dropped.
+  bool push(double time, const double *values, unsigned valueCount);
+
+  /// Access the value storage of the next row, so values may be decoded in place. Producer
+  /// thread only.
+  ///
+  /// The row is not queued until @c commitRow(). A full queue does not count as a drop
+  /// until a row is @c push()ed.
+  ///
+  /// @return Storage for @c columnCount() values, or null if the queue is full.
+  double *reserveRow();
+
+  /// Queue the row written to the storage from @c reserveRow(). Producer thread only.
+  /// @param time The sample time for all values.
+  /// @param valueCount The number of values written. Clamped to @c columnCount().
+  void commitRow(double time, unsigned valueCount);
+
+  /// Migrate all queued rows into the curves of the @c source(). Consumer thread only.
+  ///
+  /// Samples are added to each curve via @c PlotInstance::addPoints(), ready for
+  /// @c PlotInstance::migrateBuffer().
+  ///
+  /// @return The number of rows migrated.
+  size_t migrate();
+
+private:
+  /// Row header entries preceding the values: the time and the value count.
+  enum { HeaderSize = 2 };
+
+  /// Access the storage for row @p index.
+  /// @param index A read or write counter value.
+  /// @return The row storage.
+  inline double *row(size_t index) { return _rows.data() + (index & _mask) * _rowStride; }
+
+  PlotSource::Ptr _source;          ///< Target source.
+  std::vector<double> _rows;        ///< Row storage: time, value count then values.
+  std::vector<QPointF> _points;     ///< Working buffer for @c migrate().
+  size_t _mask;                     ///< Capacity mask.
+  size_t _rowStride;                ///< Number of elements in each row.
+  unsigned _columnCount;            ///< Number of values in each row.
+  std::atomic<size_t> _writeIndex;  ///< Number of rows pushed. Written by the producer.
+  std::atomic<size_t> _readIndex;   ///< Number of rows migrated. Written by the consumer.
+  std::atomic<quint64> _dropped;    ///< Number of rows dropped. Written by the producer.
+};
+
+#endif // RTSAMPLEQUEUE_H_
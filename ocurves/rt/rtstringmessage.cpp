@@ -5,7 +5,9 @@
 //
 #include "rtstringmessage.h"
 
-#include "plotfile.h"
+#include "plotfilemap.h"
+
+#include <cstring>
 
 
 RTStringMessage::RTStringMessage(const QString &message)
@@ -20,20 +22,19 @@ void RTStringMessage::setMessage(QByteArray &buffer)
 }
 
 
-int RTStringMessage::readMessage(const QByteArray &buffer)
+int RTStringMessage::readMessage(const char *data, size_t size)
 {
   // Read up to a newline.
-  for (int i = 0; i < buffer.size(); ++i)
+  const char *newline = static_cast<const char *>(memchr(data, '\n', size));
+  if (!newline)
   {
-    if (buffer.at(i) == '\n')
-    {
-      _message = QString(buffer.left(i + 1));
-      return i + 1;
-    }
+    // No newline. Nothing read.
+    return 0;
   }
 
-  // No newline. Nothing read.
-  return 0;
+  const size_t lineLength = size_t(newline - data) + 1;
+  _line.assign(data, data + lineLength);
+  return int(lineLength);
 }
 
 
@@ -46,9 +47,16 @@ QStringList RTStringMessage::headings() const
 
 unsigned RTStringMessage::populateValues(std::vector<double> &values) const
 {
-  // Parse the current message.
-  QString line = _message;
-  PlotFile::dataLine(line, values, false);
+  // Parse the current message. Reparse should there be more values than expected.
+  const char *begin = _line.data();
+  const char *end = begin + _line.size();
+  unsigned count = PlotFileMap::parseLine(begin, end, values.data(), unsigned(values.size()));
+  if (count > values.size())
+  {
+    values.resize(count);
+    PlotFileMap::parseLine(begin, end, values.data(), count);
+  }
+  values.resize(count);
   if (_headings.empty())
   {
     for (size_t i = 0; i < values.size(); ++i)
@@ -12,11 +12,13 @@
 
 #include <QString>
 
+#include <vector>
+
 /// @ingroup realtime
 /// Represents a string based message for real-time data plots.
 ///
 /// A string message is simply parsed as a delimited value string. Parsing
-/// matches that used for file loading; @c PlotFile::dataLine().
+/// matches that used for file loading; @c PlotFileMap::parseLine().
 ///
 /// A real time source does not expect heading names, and by default simply
 /// labels values "Column 1", "Column 2", etc. This can be overridden by
@@ -36,10 +38,15 @@ public:
   /// @param buffer to populate.
   void setMessage(QByteArray &buffer) override;
 
-  /// Read incoming message data. Simply converted to string.
-  /// @param buffer The buffer to convert.
-  /// @return The number of bytes read on success, negative on error. Zero if nothing to read.
-  int readMessage(const QByteArray &buffer) override;
+  /// Read incoming message data up to and including the next newline.
+  ///
+  /// The line is retained for @c populateValues() without string conversion.
+  ///
+  /// @param data The data to read from.
+  /// @param size The number of bytes available in @p data.
+  /// @return The number of bytes read on success, negative on error. Zero if there is no
+  ///   complete line to read.
+  int readMessage(const char *data, size_t size) override;
 
   /// Set the headings.
   /// @param headings The new headings.
@@ -55,7 +62,8 @@ public:
   /// Data access request for the latest data.
   ///
   /// This parses the current message, as read by the last @c readMessage()
-  /// call. The headings are populate, if not set, to a numerical sequence
+  /// call. Values are parsed using the C locale, as for @c PlotFile::dataLine().
+  /// The headings are populate, if not set, to a numerical sequence
   /// 'Column #' to match the number of incoming values.
   ///
   /// @param values Populated with the latest data set.
@@ -63,7 +71,8 @@ public:
   unsigned populateValues(std::vector<double> &values) const override;
 
 protected:
-  QString _message; ///< Message to send, or last read.
+  QString _message; ///< Message to send.
+  std::vector<char> _line;  ///< Last line read. The memory is reused for each line.
   mutable QStringList _headings;  ///< Cached headings.
 };
 
@@ -27,6 +27,7 @@
 #include "plotview.h"
 #include "plotviewtoolbar.h"
 #include "plotzoomer.h"
+#include "realtimeexpressions.h"
 #include "realtimeplot.h"
 #include "splitplotview.h"
 #include "toolbarwidgets.h"
@@ -73,8 +74,13 @@ OCurvesUI::OCurvesUI(QWidget *parent)
   , _expressions(new Expressions)
   , _timeSinceLastPlot(new QElapsedTimer)
   , _streams(nullptr)
+  , _realTimeExpressions(nullptr)
   , _properties(nullptr)
   , _activeBookmark(0)
+  , _mappedLoad(true)
+  , _useFileCache(true)
+  , _resamplePolicy(PlotResampler::Linear)
+  , _nativeTimes(false)
 {
   _timeSinceLastPlot->start();
   _ui->setupUi(this);
@@ -101,6 +107,8 @@ OCurvesUI::OCurvesUI(QWidget *parent)
     viewAdded(_splitView->activeView());
   }
 
+  _realTimeExpressions = new RealTimeExpressions(_curves, this);
+
   _properties = new CurveProperties(_curves, _ui->propertiesDock);
   _ui->propertiesDock->setWidget(_properties);
   _ui->propertiesDock->close();
@@ -132,6 +140,7 @@ OCurvesUI::OCurvesUI(QWidget *parent)
   connect(_ui->actionSplitRemove, &QAction::triggered, _splitView, &SplitPlotView::splitRemove);
   connect(_ui->actionSplitRemoveAll, &QAction::triggered, _splitView, &SplitPlotView::splitRemoveAll);
   connect(_ui->actionCopyActiveView, &QAction::triggered, this, &OCurvesUI::copyActiveView);
+  connect(_ui->actionBackgroundRender, &QAction::toggled, this, &OCurvesUI::setBackgroundRender);
   connect(_ui->actionExportBookmarks, &QAction::triggered, this, &OCurvesUI::exportBookmarks);
   connect(_ui->actionImportBookmarks, &QAction::triggered, this, &OCurvesUI::importBookmarks);
   connect(_ui->actionRestoreLastSession, &QAction::triggered, this, &OCurvesUI::restoreLastSession);
@@ -193,6 +202,7 @@ OCurvesUI::~OCurvesUI()
   endStreams();
   stopLoad();
   clearCurves();
+  delete _realTimeExpressions;
   delete _expressions;
   delete _plotsContextMenu;
   delete _sourcesContextMenu;
@@ -218,6 +228,23 @@ void OCurvesUI::loadSettings(QSettings &settings, bool loadGeometry)
   _toolbarWidgets->maxSamplesSpin()->setValue(settings.value("targetSamples", 20000).toUInt());
   _toolbarWidgets->timeScaleEdit()->setText(QString("%1").arg(settings.value("timeScale", 1).toDouble()));
   _toolbarWidgets->relativeTimeCheck()->setChecked(settings.value("relativeTime", "false").toBool());
+  _mappedLoad = settings.value("mapped", "true").toBool();
+  _useFileCache = settings.value("cache", "true").toBool();
+  if (!PlotSampleEncoding::typeFromName(settings.value("encoding", "double").toString(), _sampleEncoding.type))
+  {
+    _sampleEncoding.type = PlotSampleEncoding::Double;
+  }
+  _sampleEncoding.scale = settings.value("encodingScale", 1.0).toDouble();
+  if (_sampleEncoding.scale == 0)
+  {
+    _sampleEncoding.scale = 1;
+  }
+  _sampleEncoding.offset = settings.value("encodingOffset", 0.0).toDouble();
+  if (!PlotResampler::policyFromName(settings.value("resample", "linear").toString(), _resamplePolicy))
+  {
+    _resamplePolicy = PlotResampler::Linear;
+  }
+  _nativeTimes = settings.value("nativeTimes", "false").toBool();
   settings.endGroup(); // load
 
   settings.beginGroup("stream");
@@ -226,6 +253,7 @@ void OCurvesUI::loadSettings(QSettings &settings, bool loadGeometry)
   settings.endGroup(); // stream
 
   settings.beginGroup("plot");
+  _ui->actionBackgroundRender->setChecked(settings.value("backgroundRender", "false").toBool());
   QString coloursString = settings.value("colours", "").toString();
   _colours.clear();
   if (!coloursString.isEmpty())
@@ -289,6 +317,13 @@ void OCurvesUI::saveSettings(QSettings &settings, bool bookmarkCurrent)
   settings.setValue("targetSamples", _toolbarWidgets->maxSamplesSpin()->value());
   settings.setValue("timeScale", _toolbarWidgets->timeScaleEdit()->text());
   settings.setValue("relativeTime", _toolbarWidgets->relativeTimeCheck()->isChecked());
+  settings.setValue("mapped", _mappedLoad);
+  settings.setValue("cache", _useFileCache);
+  settings.setValue("encoding", PlotSampleEncoding::typeName(_sampleEncoding.type));
+  settings.setValue("encodingScale", _sampleEncoding.scale);
+  settings.setValue("encodingOffset", _sampleEncoding.offset);
+  settings.setValue("resample", PlotResampler::policyName(_resamplePolicy));
+  settings.setValue("nativeTimes", _nativeTimes);
   settings.endGroup(); // load
 
   settings.beginGroup("stream");
@@ -297,6 +332,7 @@ void OCurvesUI::saveSettings(QSettings &settings, bool bookmarkCurrent)
   settings.endGroup(); // stream
 
   settings.beginGroup("plot");
+  settings.setValue("backgroundRender", _ui->actionBackgroundRender->isChecked());
   if (!_colours.empty())
   {
     QString coloursString;
@@ -357,6 +393,9 @@ void OCurvesUI::load(const QStringList &plotFiles, bool append, QVector<TimeSamp
 
   PlotFileLoader *fileLoader = new PlotFileLoader(_curves, plotFiles, plotTiming);
   fileLoader->setTargetSampleCount(_toolbarWidgets->maxSamplesSpin()->value());
+  fileLoader->setLoadMode((_mappedLoad) ? PlotFileLoader::LoadMapped : PlotFileLoader::LoadStream);
+  fileLoader->setUseCache(_useFileCache);
+  fileLoader->setSampleEncoding(_sampleEncoding);
   activateLoader(fileLoader, PLA_GenerateExpressions);
 }
 
@@ -507,6 +546,17 @@ void OCurvesUI::copyActiveView()
 }
 
 
+void OCurvesUI::setBackgroundRender(bool enable)
+{
+  QVector<PlotView *> views;
+  _splitView->collate(views);
+  for (PlotView *view : views)
+  {
+    view->setBackgroundRender(enable);
+  }
+}
+
+
 void OCurvesUI::editColours()
 {
   ColoursView coloursView;
@@ -635,77 +685,48 @@ void OCurvesUI::curveLoadingComplete()
 
 void OCurvesUI::sourceDataChanged(const PlotSource *source)
 {
-  // Look for explicit time expressions in this source.
-  QList<const PlotExpression *> regenExpressions;
+  // Look for explicit time expressions using this source's data. Curves in this source
+  // depend on the changed time values, as do any curves generated from its curves with
+  // explicit time.
+  QList<const PlotInstance *> sourceCurves;
   for (unsigned i = 0; i < source->curveCount(); ++i)
   {
-    const PlotInstance *curve = source->curve(i);
-    if (curve && curve->explicitTime() && curve->expression())
+    if (const PlotInstance *curve = source->curve(i))
     {
-      regenExpressions << curve->expression();
+      sourceCurves << curve;
     }
   }
 
-  // Remove all curves using the collated expressions.
-  for (const PlotExpression *exp : regenExpressions)
+  QList<const PlotInstance *> roots;
+  for (const PlotInstance *curve : sourceCurves)
   {
-    _curves->removeUsingExpression(exp);
+    if (curve->explicitTime() && curve->expression())
+    {
+      roots << curve;
+    }
   }
 
-  if (!regenExpressions.empty())
+  for (const PlotInstance *curve : _curves->dependents(sourceCurves))
   {
-    bool createGenerator = false;
-    bool regenAll = false;
-    if (PlotExpressionGenerator *expressionGenerator = qobject_cast<PlotExpressionGenerator *>(_loader))
+    if (curve->explicitTime() && !roots.contains(curve))
     {
-      // Add to the current generator.
-      switch (expressionGenerator->addExpressions(regenExpressions))
-      {
-      case PlotExpressionGenerator::AER_QueuedPartial:
-        regenAll = true;  // Regenerate all expressions to be sure.
-      // No break.
-        // FALLTHROUGH
-
-      case PlotExpressionGenerator::AER_AlreadyComplete:
-      default:
-        // Failed to queue all expressions or unknown state.
-        // Trigger restart of expression generation.
-        createGenerator = true;
-        break;
-
-      case PlotExpressionGenerator::AER_Queued:
-        createGenerator = false;
-        break;
-      }
-      createGenerator = !expressionGenerator->addExpressions(regenExpressions);
-    }
-    else if (_loader)
-    {
-      // Ensure we will regenerate expressions.
-      _postLoaderAction = PLA_GenerateExpressions;
-    }
-    else
-    {
-      createGenerator = true;
+      roots << curve;
     }
+  }
 
-    if (createGenerator)
+  // Regenerate the affected curves and anything derived from them. Other expression curves
+  // are left intact.
+  QList<PlotInstance *> regenCurves = _curves->dependents(roots);
+  for (const PlotInstance *curve : roots)
+  {
+    PlotInstance *c = const_cast<PlotInstance *>(curve);
+    if (!regenCurves.contains(c))
     {
-      // Need to create a new PlotExpressionGenerator and install it now.
-      QStringList sourceFiles;
-      _curves->enumerateFileSources(sourceFiles);
-      PlotGenerator *newLoader;
-      if (!regenAll)
-      {
-        newLoader = new PlotExpressionGenerator(_curves, regenExpressions, sourceFiles);
-      }
-      else
-      {
-        newLoader = new PlotExpressionGenerator(_curves, _expressions->expressions(), sourceFiles);
-      }
-      activateLoader(newLoader, PLA_CheckExpressions);
+      regenCurves << c;
     }
   }
+
+  regenerateCurves(regenCurves);
 }
 
 
@@ -724,6 +745,12 @@ void OCurvesUI::loadComplete(int curveCount)
 
   if (nextAction == PLA_GenerateExpressions && !_expressions->expressions().isEmpty())
   {
+    // Ensure the expression generator copies the full resolution data rather than any
+    // file preview awaiting migration.
+    if (_curves->migrateLoadingData())
+    {
+      replot();
+    }
     QStringList sourceFiles;
     _curves->enumerateFileSources(sourceFiles);
     PlotGenerator *newLoader = new PlotExpressionGenerator(_curves, _expressions->expressions(), sourceFiles);
@@ -736,6 +763,7 @@ void OCurvesUI::loadComplete(int curveCount)
     // Iterate the generated plots. Remove any which are no longer in _expressions.
     // Must duplicate the curve list because we'll be modifying the curves object.
     QList<PlotInstance *> curveList = _curves->curves().list();
+    QList<const PlotInstance *> deadCurves;
     for (auto iter = curveList.begin(); iter != curveList.end(); ++iter)
     {
       PlotInstance *curve = *iter;
@@ -744,14 +772,24 @@ void OCurvesUI::loadComplete(int curveCount)
         // Expression based curve. Is it still valid?
         if (!_expressions->contains(curve->expression()))
         {
-          // Dead expression. Remove the plot.
-          _curves->removeCurve(curve);
-          curve = nullptr;  // Clear dead pointer.
-          refreshPlots = true;
+          deadCurves << curve;
         }
       }
     }
 
+    // Regenerate live curves derived from the dead curves.
+    QList<PlotInstance *> dependents = _curves->dependents(deadCurves);
+    for (const PlotInstance *curve : deadCurves)
+    {
+      PlotInstance *c = const_cast<PlotInstance *>(curve);
+      dependents.removeAll(c);
+      // Dead expression. Remove the plot.
+      c->source().removeCurve(c);
+      _curves->removeCurve(c);
+      refreshPlots = true;
+    }
+    regenerateCurves(dependents);
+
     if (refreshPlots)
     {
       populatePlotsList();
@@ -868,6 +906,9 @@ void OCurvesUI::plotsSelectOnlyCurrent()
 
 void OCurvesUI::expressionAdded(PlotExpression *expression)
 {
+  // Evaluate over real-time curves as data arrive. The generators skip these curves.
+  _realTimeExpressions->addExpression(expression);
+
   if (PlotExpressionGenerator *expressionLoader = qobject_cast<PlotExpressionGenerator *>(_loader))
   {
     if (expressionLoader->addExpression(expression))
@@ -901,6 +942,8 @@ void OCurvesUI::expressionAdded(PlotExpression *expression)
 
 void OCurvesUI::expressionRemoved(const PlotExpression *expression)
 {
+  _realTimeExpressions->removeExpression(expression);
+
   bool canRemoveNow = true;
   if (PlotExpressionGenerator *expressionLoader = qobject_cast<PlotExpressionGenerator *>(_loader))
   {
@@ -914,8 +957,20 @@ void OCurvesUI::expressionRemoved(const PlotExpression *expression)
 
   if (canRemoveNow)
   {
+    // Curves generated from the expression's curves must be regenerated.
+    QList<const PlotInstance *> removedCurves;
+    for (const PlotInstance *curve : _curves->curves())
+    {
+      if (curve->expression() == expression)
+      {
+        removedCurves << curve;
+      }
+    }
+    QList<PlotInstance *> dependents = _curves->dependents(removedCurves);
+
     if (_curves->removeUsingExpression(expression))
     {
+      regenerateCurves(dependents);
       populatePlotsList();
       updateSelectedPlots();
       recolourCurves();
@@ -924,6 +979,88 @@ void OCurvesUI::expressionRemoved(const PlotExpression *expression)
 }
 
 
+void OCurvesUI::regenerateCurves(const QList<PlotInstance *> &curves)
+{
+  // Collate the expressions to regenerate before removing the curves.
+  QList<const PlotExpression *> regenExpressions;
+  for (const PlotInstance *curve : curves)
+  {
+    const PlotExpression *expression = curve->expression();
+    if (expression && _expressions->contains(expression) && !regenExpressions.contains(expression))
+    {
+      regenExpressions << expression;
+    }
+  }
+
+  // Remove only the given curves. The generator skips the remaining curves of each expression.
+  for (PlotInstance *curve : curves)
+  {
+    curve->source().removeCurve(curve);
+    _curves->removeCurve(curve);
+  }
+
+  generateExpressions(regenExpressions);
+}
+
+
+void OCurvesUI::generateExpressions(const QList<const PlotExpression *> &regenExpressions)
+{
+  if (!regenExpressions.empty())
+  {
+    bool createGenerator = false;
+    bool regenAll = false;
+    if (PlotExpressionGenerator *expressionGenerator = qobject_cast<PlotExpressionGenerator *>(_loader))
+    {
+      // Add to the current generator.
+      switch (expressionGenerator->addExpressions(regenExpressions))
+      {
+      case PlotExpressionGenerator::AER_QueuedPartial:
+        regenAll = true;  // Regenerate all expressions to be sure.
+      // No break.
+        // FALLTHROUGH
+
+      case PlotExpressionGenerator::AER_AlreadyComplete:
+      default:
+        // Failed to queue all expressions or unknown state.
+        // Trigger restart of expression generation.
+        createGenerator = true;
+        break;
+
+      case PlotExpressionGenerator::AER_Queued:
+        createGenerator = false;
+        break;
+      }
+    }
+    else if (_loader)
+    {
+      // Ensure we will regenerate expressions.
+      _postLoaderAction = PLA_GenerateExpressions;
+    }
+    else
+    {
+      createGenerator = true;
+    }
+
+    if (createGenerator)
+    {
+      // Need to create a new PlotExpressionGenerator and install it now.
+      QStringList sourceFiles;
+      _curves->enumerateFileSources(sourceFiles);
+      PlotGenerator *newLoader;
+      if (!regenAll)
+      {
+        newLoader = new PlotExpressionGenerator(_curves, regenExpressions, sourceFiles);
+      }
+      else
+      {
+        newLoader = new PlotExpressionGenerator(_curves, _expressions->expressions(), sourceFiles);
+      }
+      activateLoader(newLoader, PLA_CheckExpressions);
+    }
+  }
+}
+
+
 void OCurvesUI::setupToolbars()
 {
   // Initialise the main toolbar.
@@ -1296,6 +1433,12 @@ void OCurvesUI::activateLoader(PlotGenerator *newLoader, PostLoaderAction nextAc
   _loader = newLoader;
   setTimeControls(_loader);
 
+  if (PlotExpressionGenerator *expressionGenerator = qobject_cast<PlotExpressionGenerator *>(_loader))
+  {
+    expressionGenerator->setResamplePolicy(_resamplePolicy);
+    expressionGenerator->setNativeTimes(_nativeTimes);
+  }
+
   LoadProgress *progress = new LoadProgress();
   this->statusBar()->layout()->addWidget(progress);
   connectLoader(_loader, progress);
@@ -1328,6 +1471,7 @@ void OCurvesUI::viewAdded(PlotView *view)
 {
   connect(view->plot(), &QwtPlot::legendDataChanged, _legend, &QwtLegend::updateLegend);
   connect(view, &PlotView::legendChanged, this, &OCurvesUI::viewLegendChanged);
+  view->setBackgroundRender(_ui->actionBackgroundRender->isChecked());
 }
 
 
@@ -1692,10 +1836,8 @@ void OCurvesUI::updateColours(const QStringList &activeSources, const QStringLis
 
 void OCurvesUI::timerEvent(QTimerEvent *)
 {
-  if (_curves->migrateLoadingData())
-  {
-    replot();
-  }
+  // Each view schedules its own replot for the changed curves it displays.
+  _curves->migrateLoadingData();
 }
 
 
@@ -8,6 +8,8 @@
 
 #include "ocurvesconfig.h"
 
+#include "plotresampler.h"
+#include "plotsamplecolumn.h"
 #include "timesampling.h"
 
 #include <QMainWindow>
@@ -31,6 +33,7 @@ class PlotInstance;
 class PlotSource;
 class PlotViewToolbar;
 class LoadProgress;
+class RealTimeExpressions;
 class RealTimePlot;
 class ToolbarWidgets;
 class Expressions;
@@ -181,6 +184,12 @@ public slots:
   /// Invokes @c PlotView::copyToClipboard()
   void copyActiveView();
 
+  /// Enable or disable background rendering for all views.
+  ///
+  /// Invokes @c PlotView::setBackgroundRender()
+  /// @param enable True to enable background rendering.
+  void setBackgroundRender(bool enable);
+
   /// Shows the colour set editing dialog.
   void editColours();
 
@@ -217,7 +226,7 @@ private slots:
   void curveLoadingComplete();
 
   /// A source has had its data changed. Trigger regeneration of expression curves
-  /// with explicit time values.
+  /// with explicit time values and any curves depending on them.
   /// @param source The changed source.
   void sourceDataChanged(const PlotSource *source);
 
@@ -436,6 +445,19 @@ private:
   /// @param generator The loader to set time data for.
   void setTimeControls(PlotGenerator *generator);
 
+  /// Removes and regenerates @p curves from their expressions.
+  ///
+  /// Only the given curves are removed. Other curves generated from the same expressions
+  /// are retained and skipped by the generator. Curves of expressions which have been
+  /// removed are not regenerated.
+  /// @param curves The expression curves to regenerate. Should include their dependents.
+  void regenerateCurves(const QList<PlotInstance *> &curves);
+
+  /// Queues generation of @p regenExpressions with the current expression generator, or
+  /// starts a new generator as required.
+  /// @param regenExpressions The expressions to generate.
+  void generateExpressions(const QList<const PlotExpression *> &regenExpressions);
+
   /// Set the active loade.
   /// @param newLoader The active loader.
   /// @param nextAction The action to take once @c newLoader successfully completes.
@@ -483,6 +505,7 @@ private:
   Expressions *_expressions;          ///< Expressions data model.
   QElapsedTimer *_timeSinceLastPlot;  ///< Timer tracking calls to @c replot().
   RealTimePlot *_streams;             ///< Streams loader.
+  RealTimeExpressions *_realTimeExpressions; ///< Evaluates expressions over real-time curves.
   CurveProperties *_properties;       ///< Properties editor for a curve.
 
   QString _loadDirectory; ///< The directory open in with the load operation. Stores the last directory used. Serialised to/from settings.
@@ -494,6 +517,13 @@ private:
   QString _originalWindowTitle; ///< Original window title, used to display things like "about".
 
   int _activeBookmark;  ///< The active bookmark id. Zero for none.
+  bool _mappedLoad;     ///< Load files using @c PlotFileLoader::LoadMapped? Serialised to/from settings.
+  bool _useFileCache;   ///< Read and write @c PlotFileCache files on load? Serialised to/from settings.
+  /// Value encoding for loaded files. Serialised to/from settings.
+  PlotSampleEncoding _sampleEncoding;
+  /// Policy for sampling curves between their samples in expressions. Serialised to/from settings.
+  PlotResampler::Policy _resamplePolicy;
+  bool _nativeTimes;    ///< Sample expressions at the native curve sample times? Serialised to/from settings.
 };
 
 #endif // __PLOT_H_
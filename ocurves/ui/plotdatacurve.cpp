@@ -6,10 +6,20 @@
 #include "plotdatacurve.h"
 
 #include "plotinstance.h"
+#include "plotinstancesampler.h"
 
 PlotDataCurve::PlotDataCurve(PlotInstance &curve)
   : QwtPlotCurve(curve.name() + "|" + curve.source().name())
   , _curve(&curve)
+  , _drawnCount(0)
+  , _drawnHead(0)
+  , _drawnGeneration(0)
+  , _drawnTimeBase(0)
+  , _drawnTimeScale(0)
+  , _drawnTimeColumn(0)
+  , _drawn(false)
+  , _rasterised(false)
+  , _snapshot(false)
 {
 }
 
@@ -18,3 +28,65 @@ int PlotDataCurve::rtti() const
 {
   return Rtti;
 }
+
+
+void PlotDataCurve::drawSeries(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                               const QRectF &canvasRect, int from, int to) const
+{
+  if (_rasterised)
+  {
+    return;
+  }
+
+  // Data is always a PlotInstanceSampler. See PlotView::addCurve().
+  PlotInstanceSampler *sampler = static_cast<PlotInstanceSampler *>(const_cast<PlotDataCurve *>(this)->data());
+  if (from == 0 && to < 0 && !_snapshot)
+  {
+    setDrawnState();
+  }
+
+  if (sampler && from == 0 && to < 0 && style() == Lines && !symbol())
+  {
+    if (sampler->setLevelOfDetail(xMap, canvasRect))
+    {
+      QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+      sampler->clearLevelOfDetail();
+      return;
+    }
+  }
+
+  QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+}
+
+
+bool PlotDataCurve::appendedRange(int &from, int &to) const
+{
+  const PlotInstance &curve = *_curve;
+  const PlotSource &source = curve.source();
+  const size_t count = curve.sampleCount();
+  if (!_drawn || curve.dataGeneration() != _drawnGeneration || curve.ringHead() != _drawnHead ||
+      count < _drawnCount || source.timeBase() != _drawnTimeBase ||
+      source.timeScale() != _drawnTimeScale || source.timeColumn() != _drawnTimeColumn)
+  {
+    return false;
+  }
+
+  // Include the last drawn sample to connect the line.
+  from = int((_drawnCount) ? _drawnCount - 1 : 0);
+  to = (count > _drawnCount) ? int(count) - 1 : from - 1;
+  return true;
+}
+
+
+void PlotDataCurve::setDrawnState() const
+{
+  const PlotInstance &curve = *_curve;
+  const PlotSource &source = curve.source();
+  _drawnCount = curve.sampleCount();
+  _drawnHead = curve.ringHead();
+  _drawnGeneration = curve.dataGeneration();
+  _drawnTimeBase = source.timeBase();
+  _drawnTimeScale = source.timeScale();
+  _drawnTimeColumn = source.timeColumn();
+  _drawn = true;
+}
@@ -19,6 +19,16 @@ class PlotInstance;
 ///
 /// This class allows the @c PlotInstance data to be shared across a number of active
 /// plots.
+///
+/// Drawing plain line curves uses the @c PlotInstanceSampler level of detail
+/// reduction to bound the number of rendered samples by the canvas width.
+///
+/// The curve also records the state of the data when last drawn in full. This
+/// allows the @c PlotView to draw only newly appended samples (see @c appendedRange()).
+///
+/// A curve may be marked as rasterised (see @c setRasterised()), in which case it draws
+/// nothing itself, leaving the @c PlotRasterItem to draw it off the GUI thread. The
+/// @c PlotRasterItem draws a separate curve marked with @c setSnapshot().
 class PlotDataCurve : public QwtPlotCurve
 {
 public:
@@ -48,8 +58,71 @@ public:
   /// @return The visualised @c PlotInstance.
   inline const PlotInstance &curve() const { return *_curve; }
 
+  /// Mark the curve as drawn by a @c PlotRasterItem rather than itself.
+  /// @param rasterised True to draw via a @c PlotRasterItem.
+  inline void setRasterised(bool rasterised) { _rasterised = rasterised; }
+
+  /// Is the curve drawn by a @c PlotRasterItem?
+  /// @return True if the curve draws nothing itself.
+  inline bool rasterised() const { return _rasterised; }
+
+  /// Mark the curve as drawing a data snapshot off the GUI thread. A snapshot does not
+  /// record its drawn state (see @c appendedRange()), which reads the live @c PlotSource.
+  /// @param snapshot True to mark as a snapshot.
+  inline void setSnapshot(bool snapshot) { _snapshot = snapshot; }
+
+  /// Is the curve drawing a data snapshot off the GUI thread?
+  /// @return True if marked with @c setSnapshot().
+  inline bool snapshot() const { return _snapshot; }
+
+  /// Overridden to render a reduced sample set via @c PlotInstanceSampler::setLevelOfDetail().
+  ///
+  /// The reduction is only used when drawing the full series of a @c Lines curve
+  /// without symbols. Draws nothing when @c rasterised().
+  ///
+  /// @param painter The painter.
+  /// @param xMap Maps x-values into pixel coordinates.
+  /// @param yMap Maps y-values into pixel coordinates.
+  /// @param canvasRect Contents rectangle of the canvas.
+  /// @param from Index of the first point to be painted.
+  /// @param to Index of the last point to be painted. If to < 0 the curve will be painted to its last point.
+  void drawSeries(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                  const QRectF &canvasRect, int from, int to) const override;
+
+  /// Check whether samples have only been appended since the curve was last drawn, with
+  /// no change to the existing samples, their timing or the curve display properties.
+  ///
+  /// On success, the appended samples may be drawn by drawing the range [@p from, @p to],
+  /// which includes the last sample drawn so as to connect the line. The range is empty
+  /// (@p to < @p from) when nothing has been appended.
+  ///
+  /// @param[out] from Set to the first sample index to draw.
+  /// @param[out] to Set to the last sample index to draw.
+  /// @return True if the appended samples may be drawn incrementally, false if the curve
+  ///   must be redrawn in full.
+  bool appendedRange(int &from, int &to) const;
+
+  /// Record the current curve data as drawn, after drawing the @c appendedRange().
+  inline void markDrawn() { setDrawnState(); }
+
+  /// Invalidate the record of the last drawn state, forcing @c appendedRange() to fail
+  /// until the curve is drawn in full again. Used when display properties change.
+  inline void clearDrawnState() { _drawn = false; }
+
 private:
+  /// Record the state of the curve data as drawn.
+  void setDrawnState() const;
+
   PlotInstance *_curve; ///< The data.
+  mutable size_t _drawnCount;       ///< Sample count when last drawn.
+  mutable size_t _drawnHead;        ///< Ring buffer head when last drawn.
+  mutable unsigned _drawnGeneration;  ///< @c PlotInstance::dataGeneration() when last drawn.
+  mutable double _drawnTimeBase;    ///< Source time base when last drawn.
+  mutable double _drawnTimeScale;   ///< Source time scale when last drawn.
+  mutable unsigned _drawnTimeColumn;  ///< Source time column when last drawn.
+  mutable bool _drawn;              ///< Is the drawn state valid?
+  bool _rasterised;                 ///< Drawn by a @c PlotRasterItem?
+  bool _snapshot;                   ///< Drawing a snapshot off the GUI thread?
 };
 
 
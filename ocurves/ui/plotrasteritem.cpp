@@ -0,0 +1,472 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "plotrasteritem.h"
+
+#include "plotdatacurve.h"
+#include "plotinstance.h"
+#include "plotinstancesampler.h"
+
+#include <qwt_plot.h>
+#include <qwt_symbol.h>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+// Workers used to render frames. Separate from the global pool so rendering is not held
+// up by file loading and expression generation.
+Q_GLOBAL_STATIC(QThreadPool, renderPool)
+
+namespace
+{
+  /// Calculate the scale values at the corners of @p canvasRect.
+  QRectF scaleRect(const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect)
+  {
+    return QRectF(QPointF(xMap.invTransform(canvasRect.left()), yMap.invTransform(canvasRect.top())),
+                  QPointF(xMap.invTransform(canvasRect.right()), yMap.invTransform(canvasRect.bottom())));
+  }
+
+
+  /// A snapshot of a @c PlotDataCurve and its data for rendering on a worker thread.
+  ///
+  /// The data are pinned (see @c PlotInstance::pinData()) so migrating new samples into a
+  /// loading curve does not copy the data while they are drawn. The timing is captured
+  /// here, so the worker never reads the live @c PlotSource.
+  ///
+  /// Must be created and destroyed on the GUI thread, as the @c PlotInstance copies
+  /// reference the @c PlotSource. The data are released via @c release() as soon as
+  /// drawing ends.
+  class CurveSnapshot
+  {
+  public:
+    CurveSnapshot(const PlotDataCurve &display)
+      : _curve(display.curve())
+      , _item(_curve)
+      , _pinned(true)
+    {
+      _curve.pinData();
+      const PlotSource &source = display.curve().source();
+      if (const PlotInstance *timeCurve = source.timeColumnCurve())
+      {
+        _timeCurve.reset(new PlotInstance(*timeCurve));
+        _timeCurve->pinData();
+      }
+
+      PlotInstanceSampler *sampler = new PlotInstanceSampler(&_curve);
+      sampler->setFixedTiming(_timeCurve.get(), source.timeBase(), source.timeScale());
+      _item.setData(sampler);
+      _item.setPen(display.pen());
+      _item.setStyle(display.style());
+      if (const QwtSymbol *symbol = display.symbol())
+      {
+        _item.setSymbol(new QwtSymbol(symbol->style(), symbol->brush(), symbol->pen(), symbol->size()));
+      }
+      _item.setRenderHint(QwtPlotItem::RenderAntialiased, display.testRenderHint(QwtPlotItem::RenderAntialiased));
+      _item.setSnapshot(true);
+    }
+
+    inline ~CurveSnapshot() { release(); }
+
+    inline const PlotDataCurve &item() const { return _item; }
+
+    /// Unpin and release the data once drawn. May be called from the worker thread.
+    /// The snapshot may only be destroyed afterwards.
+    void release()
+    {
+      if (_pinned)
+      {
+        _curve.releasePinnedData();
+        if (_timeCurve)
+        {
+          _timeCurve->releasePinnedData();
+        }
+        _pinned = false;
+      }
+    }
+
+  private:
+    PlotInstance _curve;
+    std::unique_ptr<PlotInstance> _timeCurve;
+    PlotDataCurve _item;
+    bool _pinned; ///< Set until @c release().
+  };
+}
+
+
+struct PlotRasterItem::Channel
+{
+  QMutex mutex;                     ///< Guards all but @c generation.
+  QWaitCondition finished;          ///< Signalled when a task finishes.
+  std::atomic<unsigned> generation; ///< Generation of the current request. Older tasks are cancelled.
+  PlotRasterItem *owner;            ///< The item to notify. Null once the item is destroyed.
+  QList<CurveSnapshot *> retired;   ///< Released snapshots to be deleted on the GUI thread.
+  QImage frame;                     ///< The latest completed frame, waiting to be collected.
+  QRectF canvasRect;                ///< The canvas rectangle for @c frame.
+  QRectF scaleRect;                 ///< The scale values at the corners of @c canvasRect.
+  unsigned frameGeneration;         ///< The generation of @c frame.
+  unsigned activeTasks;             ///< Number of tasks queued or running.
+  bool frameReady;                  ///< True when @c frame is waiting to be collected.
+
+  inline Channel(PlotRasterItem *owner)
+    : generation(0)
+    , owner(owner)
+    , frameGeneration(0)
+    , activeTasks(0)
+    , frameReady(false)
+  {
+  }
+};
+
+
+struct PlotRasterItem::FrameKey
+{
+  /// The curve state affecting the rendered frame.
+  struct CurveState
+  {
+    const PlotInstance *curve;
+    size_t count;
+    size_t head;
+    unsigned generation;
+    unsigned flags;
+    QPen pen;
+    int style;
+    int symbolStyle;
+    QSizeF symbolSize;
+    double timeBase;
+    double timeScale;
+    unsigned timeColumn;
+
+    inline bool operator==(const CurveState &other) const
+    {
+      return curve == other.curve && count == other.count && head == other.head &&
+             generation == other.generation && flags == other.flags && pen == other.pen &&
+             style == other.style && symbolStyle == other.symbolStyle && symbolSize == other.symbolSize &&
+             timeBase == other.timeBase && timeScale == other.timeScale && timeColumn == other.timeColumn;
+    }
+  };
+
+  double xMap[4];   ///< X map s1, s2, p1, p2.
+  double yMap[4];   ///< Y map s1, s2, p1, p2.
+  QRectF canvasRect;
+  QVector<CurveState> curves;
+
+  FrameKey(const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect)
+    : canvasRect(canvasRect)
+  {
+    this->xMap[0] = xMap.s1();
+    this->xMap[1] = xMap.s2();
+    this->xMap[2] = xMap.p1();
+    this->xMap[3] = xMap.p2();
+    this->yMap[0] = yMap.s1();
+    this->yMap[1] = yMap.s2();
+    this->yMap[2] = yMap.p1();
+    this->yMap[3] = yMap.p2();
+  }
+
+  void addCurve(const PlotDataCurve &display)
+  {
+    const PlotInstance &curve = display.curve();
+    const PlotSource &source = curve.source();
+    CurveState state;
+    state.curve = &curve;
+    state.count = curve.sampleCount();
+    state.head = curve.ringHead();
+    state.generation = curve.dataGeneration();
+    state.flags = curve.flags();
+    state.pen = display.pen();
+    state.style = int(display.style());
+    state.symbolStyle = (display.symbol()) ? int(display.symbol()->style()) : int(QwtSymbol::NoSymbol);
+    state.symbolSize = (display.symbol()) ? QSizeF(display.symbol()->size()) : QSizeF();
+    state.timeBase = source.timeBase();
+    state.timeScale = source.timeScale();
+    state.timeColumn = source.timeColumn();
+    curves.append(state);
+  }
+
+  /// Compare the axis maps and canvas only.
+  inline bool sameView(const FrameKey &other) const
+  {
+    return std::equal(xMap, xMap + 4, other.xMap) && std::equal(yMap, yMap + 4, other.yMap) &&
+           canvasRect == other.canvasRect;
+  }
+
+  inline bool operator==(const FrameKey &other) const
+  {
+    return sameView(other) && curves == other.curves;
+  }
+};
+
+
+namespace
+{
+  /// Renders a frame from @c CurveSnapshot objects.
+  class RenderTask : public QRunnable
+  {
+  public:
+    /// Samples drawn between cancellation checks when drawing a curve in full.
+    enum { ChunkSize = 1 << 16 };
+
+    RenderTask(const std::shared_ptr<PlotRasterItem::Channel> &channel, unsigned generation,
+               const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect)
+      : _channel(channel)
+      , _xMap(xMap)
+      , _yMap(yMap)
+      , _canvasRect(canvasRect)
+      , _generation(generation)
+    {
+    }
+
+    inline void addCurve(CurveSnapshot *snapshot) { _curves.append(snapshot); }
+
+    void run() override
+    {
+      const QSize size(int(std::ceil(_canvasRect.width())), int(std::ceil(_canvasRect.height())));
+      QImage image;
+      bool cancelled = isCancelled();
+      if (!cancelled && !size.isEmpty())
+      {
+        image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.translate(-_canvasRect.topLeft());
+        for (const CurveSnapshot *snapshot : _curves)
+        {
+          if (!drawCurve(painter, snapshot->item()))
+          {
+            cancelled = true;
+            break;
+          }
+        }
+      }
+
+      // Release the data now so the curves can migrate new samples. The snapshots themselves
+      // must be deleted on the GUI thread.
+      for (CurveSnapshot *snapshot : _curves)
+      {
+        snapshot->release();
+      }
+
+      PlotRasterItem::Channel &channel = *_channel;
+      QMutexLocker guard(&channel.mutex);
+      for (CurveSnapshot *snapshot : _curves)
+      {
+        channel.retired.append(snapshot);
+      }
+      _curves.clear();
+
+      if (!cancelled && !isCancelled())
+      {
+        channel.frame = image;
+        channel.canvasRect = _canvasRect;
+        channel.scaleRect = scaleRect(_xMap, _yMap, _canvasRect);
+        channel.frameGeneration = _generation;
+        channel.frameReady = true;
+      }
+
+      --channel.activeTasks;
+      channel.finished.wakeAll();
+      if (channel.owner)
+      {
+        QMetaObject::invokeMethod(channel.owner, "frameCompleted", Qt::QueuedConnection);
+      }
+    }
+
+  private:
+    inline bool isCancelled() const { return _channel->generation.load() != _generation; }
+
+    /// Draw @p item, checking for cancellation periodically.
+    /// @return False if cancelled.
+    bool drawCurve(QPainter &painter, const PlotDataCurve &item) const
+    {
+      PlotInstanceSampler *sampler = static_cast<PlotInstanceSampler *>(const_cast<PlotDataCurve &>(item).data());
+      const size_t count = sampler->size();
+      if (!count)
+      {
+        return true;
+      }
+
+      painter.setRenderHint(QPainter::Antialiasing, item.testRenderHint(QwtPlotItem::RenderAntialiased));
+
+      // Draw in full where the level of detail applies (see PlotDataCurve::drawSeries()),
+      // as the sample count is then bounded by the canvas width.
+      bool reduced = false;
+      if (item.style() == QwtPlotCurve::Lines && !item.symbol())
+      {
+        reduced = sampler->setLevelOfDetail(_xMap, _canvasRect);
+        sampler->clearLevelOfDetail();
+      }
+
+      if (reduced || count <= ChunkSize)
+      {
+        item.drawSeries(&painter, _xMap, _yMap, _canvasRect, 0, -1);
+        return !isCancelled();
+      }
+
+      // Overlap chunks by one sample to connect the line.
+      for (size_t from = 0; ; )
+      {
+        const size_t to = std::min<size_t>(from + ChunkSize, count - 1);
+        item.drawSeries(&painter, _xMap, _yMap, _canvasRect, int(from), int(to));
+        if (isCancelled())
+        {
+          return false;
+        }
+        if (to + 1 >= count)
+        {
+          break;
+        }
+        from = to;
+      }
+
+      return true;
+    }
+
+    std::shared_ptr<PlotRasterItem::Channel> _channel;
+    QList<CurveSnapshot *> _curves;
+    QwtScaleMap _xMap;
+    QwtScaleMap _yMap;
+    QRectF _canvasRect;
+    unsigned _generation;
+  };
+}
+
+
+PlotRasterItem::PlotRasterItem(QObject *parent)
+  : QObject(parent)
+  , _channel(std::make_shared<Channel>(this))
+  , _rendering(false)
+{
+  setItemAttribute(QwtPlotItem::Legend, false);
+  setItemAttribute(QwtPlotItem::AutoScale, false);
+  // Draw at the curve level, above the grid.
+  setZ(20);
+}
+
+
+PlotRasterItem::~PlotRasterItem()
+{
+  detach();
+  Channel &channel = *_channel;
+  QMutexLocker guard(&channel.mutex);
+  channel.owner = nullptr;
+  ++channel.generation;
+  // Wait for the tasks to release the data snapshots. Cancelled tasks finish promptly.
+  while (channel.activeTasks)
+  {
+    channel.finished.wait(&channel.mutex);
+  }
+  qDeleteAll(channel.retired);
+  channel.retired.clear();
+}
+
+
+int PlotRasterItem::rtti() const
+{
+  return Rtti;
+}
+
+
+void PlotRasterItem::draw(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+                          const QRectF &canvasRect) const
+{
+  FrameKey key(xMap, yMap, canvasRect);
+  QVector<const PlotDataCurve *> curves;
+  if (const QwtPlot *plot = this->plot())
+  {
+    const QwtPlotItemList items = plot->itemList(PlotDataCurve::Rtti);
+    for (const QwtPlotItem *item : items)
+    {
+      if (item->isVisible())
+      {
+        const PlotDataCurve *curve = static_cast<const PlotDataCurve *>(item);
+        curves.append(curve);
+        key.addCurve(*curve);
+      }
+    }
+  }
+
+  if (!_frame.isNull())
+  {
+    if (_frameCanvasRect == canvasRect && _frameScaleRect == scaleRect(xMap, yMap, canvasRect))
+    {
+      painter->drawImage(canvasRect.topLeft(), _frame);
+    }
+    else
+    {
+      // Stretch the frame to the current maps until the new frame is ready.
+      const QRectF target(QPointF(xMap.transform(_frameScaleRect.left()), yMap.transform(_frameScaleRect.top())),
+                          QPointF(xMap.transform(_frameScaleRect.right()), yMap.transform(_frameScaleRect.bottom())));
+      painter->drawImage(target, _frame);
+    }
+  }
+
+  if (!_requestedKey || !(*_requestedKey == key))
+  {
+    // Let the frame in progress complete unless the view has changed. The frame completion
+    // replots, requesting the new frame.
+    if (!_rendering || !_requestedKey->sameView(key))
+    {
+      requestFrame(key, curves, xMap, yMap, canvasRect);
+    }
+  }
+}
+
+
+void PlotRasterItem::frameCompleted()
+{
+  Channel &channel = *_channel;
+  QList<CurveSnapshot *> retired;
+  bool newFrame = false;
+  {
+    QMutexLocker guard(&channel.mutex);
+    retired.swap(channel.retired);
+    if (channel.frameReady)
+    {
+      _frame = channel.frame;
+      _frameCanvasRect = channel.canvasRect;
+      _frameScaleRect = channel.scaleRect;
+      _rendering = _rendering && channel.frameGeneration != channel.generation.load();
+      channel.frame = QImage();
+      channel.frameReady = false;
+      newFrame = true;
+    }
+  }
+  qDeleteAll(retired);
+
+  if (newFrame && plot())
+  {
+    plot()->replot();
+  }
+}
+
+
+void PlotRasterItem::requestFrame(const FrameKey &key, const QVector<const PlotDataCurve *> &curves,
+                                  const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect) const
+{
+  // Cancel any frame in progress.
+  const unsigned generation = ++_channel->generation;
+  _requestedKey.reset(new FrameKey(key));
+  _rendering = true;
+
+  RenderTask *task = new RenderTask(_channel, generation, xMap, yMap, canvasRect);
+  for (const PlotDataCurve *curve : curves)
+  {
+    task->addCurve(new CurveSnapshot(*curve));
+  }
+
+  {
+    QMutexLocker guard(&_channel->mutex);
+    ++_channel->activeTasks;
+  }
+  renderPool()->start(task);
+}
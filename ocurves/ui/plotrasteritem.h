@@ -0,0 +1,103 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef PLOTRASTERITEM_H_
+#define PLOTRASTERITEM_H_
+
+#include "ocurvesconfig.h"
+
+#include <QImage>
+#include <QObject>
+#include <QRectF>
+#include <QVector>
+
+#include <qwt_plot_item.h>
+#include <qwt_scale_map.h>
+
+#include <memory>
+
+#include "qwtrttiext.h"
+
+class PlotDataCurve;
+
+/// @ingroup ui
+/// A plot item which draws the visible @c PlotDataCurve items of its plot from an image
+/// rendered on a worker thread.
+///
+/// Drawing the item draws the latest completed frame, then requests a new frame if the
+/// curves or axis maps have changed since the last request. A frame is rendered from
+/// snapshots of the @c PlotInstance data, copied on the GUI thread. Copying a
+/// @c PlotInstance is cheap, with the data shared. The snapshots are pinned, deferring
+/// the migration of new samples into loading curves rather than copying the data, and
+/// are released as soon as drawing ends. The plot is replotted when the frame completes.
+///
+/// Requesting a frame for different axis maps cancels any frame in progress, as the result
+/// would be stale. A request for a data or display property change alone waits for the
+/// frame in progress to complete first, so continuously changing data still displays.
+///
+/// A frame rendered for different axis maps is scaled to match the current maps until
+/// the new frame is ready. This keeps panning and zooming responsive regardless of the
+/// drawing cost.
+///
+/// The curves must be marked with @c PlotDataCurve::setRasterised() so they do not also
+/// draw themselves.
+class PlotRasterItem : public QObject, public QwtPlotItem
+{
+  Q_OBJECT
+public:
+  enum
+  {
+    /// The id for @c rtti() identifying a @c PlotRasterItem class.
+    Rtti = Rtti_PlotRasterItem
+  };
+
+  /// Constructor.
+  /// @param parent The owning object.
+  PlotRasterItem(QObject *parent = nullptr);
+
+  /// Destructor. Cancels any frame in progress.
+  ~PlotRasterItem();
+
+  /// Returns the @c Rtti value for this object.
+  /// @return The value @c Rtti.
+  int rtti() const override;
+
+  /// Draw the latest completed frame and request a new frame as required.
+  /// @param painter The painter.
+  /// @param xMap Maps x-values into pixel coordinates.
+  /// @param yMap Maps y-values into pixel coordinates.
+  /// @param canvasRect Contents rectangle of the canvas.
+  void draw(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap,
+            const QRectF &canvasRect) const override;
+
+  /// Shared state between the item and its render tasks. Implementation detail.
+  struct Channel;
+
+  /// Axis maps and curve state identifying a frame. Implementation detail.
+  struct FrameKey;
+
+private slots:
+  /// Collects the completed frame from the render task and replots.
+  void frameCompleted();
+
+private:
+  /// Start rendering a new frame.
+  /// @param key Identifies the frame.
+  /// @param curves The curves to render.
+  /// @param xMap Maps x-values into pixel coordinates.
+  /// @param yMap Maps y-values into pixel coordinates.
+  /// @param canvasRect Contents rectangle of the canvas.
+  void requestFrame(const FrameKey &key, const QVector<const PlotDataCurve *> &curves,
+                    const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect) const;
+
+  std::shared_ptr<Channel> _channel;  ///< Shared with render tasks.
+  mutable std::unique_ptr<FrameKey> _requestedKey; ///< Identifies the last requested frame.
+  QImage _frame;              ///< The latest completed frame.
+  QRectF _frameCanvasRect;    ///< The canvas rectangle for @c _frame.
+  QRectF _frameScaleRect;     ///< The scale values at the corners of @c _frameCanvasRect.
+  mutable bool _rendering;    ///< True while the last requested frame is in progress.
+};
+
+#endif // PLOTRASTERITEM_H_
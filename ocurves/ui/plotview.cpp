@@ -11,6 +11,7 @@
 #include "plotinstance.h"
 #include "plotinstancesampler.h"
 #include "plotpanner.h"
+#include "plotrasteritem.h"
 #include "plotzoomer.h"
 
 #include "model/curves.h"
@@ -18,6 +19,7 @@
 
 #include "qwt_legend.h"
 #include "qwt_plot.h"
+#include "qwt_plot_directpainter.h"
 #include "qwt_plot_grid.h"
 #include "qwt_plot_canvas.h"
 #include "qwt_plot_renderer.h"
@@ -29,6 +31,7 @@
 #include <QHBoxLayout>
 #include <QKeyEvent>
 #include <QSettings>
+#include <QTimer>
 
 /// An extension of QwtPlot which monitors focus events.
 ///
@@ -119,10 +122,13 @@ PlotView::PlotView(Curves *curves, QWidget *parent)
   , _curves(curves)
   , _zoom(nullptr)
   , _panner(nullptr)
+  , _directPainter(new QwtPlotDirectPainter(this))
+  , _rasterItem(nullptr)
   , _ui(new Ui::PlotView)
   , _toolMode(MultiTool)
   , _synchronised(false)
   , _suppressEvents(false)
+  , _replotQueued(false)
 {
   _ui->setupUi(this);
   _ui->contentParent->layout()->addWidget(_plot);
@@ -206,6 +212,7 @@ PlotView::PlotView(Curves *curves, QWidget *parent)
 
 PlotView::~PlotView()
 {
+  delete _rasterItem;
   for (PlotDataCurve *display : _displayCurves)
   {
     display->hide();
@@ -326,6 +333,34 @@ void PlotView::updateActive(const QStringList &sourceNames, const QStringList &c
 }
 
 
+void PlotView::setBackgroundRender(bool enable)
+{
+  if (enable == backgroundRender())
+  {
+    return;
+  }
+
+  if (enable)
+  {
+    _rasterItem = new PlotRasterItem;
+    _rasterItem->attach(_plot);
+  }
+  else
+  {
+    delete _rasterItem;
+    _rasterItem = nullptr;
+  }
+
+  for (PlotDataCurve *display : _displayCurves)
+  {
+    display->setRasterised(enable);
+    display->clearDrawnState();
+  }
+
+  _plot->replot();
+}
+
+
 void PlotView::zoomToFit()
 {
   _zoom->zoomToFit();
@@ -389,11 +424,31 @@ void PlotView::copyToClipboard()
 {
   if (QApplication::clipboard())
   {
+    // Render the curves directly, rather than the latest background frame.
+    const bool rasterised = backgroundRender();
+    if (rasterised)
+    {
+      _rasterItem->setVisible(false);
+      for (PlotDataCurve *display : _displayCurves)
+      {
+        display->setRasterised(false);
+      }
+    }
+
     QPixmap pixmap(_plot->width(), _plot->height());
     pixmap.fill(Qt::transparent);
     QwtPlotRenderer painter;
     painter.renderTo(_plot, pixmap);
     QApplication::clipboard()->setPixmap(pixmap);
+
+    if (rasterised)
+    {
+      _rasterItem->setVisible(true);
+      for (PlotDataCurve *display : _displayCurves)
+      {
+        display->setRasterised(true);
+      }
+    }
   }
 }
 
@@ -403,6 +458,7 @@ void PlotView::addCurve(PlotInstance *curve)
   PlotDataCurve *displayCurve = new PlotDataCurve(*curve);
   displayCurve->setData(new PlotInstanceSampler(curve));
   displayCurve->setItemAttribute(QwtPlotItem::AutoScale, true);
+  displayCurve->setRasterised(backgroundRender());
   displayCurve->hide();
   _displayCurves.append(displayCurve);
 
@@ -424,6 +480,7 @@ void PlotView::removeCurve(const PlotInstance *curve)
     PlotDataCurve *display = *iter;
     if (curve == &display->curve())
     {
+      _dirtyCurves.removeOne(display);
       display->detach();
       delete display;
       _displayCurves.erase(iter);
@@ -435,13 +492,16 @@ void PlotView::removeCurve(const PlotInstance *curve)
 
 void PlotView::curveDataChanged(const PlotInstance *curve)
 {
-  bool replot = false;
   for (auto iter = _displayCurves.begin(); iter != _displayCurves.end(); ++iter)
   {
     PlotDataCurve *display = *iter;
     if (curve == &display->curve())
     {
-      // Setup display properties.
+      // Setup display properties, noting any changes which prevent an incremental draw.
+      const QPen oldPen = display->pen();
+      const QwtPlotCurve::CurveStyle oldStyle = display->style();
+      const QwtSymbol *oldSymbol = display->symbol();
+
       // Generate a pen.
       QColor colour(curve->colour());
       bool colourChanged = display->pen().color() != colour;
@@ -487,25 +547,110 @@ void PlotView::curveDataChanged(const PlotInstance *curve)
         display->setSymbol(nullptr);
       }
 
+      if (display->pen() != oldPen || display->style() != oldStyle || display->symbol() != oldSymbol)
+      {
+        display->clearDrawnState();
+      }
+
       if (display->isVisible())
       {
         PlotInstanceSampler *sampler = static_cast<PlotInstanceSampler *>(display->data());
         sampler->invalidateBoundingRect();
         display->invalidate();
-        _zoom->fitIfAutoScaling();
-        replot = true;
+        scheduleReplot(display);
       }
       break;
     }
   }
+}
+
+
+void PlotView::flushReplot()
+{
+  _replotQueued = false;
+  QList<PlotDataCurve *> dirtyCurves;
+  dirtyCurves.swap(_dirtyCurves);
+  if (dirtyCurves.empty())
+  {
+    return;
+  }
+
+  bool fullReplot = false;
+  const bool autoScale = _plot->axisAutoScale(PlotZoomer::AxisX) && _plot->axisAutoScale(PlotZoomer::AxisY);
+  if (autoScale)
+  {
+    // Resolve the new scales without replotting. Any change requires a full replot.
+    const QwtScaleDiv xDiv = _plot->axisScaleDiv(PlotZoomer::AxisX);
+    const QwtScaleDiv yDiv = _plot->axisScaleDiv(PlotZoomer::AxisY);
+    _plot->updateAxes();
+    fullReplot = xDiv != _plot->axisScaleDiv(PlotZoomer::AxisX) || yDiv != _plot->axisScaleDiv(PlotZoomer::AxisY);
+  }
+
+  // Background rendering redraws in full off the GUI thread.
+  if (!fullReplot && !backgroundRender() && drawAppended(dirtyCurves))
+  {
+    return;
+  }
 
-  if (replot)
+  if (autoScale)
+  {
+    // Replots.
+    _zoom->fitIfAutoScaling();
+  }
+  else
   {
     _plot->replot();
   }
 }
 
 
+void PlotView::scheduleReplot(PlotDataCurve *display)
+{
+  if (!_dirtyCurves.contains(display))
+  {
+    _dirtyCurves.append(display);
+  }
+
+  if (!_replotQueued)
+  {
+    // Coalesce all changes raised before returning to the event loop.
+    _replotQueued = true;
+    QTimer::singleShot(0, this, SLOT(flushReplot()));
+  }
+}
+
+
+bool PlotView::drawAppended(const QList<PlotDataCurve *> &displayCurves)
+{
+  if (!_plot->isVisible())
+  {
+    return false;
+  }
+
+  // Validate all curves before drawing any.
+  QVector<QPair<int, int>> ranges(displayCurves.size());
+  for (int i = 0; i < displayCurves.size(); ++i)
+  {
+    if (!displayCurves[i]->isVisible() || !displayCurves[i]->plot() ||
+        !displayCurves[i]->appendedRange(ranges[i].first, ranges[i].second))
+    {
+      return false;
+    }
+  }
+
+  for (int i = 0; i < displayCurves.size(); ++i)
+  {
+    if (ranges[i].first <= ranges[i].second)
+    {
+      _directPainter->drawSeries(displayCurves[i], ranges[i].first, ranges[i].second);
+    }
+    displayCurves[i]->markDrawn();
+  }
+
+  return true;
+}
+
+
 void PlotView::curvesCleared()
 {
   _zoom->zoomToFit(false);
@@ -17,11 +17,13 @@ class Curves;
 class PlotDataCurve;
 class PlotInstance;
 class PlotPanner;
+class PlotRasterItem;
 class PlotZoomer;
 
 class QSettings;
 class QwtLegend;
 class QwtPlot;
+class QwtPlotDirectPainter;
 class QwtPlotGrid;
 
 namespace Ui
@@ -34,6 +36,15 @@ namespace Ui
 ///
 /// The view maintains its own visibility status including list of visible files, curves
 /// zoom level and position.
+///
+/// Changes to curve data are not replotted immediately. Instead, the view coalesces
+/// @c Curves::curveDataChanged() notifications for its visible curves and replots once
+/// control returns to the event loop (see @c flushReplot()). Views showing none of the
+/// changed curves are not replotted. Where the changed curves have only been appended to
+/// and the axes have not changed, only the appended samples are drawn.
+///
+/// The view optionally renders its curves on background threads (see
+/// @c setBackgroundRender()).
 class PlotView : public QFrame
 {
   Q_OBJECT
@@ -157,6 +168,20 @@ public:
   /// @return A list of curve names this view can display.
   const QStringList &visibleCurveNames() const { return _visibleCurveNames; }
 
+  /// Is background rendering enabled? See @c setBackgroundRender().
+  /// @return True if curves are rendered on background threads.
+  inline bool backgroundRender() const { return _rasterItem != nullptr; }
+
+  /// Enable or disable background rendering.
+  ///
+  /// When enabled, the curves are rendered into an image on a worker thread using a
+  /// @c PlotRasterItem, and the canvas draws the latest completed image. This keeps the
+  /// UI responsive while drawing large curves. Changing the zoom or pan cancels any
+  /// image in progress. Incremental drawing of appended samples is not used.
+  ///
+  /// @param enable True to enable background rendering.
+  void setBackgroundRender(bool enable);
+
 public slots:
   /// Change the current zoom level to fit the currently selected plots.
   ///
@@ -198,6 +223,15 @@ public slots:
   ///   values, or @c SharedLegend.
   void setLegendPosition(int pos);
 
+  /// Replot for the curve changes scheduled since the last call.
+  ///
+  /// Performs a full replot unless all changed curves can be extended by drawing only
+  /// their appended samples without changing the axis scales. See
+  /// @c PlotDataCurve::appendedRange().
+  ///
+  /// Called from the event loop after @c scheduleReplot().
+  void flushReplot();
+
   /// Copies the current plot view content to the clipboard.
   ///
   /// The current curves and legend (if not shared) are rendered to a bitmap and
@@ -250,9 +284,8 @@ protected slots:
 
   /// Handles changes to curve data.
   ///
-  /// This updates the display adaptor for @p curve and may replot if the
-  /// curve is visible. The method assumes all data may be invalidated as there
-  /// is no specification for what has changed.
+  /// This updates the display adaptor for @p curve and schedules a replot if the
+  /// curve is visible. See @c flushReplot().
   /// @param curve The curve which has been modified or invalidated.
   void curveDataChanged(const PlotInstance *curve);
 
@@ -287,11 +320,23 @@ private:
   /// if events are not being suppressed.
   void viewFocusLost();
 
+  /// Mark @p display as changed and queue a call to @c flushReplot() if not already queued.
+  /// @param display The changed curve.
+  void scheduleReplot(PlotDataCurve *display);
+
+  /// Draw the samples appended to each of @p displayCurves since they were last drawn,
+  /// without a full replot.
+  /// @param displayCurves The changed curves.
+  /// @return True on success, false if a full replot is required.
+  bool drawAppended(const QList<PlotDataCurve *> &displayCurves);
+
   QwtPlot *_plot;       ///< The internal plot view.
   QwtPlotGrid *_plotGrid; ///< The grid for the internal plot view
   Curves *_curves;      ///< Curves data model.
   PlotZoomer *_zoom;    ///< Zooming UI interface.
   PlotPanner *_panner;  ///< Panning UI interface.
+  QwtPlotDirectPainter *_directPainter; ///< Draws appended samples. See @c drawAppended().
+  PlotRasterItem *_rasterItem;  ///< Renders curves off the GUI thread. Null unless @c backgroundRender().
   QStringList _activeSourceNames; ///< List of @c PlotSource objects which are active in this view.
   QStringList _visibleCurveNames; ///< List of @c PlotInstance objects which are active in this view.
   QList<PlotDataCurve *> _displayCurves;  ///< Display adaptors for @c PlotInstance objects in this view. Includes non-visible curves.
@@ -299,6 +344,8 @@ private:
   ToolMode _toolMode;   ///< Current tool mode.
   bool _synchronised;   ///< See @c synchronised()
   bool _suppressEvents; ///< True if event signalling is disabled. Set during certain UI changes.
+  bool _replotQueued;   ///< True if a call to @c flushReplot() has been queued.
+  QList<PlotDataCurve *> _dirtyCurves;  ///< Visible curves changed since the last @c flushReplot().
 
   /// List of actions used to modify the current @c ToolMode. One is always kept checked.
   QAction *_toolModeActions[ToolModeCount];
@@ -0,0 +1,178 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "fft.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  const double kPi = 3.14159265358979323846;
+}
+
+
+Fft::Fft(size_t size)
+  : _size(std::max<size_t>(ceilPowerOfTwo(size), 2u))
+{
+  const size_t complexSize = _size / 2;
+
+  // Twiddle factors for each stage, where each stage combines transforms of size halfSize.
+  _twiddleRe.resize(std::max<size_t>(complexSize - 1, 1u));
+  _twiddleIm.resize(_twiddleRe.size());
+  for (size_t halfSize = 1; halfSize < complexSize; halfSize *= 2)
+  {
+    for (size_t k = 0; k < halfSize; ++k)
+    {
+      const double angle = -kPi * double(k) / double(halfSize);
+      _twiddleRe[halfSize - 1 + k] = std::cos(angle);
+      _twiddleIm[halfSize - 1 + k] = std::sin(angle);
+    }
+  }
+
+  // Factors to separate the spectrum of the even and odd samples.
+  _splitRe.resize(complexSize + 1);
+  _splitIm.resize(complexSize + 1);
+  for (size_t k = 0; k <= complexSize; ++k)
+  {
+    const double angle = -2.0 * kPi * double(k) / double(_size);
+    _splitRe[k] = std::cos(angle);
+    _splitIm[k] = std::sin(angle);
+  }
+
+  _reversed.resize(complexSize);
+  unsigned bits = 0;
+  while ((size_t(1) << bits) < complexSize)
+  {
+    ++bits;
+  }
+  for (size_t i = 0; i < complexSize; ++i)
+  {
+    size_t reversed = 0;
+    for (unsigned b = 0; b < bits; ++b)
+    {
+      reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+    }
+    _reversed[i] = reversed;
+  }
+
+  _re.resize(complexSize);
+  _im.resize(complexSize);
+}
+
+
+void Fft::powerSpectrum(const double *input, double *power)
+{
+  const size_t complexSize = _size / 2;
+
+  // Pack even samples as real values and odd samples as imaginary values, in bit reversed order.
+  for (size_t i = 0; i < complexSize; ++i)
+  {
+    const size_t j = _reversed[i];
+    _re[j] = input[2 * i];
+    _im[j] = input[2 * i + 1];
+  }
+
+  transform();
+
+  for (size_t k = 0; k <= complexSize; ++k)
+  {
+    // Z[k] and conj(Z[N/2 - k]) with indices modulo N/2.
+    const size_t a = (k < complexSize) ? k : 0;
+    const size_t b = (k > 0) ? complexSize - k : 0;
+    const double zRe = _re[a];
+    const double zIm = _im[a];
+    const double cRe = _re[b];
+    const double cIm = -_im[b];
+
+    // Even spectrum: (Z[k] + conj(Z[N/2 - k])) / 2
+    const double evenRe = 0.5 * (zRe + cRe);
+    const double evenIm = 0.5 * (zIm + cIm);
+    // Odd spectrum: (Z[k] - conj(Z[N/2 - k])) / 2i
+    const double oddRe = 0.5 * (zIm - cIm);
+    const double oddIm = -0.5 * (zRe - cRe);
+
+    const double re = evenRe + _splitRe[k] * oddRe - _splitIm[k] * oddIm;
+    const double im = evenIm + _splitRe[k] * oddIm + _splitIm[k] * oddRe;
+    power[k] = re * re + im * im;
+  }
+}
+
+
+void Fft::windowCoefficients(std::vector<double> &coefficients, size_t size, Window window)
+{
+  coefficients.resize(size);
+  // Use periodic windows as suited to spectral analysis.
+  for (size_t i = 0; i < size; ++i)
+  {
+    const double c = std::cos(2.0 * kPi * double(i) / double(size));
+    switch (window)
+    {
+    case Hann:
+      coefficients[i] = 0.5 - 0.5 * c;
+      break;
+    case Hamming:
+      coefficients[i] = 0.54 - 0.46 * c;
+      break;
+    case Rectangular:
+    default:
+      coefficients[i] = 1.0;
+      break;
+    }
+  }
+}
+
+
+size_t Fft::ceilPowerOfTwo(size_t value)
+{
+  size_t power = 1;
+  while (power < value)
+  {
+    power *= 2;
+  }
+  return power;
+}
+
+
+void Fft::transform()
+{
+  const size_t complexSize = _size / 2;
+  double *re = _re.data();
+  double *im = _im.data();
+
+  // Data are already in bit reversed order. The first stage has unit twiddle factors and
+  // the shortest butterfly loops, so is handled separately.
+  for (size_t i = 0; i + 1 < complexSize; i += 2)
+  {
+    const double tRe = re[i + 1];
+    const double tIm = im[i + 1];
+    re[i + 1] = re[i] - tRe;
+    im[i + 1] = im[i] - tIm;
+    re[i] += tRe;
+    im[i] += tIm;
+  }
+
+  for (size_t halfSize = 2; halfSize < complexSize; halfSize *= 2)
+  {
+    const double *wRe = _twiddleRe.data() + halfSize - 1;
+    const double *wIm = _twiddleIm.data() + halfSize - 1;
+    for (size_t start = 0; start < complexSize; start += 2 * halfSize)
+    {
+      double *aRe = re + start;
+      double *aIm = im + start;
+      double *bRe = aRe + halfSize;
+      double *bIm = aIm + halfSize;
+      for (size_t k = 0; k < halfSize; ++k)
+      {
+        const double tRe = wRe[k] * bRe[k] - wIm[k] * bIm[k];
+        const double tIm = wRe[k] * bIm[k] + wIm[k] * bRe[k];
+        bRe[k] = aRe[k] - tRe;
+        bIm[k] = aIm[k] - tIm;
+        aRe[k] += tRe;
+        aIm[k] += tIm;
+      }
+    }
+  }
+}
@@ -0,0 +1,82 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef FFT_H_
+#define FFT_H_
+
+#include "plotsconfig.h"
+
+#include <cstddef>
+#include <vector>
+
+/// @ingroup expr
+/// A fast Fourier transform of real valued data, supporting spectral analysis functions.
+///
+/// The transform size is a power of two. A real input of size N is transformed
+/// as a complex sequence of N/2 values, packing even samples into the real part and odd
+/// samples into the imaginary part, then separating the spectra. This halves the cost
+/// of transforming real data.
+///
+/// The complex transform is an iterative, radix-2 decimation in time. Data are held in
+/// split real and imaginary arrays and each stage reads its twiddle factors from its own
+/// contiguous table. The butterfly loops thus access memory sequentially, allowing the
+/// compiler to vectorise them.
+///
+/// The tables are built on construction. The working buffers make a transform object
+/// unsuitable for concurrent use, but separate objects may be used on separate threads.
+class Fft
+{
+public:
+  /// Window functions applied to the input before transforming.
+  enum Window
+  {
+    Rectangular,  ///< No windowing.
+    Hann,         ///< Hann window.
+    Hamming       ///< Hamming window.
+  };
+
+  /// Constructor.
+  /// @param size The real transform size. Rounded up to a power of two, at least 2.
+  Fft(size_t size);
+
+  /// Queries the real transform size.
+  /// @return The transform size.
+  inline size_t size() const { return _size; }
+
+  /// Calculates the power of each frequency bin for a real input.
+  ///
+  /// Calculates the squared magnitude of the transform for the bins [0, N/2], where N is
+  /// the transform @c size(). The results are not scaled.
+  ///
+  /// @param input The input samples. Must have @c size() elements.
+  /// @param[out] power The bin powers. Must have @c size() / 2 + 1 elements.
+  void powerSpectrum(const double *input, double *power);
+
+  /// Calculates the coefficients for a window function.
+  /// @param[out] coefficients Set to the window coefficients.
+  /// @param size The window size.
+  /// @param window The window function.
+  static void windowCoefficients(std::vector<double> &coefficients, size_t size, Window window);
+
+  /// Calculates the smallest power of two which is not less than @p value.
+  /// @param value The value to round up. Must be non-zero.
+  /// @return The power of two.
+  static size_t ceilPowerOfTwo(size_t value);
+
+private:
+  /// Performs the complex transform on @c _re and @c _im in place.
+  void transform();
+
+  size_t _size;                   ///< Real transform size.
+  std::vector<double> _twiddleRe; ///< Real part of twiddle factors, for each stage in turn.
+  std::vector<double> _twiddleIm; ///< Imaginary part of twiddle factors, for each stage in turn.
+  std::vector<double> _splitRe;   ///< Real part of factors for separating the real spectrum.
+  std::vector<double> _splitIm;   ///< Imaginary part of factors for separating the real spectrum.
+  std::vector<size_t> _reversed;  ///< Bit reversed indices for the complex transform.
+  std::vector<double> _re;        ///< Working real values.
+  std::vector<double> _im;        ///< Working imaginary values.
+};
+
+#endif // FFT_H_
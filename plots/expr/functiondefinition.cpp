@@ -33,6 +33,25 @@ FunctionDefinition::~FunctionDefinition()
 }
 
 
+bool FunctionDefinition::transformsDomain() const
+{
+  return false;
+}
+
+
+bool FunctionDefinition::transformDomain(PlotExpressionBindDomain & /*domain*/, unsigned /*argc*/,
+                                         const double * /*argv*/, void * /*context*/) const
+{
+  return false;
+}
+
+
+void FunctionDefinition::transform(const PlotExpressionBindDomain & /*domain*/, const double * /*values*/,
+                                   void * /*context*/) const
+{
+}
+
+
 void *FunctionDefinition::createContext() const
 {
   return nullptr;
@@ -44,6 +63,14 @@ void FunctionDefinition::destroyContext(void * /*context*/) const
 
 }
 
+
+bool FunctionDefinition::evaluateBlock(double * /*results*/, const double * /*times*/, size_t /*count*/,
+                                       unsigned /*argc*/, const double *const * /*argv*/) const
+{
+  return false;
+}
+
+
 QString FunctionDefinition::deduceDisplayName() const
 {
   QString display;
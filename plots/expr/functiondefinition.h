@@ -10,6 +10,7 @@
 
 #include <QString>
 
+struct PlotExpressionBindDomain;
 struct PlotFunctionResult;
 struct PlotFunctionInfo;
 
@@ -31,6 +32,14 @@ struct PlotFunctionInfo;
 /// A function may also be variadic, requiring a minimum number of arguments, but supporting
 /// additional values. For example, the @c minof function supports any number of values,
 /// returning the minimum value.
+///
+/// A function may transform the whole series of its first argument into a new domain. For
+/// example, a spectrum transforms a time series into a frequency series. Such functions
+/// return true from @c transformsDomain() and define the new domain in @c transformDomain().
+/// The first argument is sampled over its full domain and passed to @c transform() before
+/// the function is first evaluated. The function is then evaluated over the new domain
+/// without arguments. Any other arguments are treated as parameters and sampled only once,
+/// when binding.
 class FunctionDefinition
 {
 public:
@@ -117,6 +126,59 @@ public:
   ///     This is optained via @c createContext().
   virtual void evaluate(PlotFunctionResult &result, double time, unsigned int argc, const double *argv, const PlotFunctionInfo &info, void *context) const = 0;
 
+  /// Evaluate the function for a block of samples, if supported.
+  ///
+  /// Supports block evaluation for functions which depend only on their arguments,
+  /// not on the @c PlotFunctionInfo or context, and where the display and logical
+  /// values are the same. Such functions may evaluate a whole block without the
+  /// overhead of a call to @c evaluate() per sample.
+  ///
+  /// The default implementation returns false and @c evaluate() must be used.
+  ///
+  /// @param[out] results The result for each sample.
+  /// @param times The sample times.
+  /// @param count The number of samples in the block.
+  /// @param argc The number of arguments actually given.
+  /// @param argv Argument values. Each of the @p argc elements is an array of @p count
+  ///   values.
+  /// @return True if the block has been evaluated, false if block evaluation is not supported.
+  virtual bool evaluateBlock(double *results, const double *times, size_t count, unsigned argc, const double *const *argv) const;
+
+  /// Does this function transform the domain of its first argument?
+  ///
+  /// The default implementation returns false.
+  /// @return True if the function implements @c transformDomain() and @c transform().
+  virtual bool transformsDomain() const;
+
+  /// Defines the domain of the function result for functions which @c transformsDomain().
+  ///
+  /// Called when binding, before the first argument is sampled.
+  ///
+  /// The default implementation returns false.
+  ///
+  /// @param[in,out] domain The domain of the first argument on input. To be modified to
+  ///   the domain of the function result.
+  /// @param argc The number of arguments given.
+  /// @param argv Parameter argument values. Each argument other than the first is sampled
+  ///   at the start of its domain. The first value is not set.
+  /// @param context The context created by @c createContext().
+  /// @return True if the domain can be transformed, false to fail binding.
+  virtual bool transformDomain(PlotExpressionBindDomain &domain, unsigned argc, const double *argv, void *context) const;
+
+  /// Transforms the series of the first argument for functions which @c transformsDomain().
+  ///
+  /// Called before the first call to @c evaluate() after binding. Later calls to
+  /// @c evaluate() are passed no arguments and evaluate the transformed series at the given
+  /// time in the new domain.
+  ///
+  /// The default implementation does nothing.
+  ///
+  /// @param domain The domain of the first argument, as passed to @c transformDomain().
+  /// @param values The first argument sampled over @p domain. Has @c domain.sampleCount
+  ///   elements.
+  /// @param context The context created by @c createContext().
+  virtual void transform(const PlotExpressionBindDomain &domain, const double *values, void *context) const;
+
   /// Called to create an operating context for calculating function values.
   ///
   /// The context may be any type and represents working data required for the function.
@@ -9,6 +9,7 @@
 
 FunctionSimple::FunctionSimple(const ValueFunction &func, const QString &category, const QString &name, const QString &description)
   : FunctionDefinition(category, name, description, 1, false)
+  , _valueFunction(func)
 {
   _function = [func](PlotFunctionResult & result, double /*time*/, unsigned int /*argc*/, const double * argv, const PlotFunctionInfo &/*info*/)
   {
@@ -35,3 +36,19 @@ void FunctionSimple::evaluate(PlotFunctionResult &result, double time, unsigned
 {
   _function(result, time, argc, argv, info);
 }
+
+
+bool FunctionSimple::evaluateBlock(double *results, const double * /*times*/, size_t count, unsigned argc, const double *const *argv) const
+{
+  if (!_valueFunction || argc < 1)
+  {
+    return false;
+  }
+
+  const double *values = argv[0];
+  for (size_t i = 0; i < count; ++i)
+  {
+    results[i] = _valueFunction(values[i]);
+  }
+  return true;
+}
@@ -21,7 +21,7 @@
 ///
 /// Note that a @c ValueFunction is always wrapped up in a
 /// function call which accepts all the arguments of @c ExpandedFunction, but only passes
-/// through @c argv[0].
+/// through @c argv[0]. A @c ValueFunction is also used directly to support @c evaluateBlock().
 class FunctionSimple : public FunctionDefinition
 {
 public:
@@ -82,8 +82,18 @@ public:
   ///     This is optained via @c createContext().
   void evaluate(PlotFunctionResult &result, double time, unsigned int argc, const double *argv, const PlotFunctionInfo &info, void *context) const override;
 
+  /// Evaluates a block of results when constructed from a @c ValueFunction.
+  /// @param[out] results The result for each sample.
+  /// @param times The sample times.
+  /// @param count The number of samples in the block.
+  /// @param argc The number of arguments actually given.
+  /// @param argv Argument value arrays.
+  /// @return True if constructed from a @c ValueFunction, false otherwise.
+  bool evaluateBlock(double *results, const double *times, size_t count, unsigned argc, const double *const *argv) const override;
+
 protected:
   ExpandedFunction _function; ///< The function object.
+  ValueFunction _valueFunction; ///< The @c ValueFunction if constructed from one. Supports @c evaluateBlock().
 };
 
 #endif // FUNCTIONSIMPLE_H_
@@ -0,0 +1,222 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "functionspectrum.h"
+
+#include "fft.h"
+#include "plotexpressionbinddomain.h"
+#include "plotfunctionresult.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/// Default @c psd() segment size.
+#define DEFAULT_PSD_SEGMENT 1024u
+/// Maximum transform size.
+#define MAX_TRANSFORM_SIZE (1u << 30)
+
+struct FunctionSpectrum::Context
+{
+  std::vector<double> spectrum; ///< Calculated spectrum, for each frequency bin.
+  size_t transformSize;         ///< Size of each transformed segment. A power of two.
+  double binWidth;              ///< Width of each frequency bin (Hz).
+  Fft::Window window;           ///< Window function.
+};
+
+
+namespace
+{
+  /// Copies @p count values from @p values to @p segment, applying the window @p coefficients,
+  /// then zero pads @p segment.
+  /// @param segment The segment to populate, sized to the transform size.
+  /// @param values The values to copy. Non-finite values are replaced by zero.
+  /// @param coefficients The window coefficients, with at least @p count elements.
+  /// @param count The number of values to copy.
+  void windowSegment(std::vector<double> &segment, const double *values, const std::vector<double> &coefficients, size_t count)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      const double value = std::isfinite(values[i]) ? values[i] : 0.0;
+      segment[i] = value * coefficients[i];
+    }
+    std::fill(segment.begin() + count, segment.end(), 0.0);
+  }
+
+
+  /// Scales the bins of a single sided @p spectrum which represent both positive and negative
+  /// frequencies.
+  /// @param spectrum The single sided spectrum to adjust.
+  /// @param scale The scale factor for those bins.
+  void foldSpectrum(std::vector<double> &spectrum, double scale)
+  {
+    // The DC and Nyquist bins are unique.
+    for (size_t k = 1; k + 1 < spectrum.size(); ++k)
+    {
+      spectrum[k] *= scale;
+    }
+  }
+}
+
+
+FunctionSpectrum::FunctionSpectrum(Spectrum spectrum, const QString &name, const QString &description,
+                                   const QString &category)
+  : FunctionDefinition(category, name, description, 1, true)
+  , _spectrum(spectrum)
+{
+  if (spectrum == Magnitude)
+  {
+    setDisplayName(QString("%1(x,n=0,window=1)").arg(name));
+  }
+  else
+  {
+    setDisplayName(QString("%1(x,window=1,n=%2)").arg(name).arg(DEFAULT_PSD_SEGMENT));
+  }
+}
+
+
+void FunctionSpectrum::evaluate(PlotFunctionResult &result, double time, unsigned int /*argc*/, const double * /*argv*/, const PlotFunctionInfo &/*info*/, void *contextPtr) const
+{
+  const Context &context = *static_cast<const Context *>(contextPtr);
+  if (context.spectrum.empty() || !(context.binWidth > 0))
+  {
+    result = 0.0;
+    return;
+  }
+
+  const double bin = std::round(time / context.binWidth);
+  const size_t index = (bin > 0) ? std::min(size_t(bin), context.spectrum.size() - 1) : 0u;
+  result = context.spectrum[index];
+}
+
+
+bool FunctionSpectrum::transformsDomain() const
+{
+  return true;
+}
+
+
+bool FunctionSpectrum::transformDomain(PlotExpressionBindDomain &domain, unsigned argc, const double *argv, void *contextPtr) const
+{
+  Context &context = *static_cast<Context *>(contextPtr);
+  if (domain.sampleCount < 2 || !(domain.sampleDelta > 0))
+  {
+    return false;
+  }
+
+  const unsigned sizeArg = (_spectrum == Magnitude) ? 1 : 2;
+  const unsigned windowArg = (_spectrum == Magnitude) ? 2 : 1;
+
+  double size = (_spectrum == Magnitude) ? 0.0 : DEFAULT_PSD_SEGMENT;
+  size = (argc > sizeArg) ? argv[sizeArg] : size;
+  const size_t seriesSize = Fft::ceilPowerOfTwo(std::min<size_t>(domain.sampleCount, MAX_TRANSFORM_SIZE));
+  if (size >= 2)
+  {
+    // No benefit in transforming more than the whole series.
+    context.transformSize = Fft::ceilPowerOfTwo(size_t(std::min<double>(size, MAX_TRANSFORM_SIZE)));
+    context.transformSize = std::min(context.transformSize, seriesSize);
+  }
+  else
+  {
+    context.transformSize = seriesSize;
+  }
+
+  const double window = (argc > windowArg) ? argv[windowArg] : double(Fft::Hann);
+  context.window = (window >= Fft::Rectangular && window <= Fft::Hamming) ? Fft::Window(int(window)) : Fft::Hann;
+
+  const double sampleRate = 1.0 / domain.sampleDelta;
+  context.binWidth = sampleRate / context.transformSize;
+  context.spectrum.clear();
+
+  domain.domainMin = 0;
+  domain.domainMax = 0.5 * sampleRate;
+  domain.sampleDelta = context.binWidth;
+  domain.sampleCount = context.transformSize / 2 + 1;
+  domain.minSet = domain.maxSet = true;
+  return true;
+}
+
+
+void FunctionSpectrum::transform(const PlotExpressionBindDomain &domain, const double *values, void *contextPtr) const
+{
+  Context &context = *static_cast<Context *>(contextPtr);
+  const size_t transformSize = context.transformSize;
+  const size_t binCount = transformSize / 2 + 1;
+  const size_t count = domain.sampleCount;
+  const double sampleRate = context.binWidth * transformSize;
+
+  Fft fft(transformSize);
+  std::vector<double> segment(transformSize);
+  std::vector<double> power(binCount);
+  std::vector<double> coefficients;
+  context.spectrum.assign(binCount, 0.0);
+
+  // Window the available samples when shorter than the transform.
+  const size_t windowSize = std::min(count, transformSize);
+  Fft::windowCoefficients(coefficients, windowSize, context.window);
+
+  if (_spectrum == Magnitude)
+  {
+    double windowSum = 0;
+    for (double coefficient : coefficients)
+    {
+      windowSum += coefficient;
+    }
+
+    windowSegment(segment, values, coefficients, windowSize);
+    fft.powerSpectrum(segment.data(), power.data());
+
+    const double scale = (windowSum > 0) ? 1.0 / windowSum : 0.0;
+    for (size_t k = 0; k < binCount; ++k)
+    {
+      context.spectrum[k] = std::sqrt(power[k]) * scale;
+    }
+    foldSpectrum(context.spectrum, 2.0);
+    return;
+  }
+
+  // Welch's method with half overlapping segments.
+  double windowPower = 0;
+  for (double coefficient : coefficients)
+  {
+    windowPower += coefficient * coefficient;
+  }
+
+  const size_t hop = std::max<size_t>(windowSize / 2, 1u);
+  size_t segmentCount = 0;
+  for (size_t start = 0; start + windowSize <= count; start += hop)
+  {
+    windowSegment(segment, values + start, coefficients, windowSize);
+    fft.powerSpectrum(segment.data(), power.data());
+    for (size_t k = 0; k < binCount; ++k)
+    {
+      context.spectrum[k] += power[k];
+    }
+    ++segmentCount;
+  }
+
+  const double scale = (segmentCount && windowPower > 0) ? 1.0 / (segmentCount * sampleRate * windowPower) : 0.0;
+  for (size_t k = 0; k < binCount; ++k)
+  {
+    context.spectrum[k] *= scale;
+  }
+  foldSpectrum(context.spectrum, 2.0);
+}
+
+
+void *FunctionSpectrum::createContext() const
+{
+  Context *context = new Context;
+  context->transformSize = 0;
+  context->binWidth = 0;
+  context->window = Fft::Hann;
+  return context;
+}
+
+
+void FunctionSpectrum::destroyContext(void *context) const
+{
+  delete static_cast<Context *>(context);
+}
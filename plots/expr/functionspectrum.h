@@ -0,0 +1,77 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef FUNCTIONSPECTRUM_H_
+#define FUNCTIONSPECTRUM_H_
+
+#include "plotsconfig.h"
+
+#include "functiondefinition.h"
+
+/// @ingroup expr
+/// A function which transforms a time series into its frequency spectrum.
+///
+/// The function @c transformsDomain(), generating a curve over frequency in Hertz from
+/// zero to the Nyquist frequency. The time series is taken to be regularly sampled at the
+/// sample delta of the argument domain, and transformed using @c Fft. Non-finite input
+/// values are treated as zero.
+///
+/// Two spectra are supported:
+/// - @c Magnitude - <tt>fft_mag(x,n=0,window=1)</tt> gives the single sided amplitude
+///   spectrum of the first @c n samples of @c x, zero padded to a power of two. The whole
+///   series is transformed when @c n is zero. A sinusoid in @c x yields a peak of its
+///   amplitude.
+/// - @c PowerDensity - <tt>psd(x,window=1,n=1024)</tt> estimates the single sided power
+///   spectral density of @c x using Welch's method. The series is divided into segments of
+///   @c n samples, rounded up to a power of two, overlapping by half. The segment
+///   periodograms are averaged.
+///
+/// The @c window selects the window function applied to each transformed segment: zero for
+/// rectangular, one for Hann or two for Hamming.
+class FunctionSpectrum : public FunctionDefinition
+{
+public:
+  /// The spectrum to calculate.
+  enum Spectrum
+  {
+    Magnitude,    ///< Amplitude spectrum.
+    PowerDensity  ///< Power spectral density estimate.
+  };
+
+  /// Constructor.
+  /// @param spectrum The spectrum to calculate.
+  /// @param name The function name.
+  /// @param description The function description.
+  /// @param category Sorting category.
+  FunctionSpectrum(Spectrum spectrum, const QString &name, const QString &description,
+                   const QString &category = QString());
+
+  /// Evaluates the spectrum at the frequency @p time.
+  void evaluate(PlotFunctionResult &result, double time, unsigned int argc, const double *argv, const PlotFunctionInfo &info, void *context) const override;
+
+  /// Returns true.
+  /// @return True.
+  bool transformsDomain() const override;
+
+  /// Sets the frequency domain according to the transform size.
+  bool transformDomain(PlotExpressionBindDomain &domain, unsigned argc, const double *argv, void *context) const override;
+
+  /// Calculates the spectrum of @p values.
+  void transform(const PlotExpressionBindDomain &domain, const double *values, void *context) const override;
+
+  /// Creates the spectrum object.
+  void *createContext() const override;
+
+  /// Destroys the spectrum object.
+  void destroyContext(void *context) const override;
+
+private:
+  /// Context for @c createContext(). Implementation detail.
+  struct Context;
+
+  Spectrum _spectrum; ///< The spectrum to calculate.
+};
+
+#endif // FUNCTIONSPECTRUM_H_
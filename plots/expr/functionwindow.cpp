@@ -0,0 +1,90 @@
+//
+// author
+//
+// Copyright (c) CSIRO 2015
+//
+#include "functionwindow.h"
+
+#include "plotfunctionresult.h"
+#include "slidingwindow.h"
+
+#include <cmath>
+
+namespace
+{
+  /// Selects the optional @c SlidingWindow statistics required to evaluate @p statistic.
+  /// @param statistic The statistic to evaluate.
+  /// @return The @c SlidingWindow::Feature flags.
+  unsigned windowFeatures(FunctionWindow::Statistic statistic)
+  {
+    switch (statistic)
+    {
+    case FunctionWindow::TimeWeightedMean:
+      return SlidingWindow::TimeWeighted;
+    case FunctionWindow::Minimum:
+    case FunctionWindow::Maximum:
+      return SlidingWindow::Extrema;
+    case FunctionWindow::Median:
+      return SlidingWindow::Median;
+    default:
+      break;
+    }
+    return 0;
+  }
+}
+
+
+FunctionWindow::FunctionWindow(Statistic statistic, const QString &name, const QString &description,
+                               const QString &category, bool byTime)
+  : FunctionDefinition(category, name, description, 2, true)
+  , _statistic(statistic)
+  , _byTime(byTime)
+{
+  setDisplayName(QString("%1(x,window,bytime=%2)").arg(name).arg(byTime ? 1 : 0));
+}
+
+
+void FunctionWindow::evaluate(PlotFunctionResult &result, double time, unsigned int argc, const double *argv, const PlotFunctionInfo &/*info*/, void *contextPtr) const
+{
+  SlidingWindow &window = *static_cast<SlidingWindow *>(contextPtr);
+  const bool byTime = (argc > 2) ? argv[2] != 0 : _byTime;
+
+  // Push new value. Handle NaN and infinite, replacing with zero.
+  const double value = (argv[0] == argv[0] && !std::isinf(argv[0])) ? argv[0] : 0;
+  window.push(time, value, argv[1], byTime);
+
+  switch (_statistic)
+  {
+  case Mean:
+  default:
+    result = window.mean();
+    break;
+  case TimeWeightedMean:
+    result = window.timeWeightedMean();
+    break;
+  case Minimum:
+    result = window.minimum();
+    break;
+  case Maximum:
+    result = window.maximum();
+    break;
+  case StandardDeviation:
+    result = window.standardDeviation();
+    break;
+  case Median:
+    result = window.median();
+    break;
+  }
+}
+
+
+void *FunctionWindow::createContext() const
+{
+  return new SlidingWindow(windowFeatures(_statistic));
+}
+
+
+void FunctionWindow::destroyContext(void *context) const
+{
+  delete static_cast<SlidingWindow *>(context);
+}
@@ -0,0 +1,61 @@
+//
+// author
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef FUNCTIONWINDOW_H_
+#define FUNCTIONWINDOW_H_
+
+#include "plotsconfig.h"
+
+#include "functiondefinition.h"
+
+/// @ingroup expr
+/// A function which evaluates a statistic over a moving window, such as a moving average.
+///
+/// This functions uses context data to maintain a @c SlidingWindow of the history,
+/// reporting the selected statistic of the window. The window is specified by the second
+/// argument either as a number of previous samples, or as a duration preceding the current
+/// sample time. An optional third argument selects windowing by time when non-zero. Each
+/// statistic has a default for this argument.
+///
+/// Non-finite input values are treated as zero.
+class FunctionWindow : public FunctionDefinition
+{
+public:
+  /// The statistic to evaluate over the window.
+  enum Statistic
+  {
+    Mean,               ///< Average of the values.
+    TimeWeightedMean,   ///< Average of the values, weighted by the time between samples.
+    Minimum,            ///< Minimum value.
+    Maximum,            ///< Maximum value.
+    StandardDeviation,  ///< Population standard deviation of the values.
+    Median              ///< Median value.
+  };
+
+  /// Constructor.
+  /// @param statistic The statistic to evaluate.
+  /// @param name The function name.
+  /// @param description The function description.
+  /// @param category Sorting category.
+  /// @param byTime The default windowing mode when the third argument is omitted. True to
+  ///   window by time, false to window by sample count.
+  FunctionWindow(Statistic statistic, const QString &name, const QString &description,
+                 const QString &category = QString(), bool byTime = false);
+
+  /// Updates the window and evaluates the statistic on that window.
+  void evaluate(PlotFunctionResult &result, double time, unsigned int argc, const double *argv, const PlotFunctionInfo &info, void *context) const override;
+
+  /// Creates the window object.
+  void *createContext() const override;
+
+  /// Destroys the window object.
+  void destroyContext(void *context) const override;
+
+private:
+  Statistic _statistic; ///< The statistic to evaluate.
+  bool _byTime;         ///< Default windowing mode.
+};
+
+#endif // FUNCTIONWINDOW_H_
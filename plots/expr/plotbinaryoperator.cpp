@@ -49,6 +49,16 @@ void PlotBinaryOperator::unbind()
 }
 
 
+double *PlotBinaryOperator::blockBuffer(size_t count) const
+{
+  if (_blockBuffer.size() < count)
+  {
+    _blockBuffer.resize(count);
+  }
+  return _blockBuffer.data();
+}
+
+
 bool PlotBinaryOperator::explicitTime() const
 {
   if ((_left && _left->explicitTime()) || (_right && _right->explicitTime()))
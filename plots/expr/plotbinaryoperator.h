@@ -9,9 +9,12 @@
 #include "plotsconfig.h"
 
 #include "plotexpression.h"
+#include "plotexpressionprogram.h"
 
 #include <QTextStream>
 
+#include <vector>
+
 /// @ingroup expr
 /// An extension of @p PlotExpression defining a binary operation.
 /// This is essentially a binary in the expression tree.
@@ -58,9 +61,16 @@ public:
   /// @return True if any child returns true.
   bool explicitTime() const override;
 
+protected:
+  /// Access a working buffer for @c sampleBlock() implementations.
+  /// @param count The required number of elements.
+  /// @return A buffer of at least @p count elements. Valid until the next call.
+  double *blockBuffer(size_t count) const;
+
 private:
   PlotExpression *_left;  ///< Left branch.
   PlotExpression *_right; ///< Right branch.
+  mutable std::vector<double> _blockBuffer; ///< Working buffer for @c sampleBlock().
 };
 
 
@@ -105,6 +115,49 @@ public:
     return Operator()(left()->sample(sampleTime), right()->sample(sampleTime));
   }
 
+  /// Sample the branches for a block of times and evaluate the results.
+  ///
+  /// Each branch is evaluated for the whole block before combining the results
+  /// with @c Operator in a single loop.
+  ///
+  /// @param times The times to sample at.
+  /// @param[out] out The combined results.
+  /// @param count The number of elements in @p times and @p out.
+  void sampleBlock(const double *times, double *out, size_t count) const override
+  {
+    double *rightValues = blockBuffer(count);
+    left()->sampleBlock(times, out, count);
+    right()->sampleBlock(times, rightValues, count);
+    evaluateBlock(out, rightValues, out, count);
+  }
+
+  /// Evaluate @c Operator for blocks of left and right values.
+  ///
+  /// This is the @c PlotExpressionProgram::BinaryKernel for this operator.
+  ///
+  /// @param leftValues The left operands.
+  /// @param rightValues The right operands.
+  /// @param[out] out The results. May alias either operand.
+  /// @param count The number of elements in each array.
+  static void evaluateBlock(const double *leftValues, const double *rightValues, double *out, size_t count)
+  {
+    const Operator op = Operator();
+    for (size_t i = 0; i < count; ++i)
+    {
+      out[i] = op(leftValues[i], rightValues[i]);
+    }
+  }
+
+  /// Compiles the branches and adds a binary instruction using @c evaluateBlock().
+  /// @param program The program to add instructions to.
+  /// @return The result value index.
+  unsigned compile(PlotExpressionProgram &program) const override
+  {
+    const unsigned leftValue = left()->compile(program);
+    const unsigned rightValue = right()->compile(program);
+    return program.addBinary(&evaluateBlock, leftValue, rightValue);
+  }
+
   /// Return the string used to combine left and right branches.
   /// @return The operation string (e.g., "+" for addition).
   inline const QString &opStr() const { return _opStr; }
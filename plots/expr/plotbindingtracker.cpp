@@ -5,6 +5,15 @@
 //
 #include "plotbindingtracker.h"
 
+void PlotBindingTracker::addBoundPlot(PlotInstance *plot)
+{
+  if (!_boundPlots.contains(plot))
+  {
+    _boundPlots.append(plot);
+  }
+}
+
+
 void PlotBindingTracker::setMarker(const PlotExpression *expr, unsigned marker)
 {
   _markers[expr] = marker;
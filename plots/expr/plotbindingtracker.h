@@ -8,7 +8,10 @@
 
 #include "plotsconfig.h"
 
+#include "plotresampler.h"
+
 #include <QHash>
+#include <QList>
 
 class PlotExpression;
 class PlotInstance;
@@ -31,11 +34,47 @@ class PlotInstance;
 /// be progressed if @c isHeld() is false for an expression.
 ///
 /// See @c PlotExpression for further details on multi-binding.
+///
+/// A tracker may also be created to retain existing bindings. In this mode, expressions
+/// which already reference bound data, such as a @c PlotExpression::clone() of a bound
+/// expression, rebind to the same data rather than searching for a new binding. This
+/// allows an independent copy of a bound expression to be evaluated on another thread.
+///
+/// The tracker also carries the options for aligning curves with different time bases:
+/// the @c resamplePolicy() for sampling curves between their samples, and whether to
+/// request sampling at the @c nativeTimes() of the bound curves.
 class PlotBindingTracker
 {
 public:
   /// Create an empty biding.
-  inline PlotBindingTracker() : _firstPlot(nullptr) {}
+  /// @param retainBindings True to retain existing bindings. See @c retainBindings().
+  inline PlotBindingTracker(bool retainBindings = false)
+    : _firstPlot(nullptr), _resamplePolicy(PlotResampler::Linear), _retainBindings(retainBindings), _nativeTimes(false) {}
+
+  /// Should expressions retain their existing bindings?
+  ///
+  /// When true, expressions which already hold a binding (e.g., from a @c PlotExpression::clone())
+  /// should rebind to the same data and report @c Bound.
+  /// @return True to retain existing bindings.
+  inline bool retainBindings() const { return _retainBindings; }
+
+  /// Set the policy used to sample bound curves between their sample times.
+  /// @param policy The resampling policy.
+  inline void setResamplePolicy(PlotResampler::Policy policy) { _resamplePolicy = policy; }
+
+  /// Query the policy used to sample bound curves between their sample times.
+  /// Defaults to @c PlotResampler::Linear.
+  /// @return The resampling policy.
+  inline PlotResampler::Policy resamplePolicy() const { return _resamplePolicy; }
+
+  /// Set whether binding requests sampling at the union of the native sample times of the
+  /// bound curves. See @c PlotExpressionBindDomain::nativeTimes.
+  /// @param native True to request native times.
+  inline void setNativeTimes(bool native) { _nativeTimes = native; }
+
+  /// Query whether binding requests sampling at native sample times. Defaults to false.
+  /// @return True to request native times.
+  inline bool nativeTimes() const { return _nativeTimes; }
 
   /// Request the first bound @c PlotInstance in the tree.
   /// @return The first bound @c PlotInstance.
@@ -52,6 +91,17 @@ public:
   /// Clear @c firstPlot().
   inline void clearFirstPlot() { _firstPlot = nullptr; }
 
+  /// Record @p plot as bound in the tree. Each plot is recorded once.
+  /// @param plot The bound plot.
+  void addBoundPlot(PlotInstance *plot);
+
+  /// Request all the @c PlotInstance objects bound in the tree, in binding order.
+  ///
+  /// This identifies the data referenced by a bound expression. The list accumulates over
+  /// repeated bindings, so a new tracker should be used to identify a single binding.
+  /// @return The bound plots.
+  inline const QList<PlotInstance *> &boundPlots() const { return _boundPlots; }
+
   /// Set the arbitrary marker value for @p expr.
   /// @param expr The expression to set the marker for.
   /// @param marker The marker value.
@@ -84,8 +134,12 @@ public:
 
 private:
   PlotInstance *_firstPlot;       ///< @c firstPlot()
+  QList<PlotInstance *> _boundPlots;  ///< @c boundPlots()
   QHash<const PlotExpression *, unsigned> _markers; ///< Marker hash.
   QHash<const PlotExpression *, bool> _hold;        ///< Hold flags.
+  PlotResampler::Policy _resamplePolicy; ///< @c resamplePolicy()
+  bool _retainBindings;           ///< @c retainBindings()
+  bool _nativeTimes;              ///< @c nativeTimes()
 };
 
 #endif // PLOTBINDINGTRACKER_H_
@@ -5,6 +5,8 @@
 //
 #include "plotbracketexpression.h"
 
+#include "plotexpressionprogram.h"
+
 #include <QTextStream>
 
 double PlotBracketExpression::sample(double sampleTime) const
@@ -13,6 +15,18 @@ double PlotBracketExpression::sample(double sampleTime) const
 }
 
 
+void PlotBracketExpression::sampleBlock(const double *times, double *out, size_t count) const
+{
+  operand()->sampleBlock(times, out, count);
+}
+
+
+unsigned PlotBracketExpression::compile(PlotExpressionProgram &program) const
+{
+  return operand()->compile(program);
+}
+
+
 PlotExpression *PlotBracketExpression::clone() const
 {
   return new PlotBracketExpression(operand()->clone());
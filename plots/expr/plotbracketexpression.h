@@ -24,6 +24,17 @@ public:
   /// @return The sample of @p operand() at time @p sampleTime.
   virtual double sample(double sampleTime) const;
 
+  /// Samples the bracketed expression for a block of times.
+  /// @param times Times at which to sample.
+  /// @param[out] out The samples of @p operand().
+  /// @param count The number of elements in @p times and @p out.
+  void sampleBlock(const double *times, double *out, size_t count) const override;
+
+  /// Compiles the operand. The bracket adds no instructions.
+  /// @param program The program to add instructions to.
+  /// @return The operand value index.
+  unsigned compile(PlotExpressionProgram &program) const override;
+
   /// Clones this expression.
   /// @return A deep copy of this expression.
   virtual PlotExpression *clone() const;
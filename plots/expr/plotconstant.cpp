@@ -5,14 +5,30 @@
 //
 #include "plotconstant.h"
 
+#include "plotexpressionprogram.h"
+
 #include <QTextStream>
 
+#include <algorithm>
+
 double PlotConstant::sample(double /*sampleTime*/) const
 {
   return _constant;
 }
 
 
+void PlotConstant::sampleBlock(const double * /*times*/, double *out, size_t count) const
+{
+  std::fill(out, out + count, _constant);
+}
+
+
+unsigned PlotConstant::compile(PlotExpressionProgram &program) const
+{
+  return program.addConstant(_constant);
+}
+
+
 BindResult PlotConstant::bind(const QList<PlotInstance *> &/*curves*/, PlotBindingTracker &/*info*/, PlotExpressionBindDomain &domain, bool /*repeatLastBinding*/)
 {
   domain.sampleCount = 1;
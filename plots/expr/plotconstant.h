@@ -33,6 +33,17 @@ public:
   /// @return @c constant().
   virtual double sample(double sampleTime) const;
 
+  /// Fill @p out with the constant.
+  /// @param times Ignored.
+  /// @param[out] out Set to @c constant().
+  /// @param count The number of elements in @p out.
+  void sampleBlock(const double *times, double *out, size_t count) const override;
+
+  /// Adds a constant value.
+  /// @param program The program to add instructions to.
+  /// @return The constant value index.
+  unsigned compile(PlotExpressionProgram &program) const override;
+
   /// Always bound, but sets the domain sample count to 1.
   virtual BindResult bind(const QList<PlotInstance *> &curves, PlotBindingTracker &bindTracker, PlotExpressionBindDomain &info, bool repeatLastBinding = false);
 
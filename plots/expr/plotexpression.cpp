@@ -6,6 +6,7 @@
 #include "plotexpression.h"
 
 #include "plotbindinfo.h"
+#include "plotexpressionprogram.h"
 
 PlotExpression::PlotExpression()
 {
@@ -15,3 +16,18 @@ PlotExpression::PlotExpression()
 PlotExpression::~PlotExpression()
 {
 }
+
+
+void PlotExpression::sampleBlock(const double *times, double *out, size_t count) const
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    out[i] = sample(times[i]);
+  }
+}
+
+
+unsigned PlotExpression::compile(PlotExpressionProgram &program) const
+{
+  return program.addExpression(this);
+}
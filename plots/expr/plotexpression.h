@@ -15,6 +15,7 @@
 
 class PlotInstance;
 class PlotBindingTracker;
+class PlotExpressionProgram;
 class QwtPointSeriesData;
 
 /// A @c PlotExpression represents an operation in a plot equation.
@@ -31,7 +32,8 @@ class QwtPointSeriesData;
 ///   - Invoke @p bind() to validate expression generation for this source file.
 ///   - Generate a new curve for each successfull @c bind()
 ///   - Iterate the sample range generated by the @c PlotExpressionBindInfo from @c bind()
-///     - Call @c sample() for each time value.
+///     - Call @c sampleBlock() for each block of time values, or @c sample() for each
+///       time value.
 ///   - Cleanup by calling @c unbind()
 ///   - Attempt next binding
 ///
@@ -83,6 +85,8 @@ class QwtPointSeriesData;
 ///
 /// Derivations must implement the following methods:
 /// - @c sample() - Generate a sample at the requested time.
+/// - @c sampleBlock() - (Optional) Generate samples for a block of times.
+/// - @c compile() - (Optional) Lower the expression into a @c PlotExpressionProgram.
 /// - @c bind() - Initialise sampling of the expression on the given operands.
 /// - @c unbind() - (Optional) Clean up sampling state.
 /// - @c clone() - Create a deep clone of the @c PlotExpression.
@@ -108,6 +112,37 @@ public:
   /// @return The calculated sample at @p sampleTime.
   virtual double sample(double sampleTime) const = 0;
 
+  /// Called to generate samples for a block of sample times.
+  ///
+  /// This must yield the same results as calling @c sample() for each of the @p times
+  /// in order, but allows each node of an expression tree to process a whole block
+  /// at a time. Stateful expressions must maintain their state across blocks such that
+  /// the results do not depend on how samples are divided into blocks.
+  ///
+  /// The default implementation calls @c sample() for each time.
+  ///
+  /// This method may only be called after a successfull call to @c bind().
+  ///
+  /// @param times The times to sample the expression at. Must not overlap @p out.
+  /// @param[out] out Populated with the calculated sample for each of the @p times.
+  /// @param count The number of elements in @p times and @p out.
+  virtual void sampleBlock(const double *times, double *out, size_t count) const;
+
+  /// Lower this expression into instructions in @p program.
+  ///
+  /// Implementations compile their child expressions, then add an instruction
+  /// combining the child values. See @c PlotExpressionProgram.
+  ///
+  /// The default implementation adds an opaque instruction which calls
+  /// @c sampleBlock() on this expression.
+  ///
+  /// This method may only be called after a successfull call to @c bind(). The
+  /// program is invalid once the expression is unbound.
+  ///
+  /// @param program The program to add instructions to.
+  /// @return The program value index for the result of this expression.
+  virtual unsigned compile(PlotExpressionProgram &program) const;
+
   /// Attempts to binds the @c PlotExpression to sample the given @p curves.
   ///
   /// The @c bind() implementations must first check if the @c PlotExpression can
@@ -71,4 +71,17 @@ void domainUnion(PlotExpressionBindDomain &result, const PlotExpressionBindDomai
   }
 
   result.sampleCount = 1u + std::max<size_t>(size_t((result.domainMax - result.domainMin) / result.sampleDelta), 1u);
+
+  result.nativeTimes = a.nativeTimes || b.nativeTimes;
+  if (&result != &a)
+  {
+    result.timeSources = a.timeSources;
+  }
+  for (const PlotInstanceSampler *source : b.timeSources)
+  {
+    if (std::find(result.timeSources.begin(), result.timeSources.end(), source) == result.timeSources.end())
+    {
+      result.timeSources.push_back(source);
+    }
+  }
 }
@@ -9,6 +9,9 @@
 #include "plotsconfig.h"
 
 #include <cstddef>
+#include <vector>
+
+class PlotInstanceSampler;
 
 /// @ingroup expr
 /// Return values for the @c PlotExpression::bind() method.
@@ -26,7 +29,9 @@ enum BindResult
 /// This is populated by calls to @c PlotExpression::bind() and used to generate
 /// the sample times passed to @c PlotExpression::sample().
 ///
-/// The sampling loop is defined by the following pseudo code:
+/// The sampling loop is defined by the following pseudo code. In practice, the sample
+/// times are generated in blocks and passed to @c PlotExpression::sampleBlock(), but
+/// the times and sampling order are the same.
 /// @verbatim
 ///   define info as PlotExpressionBindInfo
 ///   define expr as PlotExpression
@@ -37,6 +42,11 @@ enum BindResult
 ///     expr->sample(sampleTime)
 /// @endverbatim
 ///
+/// When @c nativeTimes is set and there are @c timeSources, the uniform sample times are
+/// instead replaced by the union of the sample times of the @c timeSources within
+/// [@c domainMin, @c domainMax]. See @c PlotResampler::mergeTimes(). This avoids
+/// interpolation artefacts when combining curves with different sample rates.
+///
 /// An unbounded domain can be defined by calling @c setUnbounded() or tested for
 /// via @c isUnbounded(). For example, a constant value has an unbounded domain.
 /// An unbounded domain has the following characteristics:
@@ -54,9 +64,14 @@ struct PlotExpressionBindDomain
   size_t sampleCount; ///< The number of samples to be generated.
   bool minSet;        ///< @c domainMin is set and relevant.
   bool maxSet;        ///< @c domainMax is set and relevant.
+  bool nativeTimes;   ///< Request sampling at the sample times of the @c timeSources.
+  /// The curves bound in the domain, for @c nativeTimes. These are the samplers of the bound
+  /// expression tree, so are valid while it remains bound.
+  std::vector<const PlotInstanceSampler *> timeSources;
 
   /// Constructor. Creates an unbounded domain.
-  inline PlotExpressionBindDomain() : domainMin(0), domainMax(0), sampleDelta(0), sampleCount(0), minSet(false), maxSet(false) {}
+  inline PlotExpressionBindDomain()
+    : domainMin(0), domainMax(0), sampleDelta(0), sampleCount(0), minSet(false), maxSet(false), nativeTimes(false) {}
 
   /// Sets the domain to be unbounded.
   void setUnbounded();
@@ -95,6 +110,9 @@ struct PlotExpressionBindDomain
 /// Otherwise, the sample delta is set to the domain range. The sample count
 /// is dependent on the sample delta, but is at least two for a bounded domain.
 ///
+/// The @c timeSources are combined, excluding duplicates, and @c nativeTimes is set if
+/// requested by either operand.
+///
 /// If either @p a or @p b are unbounded, then the @p result is set to the other.
 /// Thus the result can only be unbounded if both @p a and @p b are unbounded.
 ///
@@ -119,6 +137,8 @@ inline void PlotExpressionBindDomain::setUnbounded()
   domainMin = domainMax = sampleDelta = 0;
   sampleCount = 0u;
   minSet = maxSet = false;
+  nativeTimes = false;
+  timeSources.clear();
 }
 
 
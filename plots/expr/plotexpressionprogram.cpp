@@ -0,0 +1,404 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "plotexpressionprogram.h"
+
+#include "functiondefinition.h"
+#include "plotexpression.h"
+#include "plotfunction.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+  /// Register marker for unreferenced constants.
+  const unsigned NoRegister = ~0u;
+}
+
+PlotExpressionProgram::Instruction::Instruction(InstructionType type)
+  : type(type)
+  , reg(0)
+  , argStart(0)
+  , argCount(0)
+  , constant(0)
+  , unary(nullptr)
+  , binary(nullptr)
+  , expression(nullptr)
+  , key(nullptr)
+{
+  operands[0] = operands[1] = 0;
+}
+
+
+PlotExpressionProgram::PlotExpressionProgram()
+  : _blockCapacity(0)
+  , _registerCount(0)
+  , _result(0)
+{
+}
+
+
+void PlotExpressionProgram::clear()
+{
+  _instructions.clear();
+  _args.clear();
+  _registers.clear();
+  _argBlocks.clear();
+  _blockCapacity = 0;
+  _registerCount = 0;
+  _result = 0;
+}
+
+
+bool PlotExpressionProgram::compile(const PlotExpression *expression)
+{
+  clear();
+  if (!expression)
+  {
+    return false;
+  }
+
+  _result = expression->compile(*this);
+  allocateRegisters();
+  return true;
+}
+
+
+void PlotExpressionProgram::sampleBlock(const double *times, double *out, size_t count)
+{
+  if (!count)
+  {
+    return;
+  }
+
+  if (_instructions.empty())
+  {
+    std::fill(out, out + count, 0.0);
+    return;
+  }
+
+  const Instruction &result = _instructions[_result];
+  if (result.type == Constant)
+  {
+    std::fill(out, out + count, result.constant);
+    return;
+  }
+
+  reserve(count);
+
+  // The result register maps directly to the output. The register is only shared with
+  // values calculated before the result, so this is safe to use as working space.
+  const unsigned resultRegister = result.reg;
+  double *registers = _registers.data();
+  const size_t capacity = _blockCapacity;
+  auto reg = [this, resultRegister, registers, capacity, out] (unsigned value) -> double *
+  {
+    const unsigned r = _instructions[value].reg;
+    return (r == resultRegister) ? out : registers + r * capacity;
+  };
+
+  for (const Instruction &instruction : _instructions)
+  {
+    if (instruction.type == Constant)
+    {
+      // Populated by reserve().
+      continue;
+    }
+
+    double *dst = (instruction.reg == resultRegister) ? out : registers + instruction.reg * capacity;
+    switch (instruction.type)
+    {
+    case Unary:
+      instruction.unary(reg(instruction.operands[0]), dst, count);
+      break;
+
+    case Binary:
+      instruction.binary(reg(instruction.operands[0]), reg(instruction.operands[1]), dst, count);
+      break;
+
+    case Function:
+      for (unsigned i = 0; i < instruction.argCount; ++i)
+      {
+        _argBlocks[i] = reg(_args[instruction.argStart + i]);
+      }
+      static_cast<const PlotFunction *>(instruction.expression)->evaluateBlock(times, _argBlocks.data(), dst, count);
+      break;
+
+    case Expression:
+      instruction.expression->sampleBlock(times, dst, count);
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+
+unsigned PlotExpressionProgram::addConstant(double value)
+{
+  Instruction instruction(Constant);
+  instruction.constant = value;
+  return add(instruction);
+}
+
+
+unsigned PlotExpressionProgram::addUnary(UnaryKernel kernel, unsigned operand)
+{
+  if (isConstant(operand))
+  {
+    double value = 0;
+    kernel(&_instructions[operand].constant, &value, 1);
+    return addConstant(value);
+  }
+
+  Instruction instruction(Unary);
+  instruction.unary = kernel;
+  instruction.operands[0] = operand;
+  return add(instruction);
+}
+
+
+unsigned PlotExpressionProgram::addBinary(BinaryKernel kernel, unsigned left, unsigned right)
+{
+  if (isConstant(left) && isConstant(right))
+  {
+    double value = 0;
+    kernel(&_instructions[left].constant, &_instructions[right].constant, &value, 1);
+    return addConstant(value);
+  }
+
+  Instruction instruction(Binary);
+  instruction.binary = kernel;
+  instruction.operands[0] = left;
+  instruction.operands[1] = right;
+  return add(instruction);
+}
+
+
+unsigned PlotExpressionProgram::addFunction(const PlotFunction *function, const unsigned *args, unsigned argc)
+{
+  // Fold stateless functions of constant arguments.
+  bool constantArgs = argc > 0 && function->function();
+  for (unsigned i = 0; constantArgs && i < argc; ++i)
+  {
+    constantArgs = isConstant(args[i]);
+  }
+
+  if (constantArgs)
+  {
+    std::vector<const double *> argValues(argc);
+    for (unsigned i = 0; i < argc; ++i)
+    {
+      argValues[i] = &_instructions[args[i]].constant;
+    }
+
+    const double time = 0;
+    double value = 0;
+    if (function->function()->evaluateBlock(&value, &time, 1, argc, argValues.data()))
+    {
+      return addConstant(value);
+    }
+  }
+
+  Instruction instruction(Function);
+  instruction.expression = function;
+  instruction.argStart = unsigned(_args.size());
+  instruction.argCount = argc;
+  _args.insert(_args.end(), args, args + argc);
+  const unsigned value = add(instruction);
+  if (value + 1 < _instructions.size())
+  {
+    // Matched an existing instruction. Remove the arguments.
+    _args.resize(instruction.argStart);
+  }
+  return value;
+}
+
+
+unsigned PlotExpressionProgram::addExpression(const PlotExpression *expression, const void *key)
+{
+  Instruction instruction(Expression);
+  instruction.expression = expression;
+  instruction.key = key;
+  return add(instruction);
+}
+
+
+bool PlotExpressionProgram::isConstant(unsigned value) const
+{
+  return value < _instructions.size() && _instructions[value].type == Constant;
+}
+
+
+unsigned PlotExpressionProgram::add(const Instruction &instruction)
+{
+  for (size_t i = 0; i < _instructions.size(); ++i)
+  {
+    const Instruction &other = _instructions[i];
+    if (other.type != instruction.type)
+    {
+      continue;
+    }
+
+    bool match = false;
+    switch (instruction.type)
+    {
+    case Constant:
+      // Bitwise comparison to match NaN values.
+      match = memcmp(&other.constant, &instruction.constant, sizeof(instruction.constant)) == 0;
+      break;
+
+    case Unary:
+      match = other.unary == instruction.unary && other.operands[0] == instruction.operands[0];
+      break;
+
+    case Binary:
+      match = other.binary == instruction.binary &&
+              other.operands[0] == instruction.operands[0] &&
+              other.operands[1] == instruction.operands[1];
+      break;
+
+    case Function:
+      // Functions are deterministic given the same argument sequence, so equivalent calls
+      // yield the same results, even for stateful functions.
+      match = other.argCount == instruction.argCount &&
+              static_cast<const PlotFunction *>(other.expression)->function() ==
+              static_cast<const PlotFunction *>(instruction.expression)->function() &&
+              std::equal(_args.begin() + other.argStart, _args.begin() + other.argStart + other.argCount,
+                         _args.begin() + instruction.argStart);
+      break;
+
+    case Expression:
+      match = other.expression == instruction.expression || (instruction.key && other.key == instruction.key);
+      break;
+    }
+
+    if (match)
+    {
+      return unsigned(i);
+    }
+  }
+
+  _instructions.push_back(instruction);
+  return unsigned(_instructions.size() - 1);
+}
+
+
+void PlotExpressionProgram::allocateRegisters()
+{
+  const size_t instructionCount = _instructions.size();
+  size_t maxArgs = 0;
+
+  // Find the last instruction referencing each value. The result is referenced beyond the end.
+  std::vector<size_t> lastUse(instructionCount);
+  for (size_t i = 0; i < instructionCount; ++i)
+  {
+    const Instruction &instruction = _instructions[i];
+    lastUse[i] = i;
+    switch (instruction.type)
+    {
+    case Binary:
+      lastUse[instruction.operands[1]] = i;
+      // Fall through
+    case Unary:
+      lastUse[instruction.operands[0]] = i;
+      break;
+    case Function:
+      for (unsigned a = 0; a < instruction.argCount; ++a)
+      {
+        lastUse[_args[instruction.argStart + a]] = i;
+      }
+      maxArgs = std::max<size_t>(maxArgs, instruction.argCount);
+      break;
+    default:
+      break;
+    }
+  }
+  if (_result < instructionCount)
+  {
+    lastUse[_result] = instructionCount;
+  }
+
+  std::vector<unsigned> freeRegisters;
+  std::vector<bool> released(instructionCount, false);
+  auto release = [&] (unsigned value, size_t at)
+  {
+    // Constants keep their registers.
+    if (lastUse[value] == at && !released[value] && _instructions[value].type != Constant)
+    {
+      freeRegisters.push_back(_instructions[value].reg);
+      released[value] = true;
+    }
+  };
+
+  _registerCount = 0;
+  for (size_t i = 0; i < instructionCount; ++i)
+  {
+    Instruction &instruction = _instructions[i];
+
+    if (instruction.type == Constant)
+    {
+      // Constants are populated once by reserve() so need dedicated registers. Skip
+      // unreferenced constants, left over from constant folding.
+      instruction.reg = (lastUse[i] != i) ? _registerCount++ : NoRegister;
+      continue;
+    }
+
+    // Unary and binary kernels operate element by element, so the result may overwrite
+    // an operand at its last use. Function arguments are released only after allocating
+    // the result as the function implementation may not support this.
+    if (instruction.type == Unary || instruction.type == Binary)
+    {
+      release(instruction.operands[0], i);
+      if (instruction.type == Binary)
+      {
+        release(instruction.operands[1], i);
+      }
+    }
+
+    if (!freeRegisters.empty())
+    {
+      instruction.reg = freeRegisters.back();
+      freeRegisters.pop_back();
+    }
+    else
+    {
+      instruction.reg = _registerCount++;
+    }
+
+    if (instruction.type == Function)
+    {
+      for (unsigned a = 0; a < instruction.argCount; ++a)
+      {
+        release(_args[instruction.argStart + a], i);
+      }
+    }
+  }
+
+  _argBlocks.resize(maxArgs);
+}
+
+
+void PlotExpressionProgram::reserve(size_t count)
+{
+  if (count <= _blockCapacity)
+  {
+    return;
+  }
+
+  _blockCapacity = count;
+  _registers.resize(_blockCapacity * _registerCount);
+
+  for (const Instruction &instruction : _instructions)
+  {
+    if (instruction.type == Constant && instruction.reg != NoRegister)
+    {
+      double *reg = _registers.data() + instruction.reg * _blockCapacity;
+      std::fill(reg, reg + _blockCapacity, instruction.constant);
+    }
+  }
+}
@@ -0,0 +1,183 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef PLOTEXPRESSIONPROGRAM_H_
+#define PLOTEXPRESSIONPROGRAM_H_
+
+#include "plotsconfig.h"
+
+#include <cstddef>
+#include <vector>
+
+class PlotExpression;
+class PlotFunction;
+
+/// @ingroup expr
+/// A @c PlotExpression tree lowered to a flat instruction stream for fast block sampling.
+///
+/// A program is compiled from a bound @c PlotExpression tree and is valid until the tree
+/// is unbound or rebound. Compilation walks the tree via @c PlotExpression::compile(),
+/// with each node adding an instruction to calculate its value. Each instruction is
+/// identified by a value index, which later instructions reference as operands.
+/// Instructions are evaluated in order for a whole block of sample times with each
+/// value held in a register: an array of samples for the block.
+///
+/// Compilation performs the following optimisations:
+/// - Constant folding: arithmetic on constant values and stateless functions with
+///   constant arguments (see @c FunctionDefinition::evaluateBlock()) are evaluated once.
+/// - Common subexpression elimination: identical instructions on identical operands
+///   share a single value. Notably, repeated references to the same curve are
+///   sampled only once per sample time.
+/// - Register reuse: registers are reused once their value is no longer referenced,
+///   minimising the working memory for a block.
+///
+/// Expressions which cannot be lowered, such as slicing, are added as opaque instructions
+/// which call @c PlotExpression::sampleBlock() on that part of the tree.
+///
+/// Sampling a program yields the same results as @c PlotExpression::sampleBlock() on the
+/// root expression.
+class PlotExpressionProgram
+{
+public:
+  /// Kernel function for evaluating a unary instruction over a block.
+  typedef void (*UnaryKernel)(const double *operand, double *out, size_t count);
+  /// Kernel function for evaluating a binary instruction over a block.
+  typedef void (*BinaryKernel)(const double *left, const double *right, double *out, size_t count);
+
+  /// Constructor.
+  PlotExpressionProgram();
+
+  /// Clears the program.
+  void clear();
+
+  /// Compile the program from a bound @p expression.
+  ///
+  /// Any existing program is cleared first.
+  ///
+  /// @param expression The root of the expression tree to compile. Must be bound.
+  /// @return True on success, false if @p expression is null.
+  bool compile(const PlotExpression *expression);
+
+  /// Is the program valid for sampling?
+  /// @return True if a program has been compiled.
+  inline bool isValid() const { return !_instructions.empty(); }
+
+  /// Query the number of instructions in the program.
+  /// @return The instruction count.
+  inline unsigned instructionCount() const { return unsigned(_instructions.size()); }
+
+  /// Query the number of registers required to evaluate the program.
+  /// @return The register count.
+  inline unsigned registerCount() const { return _registerCount; }
+
+  /// Sample the program for a block of times.
+  ///
+  /// Results match those of @c PlotExpression::sampleBlock() on the compiled expression.
+  ///
+  /// @param times The times to sample at. Must not overlap @p out.
+  /// @param[out] out Populated with the calculated sample for each of the @p times.
+  /// @param count The number of elements in @p times and @p out.
+  void sampleBlock(const double *times, double *out, size_t count);
+
+  /// @name Compilation
+  /// Functions used by @c PlotExpression::compile() to add instructions. Each returns the
+  /// value index of the instruction result. An existing value may be returned when an
+  /// equivalent instruction has already been added.
+  /// @{
+
+  /// Add a constant value.
+  /// @param value The constant value.
+  /// @return The value index.
+  unsigned addConstant(double value);
+
+  /// Add a unary operation.
+  /// @param kernel Function used to evaluate the operation.
+  /// @param operand The value index of the operand.
+  /// @return The value index.
+  unsigned addUnary(UnaryKernel kernel, unsigned operand);
+
+  /// Add a binary operation.
+  /// @param kernel Function used to evaluate the operation.
+  /// @param left The value index of the left operand.
+  /// @param right The value index of the right operand.
+  /// @return The value index.
+  unsigned addBinary(BinaryKernel kernel, unsigned left, unsigned right);
+
+  /// Add a function call, evaluated by @c PlotFunction::evaluateBlock().
+  /// @param function The function expression.
+  /// @param args The value indices of the function arguments.
+  /// @param argc The number of @p args. Must match the @c PlotFunction::args().
+  /// @return The value index.
+  unsigned addFunction(const PlotFunction *function, const unsigned *args, unsigned argc);
+
+  /// Add an opaque expression, evaluated by @c PlotExpression::sampleBlock().
+  ///
+  /// Opaque expressions sharing the same non-null @p key are considered equivalent.
+  /// For example, @c PlotSample uses the bound curve as the key.
+  ///
+  /// @param expression The expression to evaluate.
+  /// @param key Optional key identifying equivalent expressions.
+  /// @return The value index.
+  unsigned addExpression(const PlotExpression *expression, const void *key = nullptr);
+
+  /// Is @p value a constant value?
+  /// @param value The value index to test.
+  /// @return True if @p value is a constant.
+  bool isConstant(unsigned value) const;
+
+  /// @}
+
+private:
+  /// Instruction types.
+  enum InstructionType
+  {
+    Constant,
+    Unary,
+    Binary,
+    Function,
+    Expression
+  };
+
+  /// A program instruction.
+  struct Instruction
+  {
+    InstructionType type;   ///< The instruction type.
+    unsigned reg;           ///< The register holding the result.
+    unsigned operands[2];   ///< Value indices of the operands for @c Unary and @c Binary.
+    unsigned argStart;      ///< Index of the first @c Function argument in @c _args.
+    unsigned argCount;      ///< Number of @c Function arguments.
+    double constant;        ///< Value of a @c Constant.
+    UnaryKernel unary;      ///< @c Unary kernel.
+    BinaryKernel binary;    ///< @c Binary kernel.
+    const PlotExpression *expression; ///< The @c Function or @c Expression node.
+    const void *key;        ///< Equivalence key for an @c Expression.
+
+    /// Constructor.
+    /// @param type The instruction type.
+    Instruction(InstructionType type);
+  };
+
+  /// Add @p instruction or find an equivalent existing instruction.
+  /// @param instruction The instruction to add.
+  /// @return The value index for @p instruction.
+  unsigned add(const Instruction &instruction);
+
+  /// Assign registers to each instruction, reusing registers no longer referenced.
+  void allocateRegisters();
+
+  /// Ensure register storage for blocks of at least @p count samples.
+  /// @param count The block size.
+  void reserve(size_t count);
+
+  std::vector<Instruction> _instructions;   ///< Instructions in evaluation order.
+  std::vector<unsigned> _args;              ///< Argument value indices for @c Function instructions.
+  std::vector<double> _registers;           ///< Register storage.
+  std::vector<const double *> _argBlocks;   ///< Working argument pointers for @c Function instructions.
+  size_t _blockCapacity;                    ///< Samples per register in @c _registers.
+  unsigned _registerCount;                  ///< Number of registers.
+  unsigned _result;                         ///< Value index of the program result.
+};
+
+#endif // PLOTEXPRESSIONPROGRAM_H_
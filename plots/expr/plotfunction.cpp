@@ -8,14 +8,20 @@
 #include "functiondefinition.h"
 #include "plotbindinfo.h"
 #include "plotbindingtracker.h"
+#include "plotexpressionprogram.h"
 
 #include <QTextStream>
 
+#include <algorithm>
+
+/// The number of samples in each block when sampling the argument of a domain transform function.
+#define TRANSFORM_BLOCK_SIZE 1024u
 
 PlotFunction::PlotFunction(const FunctionDefinition *function, const QVector<PlotExpression *> &args)
   : _args(args)
   , _function(function)
   , _functionContext(nullptr)
+  , _transformed(false)
 {
 }
 
@@ -65,6 +71,34 @@ BindResult PlotFunction::bind(const QList<PlotInstance *> &curves, PlotBindingTr
     {
       domainUnion(info, bindings[i].domain);
     }
+
+    if (_function->transformsDomain())
+    {
+      // Sample parameters once at the start of their domains, as for slice indexers.
+      // The first argument is sampled in full when first required.
+      const unsigned argc = unsigned(_args.count());
+      double *argv = (double *)alloca(sizeof(double) * argc);
+      argv[0] = 0;
+      for (unsigned i = 1; i < argc; ++i)
+      {
+        argv[i] = _args[i]->sample(bindings[i].domain.domainMin);
+      }
+
+      _argDomain = bindings[0].domain;
+      _transformed = false;
+      info = _argDomain;
+      if (!_function->transformDomain(info, argc, argv, _functionContext))
+      {
+        foreach (PlotExpression *e, _args)
+        {
+          e->unbind();
+        }
+        return BindError;
+      }
+      // The transformed domain is not sampled at the argument sample times.
+      info.nativeTimes = false;
+      info.timeSources.clear();
+    }
   }
 
   return bindRes;
@@ -83,6 +117,12 @@ void PlotFunction::unbind()
 
 double PlotFunction::sample(double sampleTime) const
 {
+  if (_function && _function->transformsDomain())
+  {
+    transformArgs();
+    return sampleTransformed(sampleTime);
+  }
+
   unsigned argc = unsigned(_args.count());
   if (argc && _function)
   {
@@ -103,6 +143,118 @@ double PlotFunction::sample(double sampleTime) const
 }
 
 
+void PlotFunction::sampleBlock(const double *times, double *out, size_t count) const
+{
+  if (_function && _function->transformsDomain())
+  {
+    transformArgs();
+    for (size_t j = 0; j < count; ++j)
+    {
+      out[j] = sampleTransformed(times[j]);
+    }
+    return;
+  }
+
+  const unsigned argc = unsigned(_args.count());
+  if (!argc || !_function || !count)
+  {
+    std::fill(out, out + count, 0.0);
+    return;
+  }
+
+  if (_argBlock.size() < argc * count)
+  {
+    _argBlock.resize(argc * count);
+  }
+
+  const double **argBlocks = (const double **)alloca(sizeof(double *) * argc);
+  for (unsigned i = 0; i < argc; ++i)
+  {
+    double *argValues = _argBlock.data() + i * count;
+    _args[i]->sampleBlock(times, argValues, count);
+    argBlocks[i] = argValues;
+  }
+
+  evaluateBlock(times, argBlocks, out, count);
+}
+
+
+void PlotFunction::evaluateBlock(const double *times, const double *const *argValues, double *out, size_t count) const
+{
+  const unsigned argc = unsigned(_args.count());
+  if (!argc || !_function || !count)
+  {
+    std::fill(out, out + count, 0.0);
+    return;
+  }
+
+  if (_function->evaluateBlock(out, times, count, argc, argValues))
+  {
+    // Maintain the sampling info as sample() does.
+    for (size_t j = 0; j < count; ++j)
+    {
+      _info.total += out[j];
+    }
+    _info.lastTime = times[count - 1];
+    _info.lastValue = out[count - 1];
+    _info.count += unsigned(count);
+    return;
+  }
+
+  double *argv = (double *)alloca(sizeof(double) * argc);
+  PlotFunctionResult res;
+  for (size_t j = 0; j < count; ++j)
+  {
+    for (unsigned i = 0; i < argc; ++i)
+    {
+      argv[i] = argValues[i][j];
+    }
+    _function->evaluate(res, times[j], argc, argv, _info, _functionContext);
+    _info.lastTime = times[j];
+    _info.lastValue = res;
+    _info.total += res.logicalValue;
+    ++_info.count;
+    out[j] = res.displayValue;
+  }
+}
+
+
+bool PlotFunction::explicitTime() const
+{
+  if (_function && _function->transformsDomain())
+  {
+    return true;
+  }
+
+  foreach (PlotExpression *e, _args)
+  {
+    if (e->explicitTime())
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+unsigned PlotFunction::compile(PlotExpressionProgram &program) const
+{
+  if (_function && _function->transformsDomain())
+  {
+    // The arguments are not sampled at the program's sample times.
+    return PlotExpression::compile(program);
+  }
+
+  std::vector<unsigned> args(_args.count());
+  for (int i = 0; i < _args.count(); ++i)
+  {
+    args[i] = _args[i]->compile(program);
+  }
+  return program.addFunction(this, args.data(), unsigned(args.size()));
+}
+
+
 QVector<PlotExpression *> PlotFunction::cloneArgs() const
 {
   QVector<PlotExpression *> args;
@@ -120,6 +272,56 @@ PlotExpression *PlotFunction::clone() const
 }
 
 
+void PlotFunction::transformArgs() const
+{
+  if (_transformed || _args.empty())
+  {
+    return;
+  }
+
+  _transformed = true;
+
+  // Sample the first argument as PlotExpressionGenerator samples an expression.
+  const PlotExpressionBindDomain &domain = _argDomain;
+  std::vector<double> values(domain.sampleCount);
+  std::vector<double> times(TRANSFORM_BLOCK_SIZE);
+  PlotExpressionProgram program;
+  const bool compiled = program.compile(_args[0]);
+  for (size_t blockStart = 0; blockStart < domain.sampleCount; blockStart += TRANSFORM_BLOCK_SIZE)
+  {
+    const size_t blockSize = std::min<size_t>(TRANSFORM_BLOCK_SIZE, domain.sampleCount - blockStart);
+    for (size_t j = 0; j < blockSize; ++j)
+    {
+      times[j] = std::min(domain.domainMin + (blockStart + j) * domain.sampleDelta, domain.domainMax);
+    }
+
+    if (compiled)
+    {
+      program.sampleBlock(times.data(), values.data() + blockStart, blockSize);
+    }
+    else
+    {
+      _args[0]->sampleBlock(times.data(), values.data() + blockStart, blockSize);
+    }
+  }
+  program.clear();
+
+  _function->transform(domain, values.data(), _functionContext);
+}
+
+
+double PlotFunction::sampleTransformed(double sampleTime) const
+{
+  PlotFunctionResult res;
+  _function->evaluate(res, sampleTime, 0, nullptr, _info, _functionContext);
+  _info.lastTime = sampleTime;
+  _info.lastValue = res;
+  _info.total += res.logicalValue;
+  ++_info.count;
+  return res.displayValue;
+}
+
+
 QString PlotFunction::stringExpression() const
 {
   QString str;
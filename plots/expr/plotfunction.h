@@ -15,6 +15,8 @@
 
 #include <QVector>
 
+#include <vector>
+
 class FunctionDefinition;
 
 /// @ingroup expr
@@ -28,6 +30,12 @@ class FunctionDefinition;
 /// the results.
 ///
 /// The number of @c args() in the expression must match that of the @c FunctionDefinition.
+///
+/// Functions which @c FunctionDefinition::transformsDomain() are handled differently. The
+/// parameter arguments are sampled once on binding and the bound domain is that given by
+/// @c FunctionDefinition::transformDomain(). The first argument is sampled over its own
+/// domain on the first call to @c sample() or @c sampleBlock(), and the series passed to
+/// @c FunctionDefinition::transform(). The result is then sampled without arguments.
 class PlotFunction : public PlotExpression
 {
 public:
@@ -55,6 +63,38 @@ public:
   /// the @c function() object.
   virtual double sample(double sampleTime) const;
 
+  /// Sample a block of times. Each of the @c args() is sampled for the whole block before
+  /// evaluating the @c function() for each sample in order, preserving any function state
+  /// across blocks. Uses @c FunctionDefinition::evaluateBlock() where supported.
+  /// @param times The times to sample at.
+  /// @param[out] out The function results.
+  /// @param count The number of elements in @p times and @p out.
+  void sampleBlock(const double *times, double *out, size_t count) const override;
+
+  /// Evaluate the @c function() for a block of argument values, as sampled from the @c args().
+  ///
+  /// This supports @c sampleBlock() and @c PlotExpressionProgram. Samples must be evaluated
+  /// in order as for @c sampleBlock().
+  ///
+  /// @param times The sample times.
+  /// @param argValues Argument value blocks, one for each of the @c args(), each with @p count
+  ///   values. Must not overlap @p out.
+  /// @param[out] out The function results.
+  /// @param count The number of samples in the block.
+  void evaluateBlock(const double *times, const double *const *argValues, double *out, size_t count) const;
+
+  /// Is the result sampled with explicit time values?
+  /// @return True if the function transforms the domain or any argument is explicit time.
+  bool explicitTime() const override;
+
+  /// Compiles the @c args() and adds a function call instruction.
+  ///
+  /// Domain transform functions are instead added as an expression, sampled via
+  /// @c sampleBlock().
+  /// @param program The program to add instructions to.
+  /// @return The function result value index.
+  unsigned compile(PlotExpressionProgram &program) const override;
+
   /// Get the argument expressions.
   const QVector<PlotExpression *> &args() const { return _args; }
 
@@ -68,10 +108,22 @@ private:
   /// Convert to string.
   virtual QString stringExpression() const;
 
+  /// Samples the first argument over its domain and invokes @c FunctionDefinition::transform()
+  /// if not yet done since binding. For domain transform functions only.
+  void transformArgs() const;
+
+  /// Evaluates the transformed @c function() at @p sampleTime.
+  /// @param sampleTime The time in the transformed domain.
+  /// @return The display value.
+  double sampleTransformed(double sampleTime) const;
+
   QVector<PlotExpression *> _args;      ///< Argument expressions.
   const FunctionDefinition *_function;  ///< Function definition.
   mutable PlotFunctionInfo _info;       ///< Binding info. Mutable :(
   void *_functionContext;               ///< Evaluation context object from @c FunctionDefinition::createContext().
+  mutable std::vector<double> _argBlock; ///< Argument values for @c sampleBlock(). One block per argument.
+  PlotExpressionBindDomain _argDomain;  ///< Domain of the first argument for domain transform functions.
+  mutable bool _transformed;            ///< True once @c transformArgs() has been performed.
 };
 
 #endif // __PLOTFUNCTION_H_
@@ -6,8 +6,9 @@
 #include "plotfunctionregister.h"
 
 #include "functionclean.h"
-#include "functionmavg.h"
+#include "functionspectrum.h"
 #include "functionunwrap.h"
+#include "functionwindow.h"
 #include "plotexpression.h"
 
 #include <cmath>
@@ -304,12 +305,22 @@ void PlotFunctionRegister::registerDefaultFunctions()
   category = "statistics";
   add(&abserrFunc, category, "abserr", "Absolute error between x and y.", 2);
   add(&avgFunc, category, "avg", "Running average value of x.", 1);
-  add(new FunctionMAvg(category));
+  add(new FunctionWindow(FunctionWindow::Mean, "mavg", "Moving average of x. The 'window' specifies the number of previous samples to retain, or a duration when 'bytime' is non-zero.", category));
   add(&maxofFunc, category, "maxof", "Maximum value of any number of graphs.", 1, true);
   add(&minofFunc, category, "minof", "Minimum value of any number of graphs.", 1, true);
+  add(new FunctionWindow(FunctionWindow::Maximum, "mmax", "Moving maximum of x over the 'window'.", category));
+  add(new FunctionWindow(FunctionWindow::Median, "mmedian", "Moving median of x over the 'window'.", category));
+  add(new FunctionWindow(FunctionWindow::Minimum, "mmin", "Moving minimum of x over the 'window'.", category));
+  add(new FunctionWindow(FunctionWindow::StandardDeviation, "mstddev", "Moving standard deviation of x over the 'window'.", category));
   add(&relerrFunc, category, "relerr", "Relative error between x and y.", 2);
+  add(new FunctionWindow(FunctionWindow::TimeWeightedMean, "tmavg", "Time weighted moving average of x. The 'window' specifies a duration, or the number of previous samples when 'bytime' is zero.", category, true));
   add(&totalFunc, category, "total", "Running sum of x.", 1);
 
+  // Spectral analysis
+  category = "spectral";
+  add(new FunctionSpectrum(FunctionSpectrum::Magnitude, "fft_mag", "Amplitude spectrum of the first n samples of x, or all samples when n is zero. The window is 0: rectangular, 1: Hann, 2: Hamming.", category));
+  add(new FunctionSpectrum(FunctionSpectrum::PowerDensity, "psd", "Power spectral density of x using Welch's method with segments of n samples. The window is 0: rectangular, 1: Hann, 2: Hamming.", category));
+
   // Trigonometry
   category = "trigonometry";
   add(static_cast<double(*)(double)>(&std::acos), category, "acos", "Trigonometric arccos function of x");
@@ -14,6 +14,14 @@ double PlotIndexExpression::sample(double sampleTime) const
 }
 
 
+void PlotIndexExpression::sampleBlock(const double *times, double *out, size_t count) const
+{
+  double *indices = blockBuffer(count);
+  right()->sampleBlock(times, indices, count);
+  left()->sampleBlock(indices, out, count);
+}
+
+
 PlotExpression *PlotIndexExpression::clone() const
 {
   return new PlotIndexExpression(left()->clone(), right()->clone());
@@ -35,6 +35,13 @@ public:
   /// <code>left()->sample(right()->sample(sampleTime))</code>
   virtual double sample(double sampleTime) const;
 
+  /// Samples the index expression for a block of times. The @c right() results
+  /// for the block are used as the sample times for @c left().
+  /// @param times The sample times for @c right().
+  /// @param[out] out The indexed samples.
+  /// @param count The number of elements in @p times and @p out.
+  void sampleBlock(const double *times, double *out, size_t count) const override;
+
   /// Clones this expression.
   /// @return A deep copy of this expression.
   virtual PlotExpression *clone() const;
@@ -7,6 +7,7 @@
 
 #include "plotbindinfo.h"
 #include "plotbindingtracker.h"
+#include "plotexpressionprogram.h"
 #include "plotinstance.h"
 #include "plotinstancesampler.h"
 
@@ -15,15 +16,8 @@
 
 #include <qwt_series_data.h>
 
-namespace
-{
-  double sample(double sampleTime, const QPointF &from, const QPointF &to)
-  {
-    double normalTime = (sampleTime - from.x()) / (to.x() - from.x());
-    return from.y() + normalTime * (to.y() - from.y());
-  }
-}
-
+#include <algorithm>
+#include <limits>
 
 QTextStream &operator << (QTextStream &stream, const PlotSampleId &sid)
 {
@@ -53,7 +47,7 @@ QTextStream &operator << (QTextStream &stream, const PlotSampleId &sid)
 PlotSample::PlotSample(const QString &curveName, bool curveRegularExpression)
   : _curveId(curveName, curveRegularExpression)
   , _sampler(new PlotInstanceSampler(nullptr))
-  , _previousSample(0)
+  , _policy(PlotResampler::Linear)
 {
 }
 
@@ -62,7 +56,7 @@ PlotSample::PlotSample(const QString &curveName, const QString &fileName, bool c
   : _curveId(curveName, curveRegularExpression)
   , _fileId(fileName, fileRegularExpression)
   , _sampler(new PlotInstanceSampler(nullptr))
-  , _previousSample(0)
+  , _policy(PlotResampler::Linear)
 {
 }
 
@@ -71,7 +65,7 @@ PlotSample::PlotSample(const PlotSampleId &curveId, const PlotSampleId &fileId)
   : _curveId(curveId)
   , _fileId(fileId)
   , _sampler(new PlotInstanceSampler(nullptr))
-  , _previousSample(0)
+  , _policy(PlotResampler::Linear)
 {
 }
 
@@ -80,7 +74,7 @@ PlotSample::PlotSample(const PlotSample &other)
   : _curveId(other._curveId)
   , _fileId(other._fileId)
   , _sampler(new PlotInstanceSampler(other._sampler->curve()))
-  , _previousSample(0)
+  , _policy(other._policy)
 {
 }
 
@@ -93,57 +87,47 @@ PlotSample::~PlotSample()
 
 double PlotSample::sample(double sampleTime) const
 {
-  QPointF from;
-  QPointF to;
-
-  if (!_sampler->curve())
+  double value = 0;
+  if (!_sampler->curve() || !_sampler->interpolate(sampleTime, value, _policy))
   {
-    return 0;
+    return (_policy == PlotResampler::NoExtrapolate) ? std::numeric_limits<double>::quiet_NaN() : 0.0;
   }
+  return value;
+}
 
-  if (_previousSample + 1 < _sampler->size())
-  {
-    from = _sampler->sample(_previousSample);
-    if (from.x() > sampleTime)
-    {
-      _previousSample = 0u;
-    }
-  }
-  else
+
+void PlotSample::sampleBlock(const double *times, double *out, size_t count) const
+{
+  if (!_sampler->curve())
   {
-    _previousSample = 0u;
+    std::fill(out, out + count, 0.0);
+    return;
   }
 
-  // FIXME: change to a binary search. For, put in a range check to ensure we aren't searching
-  // exhaustively for naught.
-  if (_sampler->size())
+  for (size_t i = 0; i < count; ++i)
   {
-    // Range check.
-    if (_sampler->sample(0).x() <= sampleTime && sampleTime <= _sampler->sample(_sampler->size() - 1).x())
-    {
-      // Try sampling from the current position.
-      while (_previousSample + 1 < _sampler->size())
-      {
-        from = _sampler->sample(_previousSample);
-        to = _sampler->sample(_previousSample + 1);
-
-        if (from.x() <= sampleTime && sampleTime <= to.x())
-        {
-          return ::sample(sampleTime, from, to);
-        }
-
-        ++_previousSample;
-      }
-    }
+    out[i] = PlotSample::sample(times[i]);
   }
+}
+
 
-  return 0.0;
+unsigned PlotSample::compile(PlotExpressionProgram &program) const
+{
+  // Samples depend only on the curve and sample time, so key on the bound curve.
+  return program.addExpression(this, _sampler->curve());
 }
 
 
 BindResult PlotSample::bind(const QList<PlotInstance *> &curves, PlotBindingTracker &bindTracker, PlotExpressionBindDomain &info, bool repeatLastBinding)
 {
-  _previousSample = 0u;
+  // Rebind to the existing curve when retaining bindings.
+  if (bindTracker.retainBindings() && _sampler->curve())
+  {
+    // The sampler only holds a const reference to the curve bound from the curves list.
+    bindCurve(const_cast<PlotInstance *>(_sampler->curve()), bindTracker, info);
+    return Bound;
+  }
+
   QRegExp fileRegEx(_fileId.name);
   QRegExp *fileREP = _fileId.regex ? &fileRegEx : nullptr;
   QRegExp nameRegEx(_curveId.name);
@@ -170,21 +154,7 @@ BindResult PlotSample::bind(const QList<PlotInstance *> &curves, PlotBindingTrac
     {
       if (nameMatch(curve->name(), _curveId.name, nameREP))
       {
-        _boundName = makeBoundName(*curve);
-
-        _sampler->setCurve(curve);
-        if (!curve->data().empty())
-        {
-          info.domainMin = _sampler->sample(0).x();
-          info.domainMax = _sampler->sample(_sampler->size() - 1).x();
-          info.minSet = info.maxSet = true;
-          double step = (info.domainMax - info.domainMin) / ((_sampler->size() > 1) ? _sampler->size() - 1 : 1);
-          info.sampleDelta = (info.sampleDelta == 0.0 || info.sampleDelta > step) ? step : info.sampleDelta;
-          info.sampleCount = (info.sampleCount >= _sampler->size()) ? info.sampleCount : _sampler->size();
-        }
-
-        // Record as first binding source if required.
-        bindTracker.setFirstPlotIf(curve);
+        bindCurve(curve, bindTracker, info);
 
         bindTracker.setMarker(this, index);
         if (index + 1 < unsigned(curves.count()))
@@ -202,6 +172,34 @@ BindResult PlotSample::bind(const QList<PlotInstance *> &curves, PlotBindingTrac
 }
 
 
+void PlotSample::bindCurve(PlotInstance *curve, PlotBindingTracker &bindTracker, PlotExpressionBindDomain &info)
+{
+  _boundName = makeBoundName(*curve);
+
+  _sampler->setCurve(curve);
+  _policy = bindTracker.resamplePolicy();
+  info.timeSources.assign(1, _sampler);
+  info.nativeTimes = bindTracker.nativeTimes();
+  if (curve->sampleCount())
+  {
+    // Time need not be monotonic, so use the time range.
+    if (!_sampler->timeRange(info.domainMin, info.domainMax))
+    {
+      info.domainMin = _sampler->sample(0).x();
+      info.domainMax = _sampler->sample(_sampler->size() - 1).x();
+    }
+    info.minSet = info.maxSet = true;
+    double step = (info.domainMax - info.domainMin) / ((_sampler->size() > 1) ? _sampler->size() - 1 : 1);
+    info.sampleDelta = (info.sampleDelta == 0.0 || info.sampleDelta > step) ? step : info.sampleDelta;
+    info.sampleCount = (info.sampleCount >= _sampler->size()) ? info.sampleCount : _sampler->size();
+  }
+
+  // Record as first binding source if required.
+  bindTracker.setFirstPlotIf(curve);
+  bindTracker.addBoundPlot(curve);
+}
+
+
 void PlotSample::unbind()
 {
   _boundName = QString();
@@ -10,6 +10,8 @@
 
 #include "plotexpression.h"
 
+#include "plotresampler.h"
+
 class PlotInstanceSampler;
 
 class QTextStream;
@@ -121,20 +123,39 @@ public:
 
   /// Called to generate a sample at @p sampleTime.
   ///
-  /// The implementation is optimised for sequential sampling and provides linearly
-  /// interpolated points between true sample points.
+  /// The implementation is optimised for sequential sampling and provides points between
+  /// true sample points according to the @c PlotBindingTracker::resamplePolicy() at binding.
+  /// Random access is supported in logarithmic time. See @c PlotInstanceSampler::interpolate().
+  ///
+  /// Samples outside the curve time range are zero, or NaN for the
+  /// @c PlotResampler::NoExtrapolate policy.
   ///
   /// @param sampleTime The time to sample the expression at.
   /// @return The calculated sample at @p sampleTime.
   virtual double sample(double sampleTime) const;
 
+  /// Samples a block of times as for @c sample(), without the virtual call overhead.
+  /// @param times The times to sample at.
+  /// @param[out] out The interpolated samples.
+  /// @param count The number of elements in @p times and @p out.
+  void sampleBlock(const double *times, double *out, size_t count) const override;
+
+  /// Adds an instruction sampling the bound curve. Samples of the same curve are shared.
+  /// @param program The program to add instructions to.
+  /// @return The sample value index.
+  unsigned compile(PlotExpressionProgram &program) const override;
+
   /// Attempts to bind to a curve mathcing @c curveName().
   ///
   /// The binding supports regular expressions in both source and curve names, or exact matches,
   /// with the source name optional. In either case, only @c PlotSource::File type sources are
   /// accepted with sources of all other types ignored.
   ///
-  /// Repeated bindings are managed via the @p bindTracker.
+  /// Repeated bindings are managed via the @p bindTracker. A bound copy made by @c clone()
+  /// rebinds to the same curve when @c PlotBindingTracker::retainBindings() is set.
+  ///
+  /// The bound curve is reported as the only @c PlotExpressionBindDomain::timeSources item,
+  /// and @c PlotExpressionBindDomain::nativeTimes is set from the @p bindTracker.
   ///
   /// @return True on successful binding. Do not call @c sample() unless binding
   /// succeeds.
@@ -164,6 +185,12 @@ private:
 
   // Binding support.
 
+  /// Binds @p curve, expanding @p info to cover its domain.
+  /// @param curve The curve to bind.
+  /// @param bindTracker The binding tracker. Notified of the bound plot.
+  /// @param info The binding domain to update.
+  void bindCurve(PlotInstance *curve, PlotBindingTracker &bindTracker, PlotExpressionBindDomain &info);
+
   /// Checks if @p name matches the @p searchName or @p re object.
   /// @param name The name to check.
   /// @param searchName The name to check against (exact match). Ignored if @p re is non-null.
@@ -176,7 +203,7 @@ private:
   PlotSampleId _fileId;     ///< File source name matching ID.
   QString _boundName; ///< Bound curve name (for RegEx match).
   PlotInstanceSampler *_sampler;  ///< Bound data set.
-  mutable unsigned int _previousSample; ///< Last sample index.
+  PlotResampler::Policy _policy;  ///< Policy for sampling between curve samples.
 };
 
 #endif // __PLOTSAMPLE_H_
@@ -42,6 +42,29 @@ double PlotSlice::sample(double sampleTime) const
 }
 
 
+void PlotSlice::sampleBlock(const double *times, double *out, size_t count) const
+{
+  // Sample runs of times within the domain. Times outside the domain must not be passed
+  // to the indexee as they may affect a stateful expression.
+  size_t i = 0;
+  while (i < count)
+  {
+    if (!_sliceDomain.contains(times[i], true, false))
+    {
+      out[i++] = 0.0;
+      continue;
+    }
+
+    const size_t runStart = i;
+    while (i < count && _sliceDomain.contains(times[i], true, false))
+    {
+      ++i;
+    }
+    _indexee->sampleBlock(times + runStart, out + runStart, i - runStart);
+  }
+}
+
+
 BindResult PlotSlice::bind(const QList<PlotInstance *> &curves, PlotBindingTracker &bindTracker, PlotExpressionBindDomain &info, bool repeatLastBinding)
 {
 //  PlotExpressionBindDomain startInfo, endInfo;
@@ -84,6 +84,13 @@ public:
   /// @return The sample at @p sampleTime.
   double sample(double sampleTime) const override;
 
+  /// Samples the @c indexee() for a block of times. The @c indexee() is only sampled
+  /// for times within the slice, as for @c sample().
+  /// @param times The times to sample at.
+  /// @param[out] out The samples. Zero for times outside the slice.
+  /// @param count The number of elements in @p times and @p out.
+  void sampleBlock(const double *times, double *out, size_t count) const override;
+
   /// Attempts to binds the slice expression.
   ///
   /// This binds the supporting expressions and determines the slice range.
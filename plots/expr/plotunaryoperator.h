@@ -9,6 +9,7 @@
 #include "plotsconfig.h"
 
 #include "plotexpression.h"
+#include "plotexpressionprogram.h"
 
 #include <QTextStream>
 
@@ -87,6 +88,40 @@ public:
     return Operator()(operand()->sample(sampleTime));
   }
 
+  /// Sample the operand for a block of times and evaluate the @c Operator on each result.
+  /// @param times The times to sample at.
+  /// @param[out] out The results.
+  /// @param count The number of elements in @p times and @p out.
+  void sampleBlock(const double *times, double *out, size_t count) const override
+  {
+    operand()->sampleBlock(times, out, count);
+    evaluateBlock(out, out, count);
+  }
+
+  /// Evaluate @c Operator for a block of operand values.
+  ///
+  /// This is the @c PlotExpressionProgram::UnaryKernel for this operator.
+  ///
+  /// @param values The operand values.
+  /// @param[out] out The results. May alias @p values.
+  /// @param count The number of elements in each array.
+  static void evaluateBlock(const double *values, double *out, size_t count)
+  {
+    const Operator op = Operator();
+    for (size_t i = 0; i < count; ++i)
+    {
+      out[i] = op(values[i]);
+    }
+  }
+
+  /// Compiles the operand and adds a unary instruction using @c evaluateBlock().
+  /// @param program The program to add instructions to.
+  /// @return The result value index.
+  unsigned compile(PlotExpressionProgram &program) const override
+  {
+    return program.addUnary(&evaluateBlock, operand()->compile(program));
+  }
+
   /// Return the string used to prefix the operand.
   /// @return The operation string (e.g., "-" for negation).
   inline const QString &opStr() const { return _opStr; }
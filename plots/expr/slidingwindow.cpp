@@ -0,0 +1,269 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "slidingwindow.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+/// Initial @c SlidingWindow ring buffer size. Must be a power of two.
+#define INITIAL_WINDOW_CAPACITY 16u
+/// Minimum number of samples removed before a @c SlidingWindow recalculates its running sums.
+#define MIN_RESYNC_INTERVAL 1024u
+
+SlidingWindow::SlidingWindow(unsigned features)
+  : _features(features)
+{
+  clear();
+}
+
+
+void SlidingWindow::clear()
+{
+  _head = _count = 0;
+  _sequence = 0;
+  _removedSinceResync = 0;
+  _mean = _m2 = _area = 0;
+  _minima.clear();
+  _maxima.clear();
+  _lower.clear();
+  _upper.clear();
+}
+
+
+void SlidingWindow::push(double time, double value, double window, bool byTime)
+{
+  if (_count == _ring.size())
+  {
+    // Grow the ring, unwrapping the samples.
+    std::vector<Sample> ring(std::max<size_t>(INITIAL_WINDOW_CAPACITY, 2 * _ring.size()));
+    for (size_t i = 0; i < _count; ++i)
+    {
+      ring[i] = at(i);
+    }
+    _ring.swap(ring);
+    _head = 0;
+  }
+
+  if ((_features & TimeWeighted) && _count)
+  {
+    const Sample &last = at(_count - 1);
+    _area += 0.5 * (last.value + value) * (time - last.time);
+  }
+
+  Sample &sample = _ring[(_head + _count) & (_ring.size() - 1)];
+  sample.time = time;
+  sample.value = value;
+  ++_count;
+
+  const double delta = value - _mean;
+  _mean += delta / _count;
+  _m2 += delta * (value - _mean);
+
+  if (_features & Extrema)
+  {
+    while (!_minima.empty() && _minima.back().value >= value)
+    {
+      _minima.pop_back();
+    }
+    _minima.push_back(Extreme{ _sequence, value });
+
+    while (!_maxima.empty() && _maxima.back().value <= value)
+    {
+      _maxima.pop_back();
+    }
+    _maxima.push_back(Extreme{ _sequence, value });
+  }
+
+  if (_features & Median)
+  {
+    if (_lower.empty() || value <= *_lower.rbegin())
+    {
+      _lower.insert(value);
+    }
+    else
+    {
+      _upper.insert(value);
+    }
+    balanceMedian();
+  }
+
+  ++_sequence;
+
+  // Trim the window. Invalid window sizes retain only the new sample.
+  window = (window >= 0) ? window : 0;
+  if (byTime)
+  {
+    const double earliest = time - window;
+    while (_count > 1 && at(0).time < earliest)
+    {
+      popFront();
+    }
+  }
+  else
+  {
+    const size_t maxRetain = std::numeric_limits<unsigned>::max();
+    const size_t retain = (window < maxRetain) ? size_t(window) + 1 : maxRetain;
+    while (_count > retain)
+    {
+      popFront();
+    }
+  }
+
+  if (_removedSinceResync >= std::max<size_t>(MIN_RESYNC_INTERVAL, _count))
+  {
+    resync();
+  }
+}
+
+
+double SlidingWindow::timeWeightedMean() const
+{
+  if (_count > 1)
+  {
+    const double span = at(_count - 1).time - at(0).time;
+    if (span > 0)
+    {
+      return _area / span;
+    }
+  }
+  return _mean;
+}
+
+
+double SlidingWindow::minimum() const
+{
+  return (!_minima.empty()) ? _minima.front().value : 0.0;
+}
+
+
+double SlidingWindow::maximum() const
+{
+  return (!_maxima.empty()) ? _maxima.front().value : 0.0;
+}
+
+
+double SlidingWindow::standardDeviation() const
+{
+  return (_count) ? std::sqrt(_m2 / _count) : 0.0;
+}
+
+
+double SlidingWindow::median() const
+{
+  if (_lower.empty())
+  {
+    return 0.0;
+  }
+
+  if (_lower.size() == _upper.size())
+  {
+    return 0.5 * (*_lower.rbegin() + *_upper.begin());
+  }
+
+  return *_lower.rbegin();
+}
+
+
+void SlidingWindow::popFront()
+{
+  const Sample front = at(0);
+  const uint64_t frontSequence = _sequence - _count;
+
+  if ((_features & TimeWeighted) && _count > 1)
+  {
+    const Sample &next = at(1);
+    _area -= 0.5 * (front.value + next.value) * (next.time - front.time);
+  }
+
+  if (_features & Extrema)
+  {
+    if (!_minima.empty() && _minima.front().sequence == frontSequence)
+    {
+      _minima.pop_front();
+    }
+    if (!_maxima.empty() && _maxima.front().sequence == frontSequence)
+    {
+      _maxima.pop_front();
+    }
+  }
+
+  if (_features & Median)
+  {
+    // All lower values are no greater than any upper value, so a value no greater than the
+    // lower maximum is always present in the lower set.
+    if (!_lower.empty() && front.value <= *_lower.rbegin())
+    {
+      _lower.erase(_lower.find(front.value));
+    }
+    else
+    {
+      _upper.erase(_upper.find(front.value));
+    }
+    balanceMedian();
+  }
+
+  _head = (_head + 1) & (_ring.size() - 1);
+  --_count;
+  ++_removedSinceResync;
+
+  if (_count)
+  {
+    const double delta = front.value - _mean;
+    _mean -= delta / _count;
+    _m2 = std::max(0.0, _m2 - delta * (front.value - _mean));
+  }
+  else
+  {
+    _mean = _m2 = _area = 0;
+  }
+}
+
+
+void SlidingWindow::resync()
+{
+  _removedSinceResync = 0;
+  _mean = _m2 = _area = 0;
+
+  for (size_t i = 0; i < _count; ++i)
+  {
+    _mean += at(i).value;
+  }
+  _mean = (_count) ? _mean / _count : 0.0;
+
+  for (size_t i = 0; i < _count; ++i)
+  {
+    const double delta = at(i).value - _mean;
+    _m2 += delta * delta;
+  }
+
+  if (_features & TimeWeighted)
+  {
+    for (size_t i = 1; i < _count; ++i)
+    {
+      _area += 0.5 * (at(i - 1).value + at(i).value) * (at(i).time - at(i - 1).time);
+    }
+  }
+}
+
+
+void SlidingWindow::balanceMedian()
+{
+  // Keep the lower set the same size as the upper set, or one larger.
+  if (_lower.size() > _upper.size() + 1)
+  {
+    auto largest = std::prev(_lower.end());
+    _upper.insert(*largest);
+    _lower.erase(largest);
+  }
+  else if (_upper.size() > _lower.size())
+  {
+    auto smallest = _upper.begin();
+    _lower.insert(*smallest);
+    _upper.erase(smallest);
+  }
+}
@@ -0,0 +1,139 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef SLIDINGWINDOW_H_
+#define SLIDINGWINDOW_H_
+
+#include "plotsconfig.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <vector>
+
+/// @ingroup expr
+/// A window over the most recent samples of a series supporting constant time statistics.
+///
+/// Samples are pushed in time order and held in a ring buffer. The window is then trimmed
+/// either to a number of previous samples or to a time span before the newest sample.
+/// Statistics are maintained incrementally as samples enter and leave the window so the
+/// cost of each @c push() does not depend on the window size:
+/// - The mean and variance are updated using Welford's algorithm.
+/// - The minimum and maximum are tracked using monotonic deques (@c Extrema).
+/// - The time weighted mean integrates the samples using the trapezoid rule (@c TimeWeighted).
+/// - The median is tracked by a pair of balanced ordered sets, costing O(log N) (@c Median).
+///
+/// Optional statistics are only maintained when requested on construction. The running
+/// sums are periodically recalculated to bound floating point drift, which remains
+/// amortised constant time.
+class SlidingWindow
+{
+public:
+  /// Optional statistics to maintain. The mean and variance are always maintained.
+  enum Feature
+  {
+    Extrema = (1 << 0),       ///< Maintain the minimum and maximum.
+    Median = (1 << 1),        ///< Maintain the median.
+    TimeWeighted = (1 << 2)   ///< Maintain the time weighted mean.
+  };
+
+  /// Constructor.
+  /// @param features The optional statistics to maintain. See @c Feature.
+  SlidingWindow(unsigned features = 0);
+
+  /// Clears the window.
+  void clear();
+
+  /// Adds a sample and trims the window.
+  ///
+  /// When windowing by count, the window retains @p window previous samples in addition to
+  /// the new sample. When windowing by time, the window retains samples no older than
+  /// @p window before @p time. The window always contains at least the new sample.
+  ///
+  /// @param time The sample time. Expected to be non-decreasing.
+  /// @param value The sample value.
+  /// @param window The window size, as a sample count or duration according to @p byTime.
+  /// @param byTime True to window by time, false to window by sample count.
+  void push(double time, double value, double window, bool byTime);
+
+  /// Queries the number of samples in the window.
+  /// @return The sample count.
+  inline size_t count() const { return _count; }
+
+  /// Queries the mean value of the window.
+  /// @return The mean value, or zero when empty.
+  inline double mean() const { return _mean; }
+
+  /// Queries the time weighted mean of the window. Requires @c TimeWeighted.
+  ///
+  /// The samples are linearly interpolated over the time spanned by the window. Reverts to
+  /// @c mean() when the window spans no time.
+  /// @return The time weighted mean.
+  double timeWeightedMean() const;
+
+  /// Queries the minimum value in the window. Requires @c Extrema.
+  /// @return The minimum value, or zero when empty.
+  double minimum() const;
+
+  /// Queries the maximum value in the window. Requires @c Extrema.
+  /// @return The maximum value, or zero when empty.
+  double maximum() const;
+
+  /// Queries the population standard deviation of the window.
+  /// @return The standard deviation.
+  double standardDeviation() const;
+
+  /// Queries the median of the window. Requires @c Median.
+  ///
+  /// Averages the two central values for an even sample count.
+  /// @return The median value, or zero when empty.
+  double median() const;
+
+private:
+  /// A sample in the window.
+  struct Sample
+  {
+    double time;      ///< Sample time.
+    double value;     ///< Sample value.
+  };
+
+  /// An entry in a monotonic deque.
+  struct Extreme
+  {
+    uint64_t sequence;  ///< Sequence number of the sample. Identifies when it leaves the window.
+    double value;       ///< Sample value.
+  };
+
+  /// Accesses the sample at @p index, where zero is the oldest sample.
+  /// @param index The sample index. Must be less than @c count().
+  /// @return The sample.
+  inline const Sample &at(size_t index) const { return _ring[(_head + index) & (_ring.size() - 1)]; }
+
+  /// Removes the oldest sample, updating the statistics.
+  void popFront();
+
+  /// Recalculates the running sums from the window contents.
+  void resync();
+
+  /// Moves the smallest or largest median set entry across to balance the sets.
+  void balanceMedian();
+
+  std::vector<Sample> _ring;            ///< Sample ring buffer. Size is a power of two.
+  size_t _head;                         ///< Index of the oldest sample in @c _ring.
+  size_t _count;                        ///< Number of samples in the window.
+  uint64_t _sequence;                   ///< Sequence number of the next sample.
+  size_t _removedSinceResync;           ///< Samples removed since the last @c resync().
+  unsigned _features;                   ///< @c Feature flags.
+  double _mean;                         ///< Running mean.
+  double _m2;                           ///< Running sum of squared differences from the mean.
+  double _area;                         ///< Integral of the window for @c TimeWeighted.
+  std::deque<Extreme> _minima;          ///< Increasing values. Front is the minimum.
+  std::deque<Extreme> _maxima;          ///< Decreasing values. Front is the maximum.
+  std::multiset<double> _lower;         ///< Lower half of the values for @c Median.
+  std::multiset<double> _upper;         ///< Upper half of the values for @c Median.
+};
+
+#endif // SLIDINGWINDOW_H_
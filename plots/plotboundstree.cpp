@@ -0,0 +1,216 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "plotboundstree.h"
+
+#include "plotsamplecolumn.h"
+
+#include <algorithm>
+#include <limits>
+
+PlotBoundsTree::PlotBoundsTree()
+  : _sampleCount(0)
+{
+}
+
+
+void PlotBoundsTree::clear()
+{
+  _levels.clear();
+  _sampleCount = 0;
+}
+
+
+void PlotBoundsTree::update(const double *data, size_t size, size_t from, size_t count)
+{
+  size_t firstLeaf, lastLeaf;
+  if (!beginUpdate(size, from, count, firstLeaf, lastLeaf))
+  {
+    return;
+  }
+
+  for (size_t leaf = firstLeaf; leaf <= lastLeaf; ++leaf)
+  {
+    const size_t start = leaf << NodeShift;
+    updateLeaf(leaf, data + start, std::min<size_t>(NodeSize, size - start));
+  }
+  propagate(firstLeaf, lastLeaf);
+}
+
+
+void PlotBoundsTree::update(const PlotSampleColumn &data, size_t from, size_t count)
+{
+  const size_t size = data.size();
+  size_t firstLeaf, lastLeaf;
+  if (!beginUpdate(size, from, count, firstLeaf, lastLeaf))
+  {
+    return;
+  }
+
+  double values[NodeSize];
+  for (size_t leaf = firstLeaf; leaf <= lastLeaf; ++leaf)
+  {
+    const size_t start = leaf << NodeShift;
+    const size_t leafCount = std::min<size_t>(NodeSize, size - start);
+    data.decode(start, leafCount, values);
+    updateLeaf(leaf, values, leafCount);
+  }
+  propagate(firstLeaf, lastLeaf);
+}
+
+
+bool PlotBoundsTree::range(bool filterNaN, bool filterInf, double &min, double &max) const
+{
+  if (_levels.empty())
+  {
+    return false;
+  }
+
+  const Node &root = _levels.back().front();
+  bool haveValue = (root.flags & HasFinite) != 0;
+  min = root.min;
+  max = root.max;
+
+  auto include = [&min, &max, &haveValue] (double value)
+  {
+    min = (!haveValue || value < min) ? value : min;
+    max = (!haveValue || value > max) ? value : max;
+    haveValue = true;
+  };
+
+  typedef std::numeric_limits<double> Limits;
+  if (root.flags & HasNegativeInf)
+  {
+    include((filterInf) ? 0.0 : -Limits::infinity());
+  }
+  if (root.flags & HasPositiveInf)
+  {
+    include((filterInf) ? 0.0 : Limits::infinity());
+  }
+  if ((root.flags & HasNaN) && filterNaN)
+  {
+    include(0.0);
+  }
+
+  return haveValue;
+}
+
+
+void PlotBoundsTree::resize(size_t size)
+{
+  _sampleCount = size;
+  if (!size)
+  {
+    _levels.clear();
+    return;
+  }
+
+  size_t nodeCount = (size + NodeSize - 1) >> NodeShift;
+  size_t level = 0;
+  for (;;)
+  {
+    if (_levels.size() <= level)
+    {
+      _levels.push_back(std::vector<Node>());
+    }
+    _levels[level++].resize(nodeCount);
+    if (nodeCount <= 1)
+    {
+      break;
+    }
+    nodeCount = (nodeCount + NodeSize - 1) >> NodeShift;
+  }
+  _levels.resize(level);
+}
+
+
+void PlotBoundsTree::updateLeaf(size_t leaf, const double *values, size_t count)
+{
+  typedef std::numeric_limits<double> Limits;
+  Node &node = _levels[0][leaf];
+  node.min = node.max = 0;
+  node.flags = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const double value = values[i];
+    if (value != value)
+    {
+      node.flags |= HasNaN;
+    }
+    else if (value == Limits::infinity())
+    {
+      node.flags |= HasPositiveInf;
+    }
+    else if (value == -Limits::infinity())
+    {
+      node.flags |= HasNegativeInf;
+    }
+    else if (node.flags & HasFinite)
+    {
+      node.min = std::min(node.min, value);
+      node.max = std::max(node.max, value);
+    }
+    else
+    {
+      node.min = node.max = value;
+      node.flags |= HasFinite;
+    }
+  }
+}
+
+
+void PlotBoundsTree::propagate(size_t firstLeaf, size_t lastLeaf)
+{
+  size_t first = firstLeaf, last = lastLeaf;
+  for (size_t level = 1; level < _levels.size(); ++level)
+  {
+    first >>= NodeShift;
+    last >>= NodeShift;
+    const std::vector<Node> &children = _levels[level - 1];
+    for (size_t n = first; n <= last; ++n)
+    {
+      Node &node = _levels[level][n];
+      node.min = node.max = 0;
+      node.flags = 0;
+      const size_t end = std::min<size_t>((n + 1) << NodeShift, children.size());
+      for (size_t c = n << NodeShift; c < end; ++c)
+      {
+        const Node &child = children[c];
+        if (child.flags & HasFinite)
+        {
+          node.min = (node.flags & HasFinite) ? std::min(node.min, child.min) : child.min;
+          node.max = (node.flags & HasFinite) ? std::max(node.max, child.max) : child.max;
+        }
+        node.flags |= child.flags;
+      }
+    }
+  }
+}
+
+
+bool PlotBoundsTree::beginUpdate(size_t size, size_t from, size_t count, size_t &firstLeaf, size_t &lastLeaf)
+{
+  const size_t oldSize = _sampleCount;
+  resize(size);
+
+  size_t dirtyFrom = std::min(from, size);
+  size_t dirtyEnd = std::min(from + count, size);
+  if (size != oldSize)
+  {
+    // Rebuild from the old end (growth) or the leaf containing the new end (shrinking).
+    const size_t boundary = std::min(oldSize, size);
+    dirtyFrom = std::min(dirtyFrom, (boundary) ? boundary - 1 : 0);
+    dirtyEnd = size;
+  }
+
+  if (dirtyFrom >= dirtyEnd)
+  {
+    return false;
+  }
+
+  firstLeaf = dirtyFrom >> NodeShift;
+  lastLeaf = (dirtyEnd - 1) >> NodeShift;
+  return true;
+}
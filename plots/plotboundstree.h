@@ -0,0 +1,127 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef PLOTBOUNDSTREE_H_
+#define PLOTBOUNDSTREE_H_
+
+#include "plotsconfig.h"
+
+#include <cstddef>
+#include <vector>
+
+class PlotSampleColumn;
+
+/// @ingroup plot
+/// Maintains the range of values in a sample array as the array is modified.
+///
+/// The tree is a wide segment tree: each leaf summarises @c NodeSize consecutive
+/// samples, while each higher node summarises @c NodeSize nodes from the level below.
+/// The root summarises the whole array, so the range is available in constant time.
+/// Modifying samples requires updating only the affected leaves and their ancestors,
+/// which suits both appending data and overwriting ring buffer entries: evicted samples
+/// simply fall out of the rebuilt leaves.
+///
+/// Each node tracks the range of finite values, and whether the samples include NaN or
+/// infinite values. This allows @c range() to apply NaN and infinite value filtering
+/// without rescanning the samples.
+///
+/// As with @c PlotLevelOfDetail, the tree does not store the samples; the modified
+/// samples must be passed to @c update().
+class PlotBoundsTree
+{
+public:
+  /// Tree dimensions.
+  enum
+  {
+    NodeShift = 8,                ///< Log2 of @c NodeSize.
+    NodeSize = 1 << NodeShift     ///< Samples per leaf and children per node.
+  };
+
+  /// Constructor.
+  PlotBoundsTree();
+
+  /// Clears the tree.
+  void clear();
+
+  /// Query the number of samples covered by the tree.
+  /// @return The sample count.
+  inline size_t sampleCount() const { return _sampleCount; }
+
+  /// Update the tree for a sample array of @p size elements, of which the elements
+  /// [@p from, @p from + @p count) have been added or modified.
+  ///
+  /// The tree is resized to match @p size. Samples beyond @p size are discarded.
+  ///
+  /// @param data The sample array.
+  /// @param size The number of elements in @p data.
+  /// @param from The first modified element.
+  /// @param count The number of modified elements.
+  void update(const double *data, size_t size, size_t from, size_t count);
+
+  /// @overload
+  /// The tree is resized to match the size of @p data.
+  void update(const PlotSampleColumn &data, size_t from, size_t count);
+
+  /// Query the range of the samples.
+  ///
+  /// NaN values are excluded unless @p filterNaN is set, in which case they are treated
+  /// as zero. Infinite values are included unless @p filterInf is set, in which case they
+  /// are also treated as zero. This matches the filtering in @c PlotInstanceSampler.
+  ///
+  /// @param filterNaN Treat NaN values as zero?
+  /// @param filterInf Treat infinite values as zero?
+  /// @param[out] min Set to the minimum value.
+  /// @param[out] max Set to the maximum value.
+  /// @return True if there are any values in the range.
+  bool range(bool filterNaN, bool filterInf, double &min, double &max) const;
+
+private:
+  /// Node content flags.
+  enum Flag
+  {
+    HasFinite = (1 << 0),       ///< Contains finite values. The node min/max are valid.
+    HasNaN = (1 << 1),          ///< Contains NaN values.
+    HasPositiveInf = (1 << 2),  ///< Contains positive infinity.
+    HasNegativeInf = (1 << 3)   ///< Contains negative infinity.
+  };
+
+  /// A tree node.
+  struct Node
+  {
+    double min;       ///< Minimum finite value.
+    double max;       ///< Maximum finite value.
+    unsigned flags;   ///< @c Flag values.
+  };
+
+  /// Resize the tree for @p size samples.
+  /// @param size The new sample count.
+  void resize(size_t size);
+
+  /// Rebuild a leaf from its samples.
+  /// @param leaf The leaf index.
+  /// @param values The samples of the leaf.
+  /// @param count The number of @p values.
+  void updateLeaf(size_t leaf, const double *values, size_t count);
+
+  /// Rebuild the ancestors of the leaves [@p firstLeaf, @p lastLeaf].
+  /// @param firstLeaf The first modified leaf.
+  /// @param lastLeaf The last modified leaf.
+  void propagate(size_t firstLeaf, size_t lastLeaf);
+
+  /// Calculate the leaf range to rebuild for an @c update() of [@p from, @p from + @p count),
+  /// also resizing the tree.
+  /// @param size The new sample count.
+  /// @param from The first modified element.
+  /// @param count The number of modified elements.
+  /// @param[out] firstLeaf The first leaf to rebuild.
+  /// @param[out] lastLeaf The last leaf to rebuild.
+  /// @return False if there is nothing to rebuild.
+  bool beginUpdate(size_t size, size_t from, size_t count, size_t &firstLeaf, size_t &lastLeaf);
+
+  std::vector<std::vector<Node>> _levels; ///< Tree levels. Level zero holds the leaves.
+  size_t _sampleCount;                    ///< Number of samples covered.
+};
+
+#endif // PLOTBOUNDSTREE_H_
@@ -6,18 +6,26 @@
 #include "plotinstance.h"
 
 #include <algorithm>
+#include <cstring>
 #include <limits>
 
 PlotInstance::PlotInstance(const PlotSource::Ptr &source)
-  : _source(source)
+  : _d(new PlotInstanceData)
+  , _source(source)
   , _expression(nullptr)
   , _ringHead(0u)
+  , _generation(0u)
+  , _appendedCount(0u)
   , _flags(0)
   , _style(0)
   , _width(0)
   , _symbol(-1)
   , _symbolSize(DefaultSymbolSize)
 {
+  if (source)
+  {
+    setSampleEncoding(source->sampleEncoding());
+  }
 }
 
 
@@ -42,45 +50,153 @@ void PlotInstance::setDefaultProperties()
 }
 
 
+namespace
+{
+  /// Write @p count elements from @p src into the ring buffer @p data at @p insertAt,
+  /// wrapping at @p capacity.
+  void ringCopy(std::vector<double> &data, size_t capacity, size_t insertAt, const double *src, size_t count)
+  {
+    const size_t copyCount1 = std::min<size_t>(count, capacity - insertAt);
+    memcpy(data.data() + insertAt, src, sizeof(*src) * copyCount1);
+    const size_t copyCount2 = count - copyCount1;
+    if (copyCount2)
+    {
+      // Second insert: overflow.
+      memcpy(data.data(), src + copyCount1, sizeof(*src) * copyCount2);
+    }
+  }
+
+
+  /// @overload
+  void ringCopy(PlotSampleColumn &data, size_t capacity, size_t insertAt, const double *src, size_t count)
+  {
+    const size_t copyCount1 = std::min<size_t>(count, capacity - insertAt);
+    data.write(insertAt, src, copyCount1);
+    const size_t copyCount2 = count - copyCount1;
+    if (copyCount2)
+    {
+      data.write(0, src + copyCount1, copyCount2);
+    }
+  }
+}
+
+
+std::vector<double> &PlotInstanceData::mutableTimes()
+{
+  if (!times.unique())
+  {
+    std::shared_ptr<std::vector<double>> copy = std::make_shared<std::vector<double>>();
+    copy->reserve(times->capacity());
+    *copy = *times;
+    times = copy;
+  }
+  return *times;
+}
+
+
+void PlotInstanceData::updateBounds(size_t from, size_t count)
+{
+  timeBounds.update(times->data(), times->size(), from, count);
+  valueBounds.update(values, from, count);
+}
+
+
+void PlotInstance::setSampleEncoding(const PlotSampleEncoding &encoding)
+{
+  PlotSampleEncoding ringEncoding = encoding;
+  if (isRingBuffer() && ringEncoding.type == PlotSampleEncoding::XorDelta)
+  {
+    ringEncoding.type = PlotSampleEncoding::Float32;
+  }
+
+  PlotInstanceData &d = *_d;
+  d.values.setEncoding(ringEncoding);
+  // Lossy encodings may have changed the values.
+  d.valueBounds.clear();
+  d.valueBounds.update(d.values, 0, d.values.size());
+  d.lod.clear();
+  ++_generation;
+  if (!isRingBuffer())
+  {
+    d.lod.update(d.times->data(), d.values, d.values.size());
+  }
+}
+
+
 void PlotInstance::makeRingBuffer(size_t bufferSize)
 {
-  if (_data.size() <= bufferSize)
+  PlotInstanceData &d = *_d;
+  if (d.values.encoding().type == PlotSampleEncoding::XorDelta)
   {
-    _data.reserve(bufferSize);
+    // Ring buffers overwrite values. Fall back to the nearest writable encoding.
+    d.values.setEncoding(PlotSampleEncoding(PlotSampleEncoding::Float32));
+  }
+  std::vector<double> &times = d.mutableTimes();
+  if (d.values.size() <= bufferSize)
+  {
+    times.reserve(bufferSize);
+    d.values.reserve(bufferSize);
   }
   else
   {
-    _data.resize(bufferSize);
+    times.resize(bufferSize);
+    d.values.resize(bufferSize);
   }
   setFlagsState(RingBuffer, true);
-  _ringHead = std::min(_ringHead, _data.size());
+  _ringHead = std::min(_ringHead, d.values.size());
+  d.updateBounds(d.values.size(), 0);
+  d.lod.clear();
+  ++_generation;
 }
 
 
 QPointF PlotInstance::sample(size_t index) const
 {
-  QPointF sampl;
-  if (!_data.empty())
+  const PlotInstanceData &d = *_d;
+  const size_t count = d.values.size();
+  if (count)
   {
     if (!isRingBuffer())
     {
-      sampl = _data[std::min(index, _data.size() - 1)];
+      index = std::min(index, count - 1);
     }
     else
     {
-      const size_t rotatedIndex = (index + _ringHead) % _data.size();
-      sampl = _data[rotatedIndex];
+      index = (index + _ringHead) % count;
     }
+    return QPointF((*d.times)[index], d.values.value(index));
   }
 
-  return sampl;
+  return QPointF();
+}
+
+
+QPointF PlotInstance::sample(size_t index, PlotSampleColumn::Cursor &cursor) const
+{
+  const PlotInstanceData &d = *_d;
+  const size_t count = d.values.size();
+  if (count)
+  {
+    if (!isRingBuffer())
+    {
+      index = std::min(index, count - 1);
+    }
+    else
+    {
+      index = (index + _ringHead) % count;
+    }
+    return QPointF((*d.times)[index], cursor.value(d.values, index));
+  }
+
+  return QPointF();
 }
 
 
 void PlotInstance::addPoint(const QPointF &p)
 {
   QMutexLocker guard(&_mutex);
-  _buffer.push_back(p);
+  _bufferTimes.push_back(p.x());
+  _bufferValues.push_back(p.y());
 }
 
 
@@ -89,83 +205,136 @@ void PlotInstance::addPoints(const QPointF *points, size_t pointCount)
   if (pointCount)
   {
     QMutexLocker guard(&_mutex);
-    size_t initial = _buffer.size();
-    const size_t newSize = initial + pointCount;
-    if (_buffer.capacity() < newSize)
+    const size_t newSize = _bufferValues.size() + pointCount;
+    if (_bufferValues.capacity() < newSize)
     {
-      _buffer.reserve(std::max<size_t>(1024u, _buffer.capacity() * 2u));
+      const size_t capacity = std::max<size_t>(newSize, std::max<size_t>(1024u, _bufferValues.capacity() * 2u));
+      _bufferTimes.reserve(capacity);
+      _bufferValues.reserve(capacity);
     }
 
-    _buffer.resize(newSize);
-    for (size_t i = initial; i < newSize; ++i)
+    for (size_t i = 0; i < pointCount; ++i)
     {
-      _buffer[i] = points[i];
+      _bufferTimes.push_back(points[i].x());
+      _bufferValues.push_back(points[i].y());
     }
   }
 }
 
 
+void PlotInstance::replaceData(PlotInstanceData *data)
+{
+  QMutexLocker guard(&_mutex);
+  _replacement = QSharedDataPointer<PlotInstanceData>(data);
+}
+
+
+void PlotInstance::shareData(const PlotInstance &other)
+{
+  QMutexLocker guard(&_mutex);
+  _replacement = other._d;
+}
+
+
 bool PlotInstance::migrateBuffer()
 {
   QMutexLocker guard(&_mutex);
-  if (!_buffer.empty())
+  if (_replacement.constData() && !isRingBuffer())
+  {
+    // Swap in the prepared data. The old data are released unless shared.
+    _d = _replacement;
+    _replacement = QSharedDataPointer<PlotInstanceData>();
+    ++_generation;
+    _appendedCount += _d->values.size();
+    // Release any remaining buffer memory.
+    std::vector<double>().swap(_bufferTimes);
+    std::vector<double>().swap(_bufferValues);
+    return true;
+  }
+  _replacement = QSharedDataPointer<PlotInstanceData>();
+
+  if (!_bufferValues.empty())
   {
+    if (_d.constData()->pins.load() > 0 && !dataComplete())
+    {
+      // A snapshot is being read. Keep the samples buffered rather than copy the data to detach.
+      return false;
+    }
+
+    _appendedCount += _bufferValues.size();
+
+    // Detach from any shared data before modifying.
+    PlotInstanceData &d = *_d;
+    std::vector<double> &times = d.mutableTimes();
+    PlotSampleColumn &values = d.values;
     if (!isRingBuffer())
     {
-      _data.reserve(_data.size() + _buffer.size());
-      _data.insert(_data.end(), _buffer.begin(), _buffer.end());
+      const size_t oldSize = values.size();
+      times.insert(times.end(), _bufferTimes.begin(), _bufferTimes.end());
+      values.append(_bufferValues.data(), _bufferValues.size());
+      d.lod.update(times.data(), values, values.size());
+      d.updateBounds(oldSize, _bufferValues.size());
     }
     else
     {
       // Adding in ring buffer mode.
       // Capacity check.
-      const QPointF *samples = _buffer.data();
-      size_t addCount = _buffer.size();
-      if (_buffer.size() >= _data.capacity())
+      const size_t capacity = values.capacity();
+      const double *newTimes = _bufferTimes.data();
+      const double *newValues = _bufferValues.data();
+      size_t addCount = _bufferValues.size();
+      if (addCount >= capacity)
       {
         // Number of new samples equals or exceeds our capacity. Reset.
-        size_t startIndex = addCount - _data.capacity();
+        size_t startIndex = addCount - capacity;
         _ringHead = 0;
-        _data.resize(_data.capacity());
-        memcpy(_data.data(), samples + startIndex, sizeof(QPointF) * _data.capacity());
+        ++_generation;
+        times.resize(capacity);
+        values.resize(capacity);
+        memcpy(times.data(), newTimes + startIndex, sizeof(double) * capacity);
+        values.write(0, newValues + startIndex, capacity);
+        d.updateBounds(0, capacity);
       }
       else
       {
         // Inserting less than capacity.
-        size_t insertAt;
-        const bool full = _data.size() >= size_t(_data.capacity());
+        const bool full = values.size() >= capacity;
         if (!full)
         {
           // Insert before buffer is full. Add to fill up first.
-          insertAt = _data.size();
-          const size_t remaining = _data.capacity() - _data.size();
+          const size_t insertAt = values.size();
+          const size_t remaining = capacity - values.size();
           size_t insertCount = std::min<size_t>(remaining, addCount);
-          _data.resize(_data.size() + insertCount);
-          memcpy(_data.data() + insertAt, samples, sizeof(QPointF) * insertCount);
+          times.resize(insertAt + insertCount);
+          memcpy(times.data() + insertAt, newTimes, sizeof(double) * insertCount);
+          values.append(newValues, insertCount);
+          d.updateBounds(insertAt, insertCount);
           addCount -= insertCount;
-          samples += insertCount;
+          newTimes += insertCount;
+          newValues += insertCount;
         }
 
         // More to insert?
         if (addCount)
         {
-          // We are full now and have more to insert. Will overwrite samples.
-          insertAt = _ringHead;
-          _ringHead = (_ringHead + addCount) % _data.capacity();
-
-          // First insertion from the read head
-          const size_t copyCount1 = std::min<size_t>(addCount, _data.capacity() - insertAt);
-          memcpy(_data.data() + insertAt, samples, sizeof(QPointF) * copyCount1);
-          const size_t copyCount2 = addCount - copyCount1;
-          if (copyCount2)
+          // We are full now and have more to insert. Will overwrite samples from the read head.
+          const size_t insertAt = _ringHead;
+          _ringHead = (_ringHead + addCount) % capacity;
+          ++_generation;
+          ringCopy(times, capacity, insertAt, newTimes, addCount);
+          ringCopy(values, capacity, insertAt, newValues, addCount);
+          // Rebuild the bounds over the overwritten entries, evicting the old samples.
+          const size_t wrapAt = std::min<size_t>(addCount, capacity - insertAt);
+          d.updateBounds(insertAt, wrapAt);
+          if (wrapAt < addCount)
           {
-            // Second insert: overflow.
-            memcpy(_data.data(), samples + copyCount1, sizeof(QPointF) * copyCount2);
+            d.updateBounds(0, addCount - wrapAt);
           }
         }
       }
     }
-    _buffer.clear();
+    _bufferTimes.clear();
+    _bufferValues.clear();
     return true;
   }
 
@@ -173,14 +342,67 @@ bool PlotInstance::migrateBuffer()
 }
 
 
+void PlotInstance::pinData()
+{
+  ++_d.constData()->pins;
+}
+
+
+void PlotInstance::releasePinnedData()
+{
+  // Unpin before releasing, while the reference keeps the data alive. A migration in between
+  // copies the data once, as for an unpinned snapshot.
+  --_d.constData()->pins;
+  _d = QSharedDataPointer<PlotInstanceData>();
+}
+
+
+bool PlotInstance::shareTimes(const PlotInstance &other)
+{
+  if (&other == this || isRingBuffer() || other.isRingBuffer())
+  {
+    return false;
+  }
+
+  // Const access so as not to detach.
+  const PlotInstanceData &od = *other._d;
+  const PlotInstanceData &cd = *static_cast<const PlotInstance *>(this)->_d;
+  if (cd.times == od.times)
+  {
+    return true;
+  }
+
+  // Sharing modifies the data, which would detach and copy the values while a snapshot
+  // shares them. Only share unshared data.
+  if (cd.ref.load() != 1)
+  {
+    return false;
+  }
+
+  // Bitwise comparison so NaN times match.
+  const size_t count = cd.values.size();
+  if (count != od.values.size() || cd.times->size() != count || od.times->size() != count ||
+      memcmp(cd.times->data(), od.times->data(), sizeof(double) * count) != 0)
+  {
+    return false;
+  }
+
+  // Unshared, so does not detach.
+  _d->times = od.times;
+  return true;
+}
+
+
 PlotInstance &PlotInstance::operator=(const PlotInstance &other)
 {
   _name = other._name;
   _source = other._source;
-  _data = other._data;
+  _d = other._d;
   _colour = other._colour;
   _expression = other._expression;
   _ringHead = other._ringHead;
+  _generation = other._generation;
+  _appendedCount = other._appendedCount;
   _source = other._source;
   _flags = other._flags;
   return *this;
@@ -8,20 +8,79 @@
 
 #include "plotsconfig.h"
 
+#include "plotboundstree.h"
+#include "plotlevelofdetail.h"
+#include "plotsamplecolumn.h"
 #include "plotsource.h"
 
 #include <QColor>
 #include <QMutex>
 #include <QPointF>
+#include <QSharedData>
+#include <QSharedDataPointer>
 #include <QString>
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 class PlotDataCurve;
 class PointSeriesData;
 class PlotExpression;
 
+/// @ingroup plot
+/// Implicitly shared sample storage for @c PlotInstance.
+///
+/// Samples are stored in columns: an array of time (X) values and an array of sample (Y)
+/// values. The time array is reference counted separately so that curves from the same
+/// @c PlotSource with identical times may share a single array (see
+/// @c PlotInstance::shareTimes()). This roughly halves the memory for file sources,
+/// where every column shares the same times. A shared time array is never modified; it
+/// is copied first (see @c mutableTimes()).
+///
+/// The values may be stored with a reduced precision @c PlotSampleEncoding, while times
+/// are always stored at full precision.
+struct PlotInstanceData : public QSharedData
+{
+  std::shared_ptr<std::vector<double>> times;  ///< Sample times. Never null. May be shared.
+  PlotSampleColumn values;      ///< Sample values. The capacity is preserved on copy.
+  PlotLevelOfDetail lod;        ///< Min/max pyramid over @c values. Not used for ring buffers.
+  PlotBoundsTree timeBounds;    ///< Range of @c times.
+  PlotBoundsTree valueBounds;   ///< Range of @c values.
+  /// Number of snapshots reading the data on other threads. See @c PlotInstance::pinData().
+  mutable std::atomic<int> pins;
+
+  /// Constructor.
+  /// @param encoding The encoding for @c values.
+  inline explicit PlotInstanceData(const PlotSampleEncoding &encoding = PlotSampleEncoding())
+    : times(std::make_shared<std::vector<double>>()), values(encoding), pins(0) {}
+
+  /// Copy constructor. The @c times are shared until modified. The copy is not pinned.
+  /// @param other The data to copy.
+  inline PlotInstanceData(const PlotInstanceData &other)
+    : QSharedData(other)
+    , times(other.times)
+    , values(other.values)
+    , lod(other.lod)
+    , timeBounds(other.timeBounds)
+    , valueBounds(other.valueBounds)
+    , pins(0)
+  {
+  }
+
+  /// Access the @c times for modification, first copying them if shared.
+  /// The capacity is preserved.
+  /// @return The unshared time array.
+  std::vector<double> &mutableTimes();
+
+  /// Update the @c timeBounds and @c valueBounds after modifying the elements
+  /// [@p from, @p from + @p count) of @c times and @c values.
+  /// @param from The first modified element.
+  /// @param count The number of modified elements.
+  void updateBounds(size_t from, size_t count);
+};
+
 /// @ingroup plot
 /// Holds data for a single curve.
 ///
@@ -34,10 +93,30 @@ class PlotExpression;
 /// While data can be sampled directly via @c sample(), a @c PlotInstanceSampler should
 /// be used to resolve time values and time scaling.
 ///
+/// @par Shared Data
+/// The sample data and @c levelOfDetail() are implicitly shared, copy-on-write. Copying a
+/// @c PlotInstance is cheap and the copy is an immutable snapshot of the data. The
+/// snapshot may be read from another thread while the main thread continues to call
+/// @c migrateBuffer() on the original, which detaches from the shared data before
+/// modifying it. Note that detaching copies the existing data, so snapshots should
+/// be short lived for curves which are still loading. Snapshots read while such curves
+/// continue loading should be pinned (see @c pinData()) to defer the migration instead.
+///
+/// @par Columnar Storage
+/// Samples are stored as contiguous time and value arrays rather than as points, so
+/// kernels such as bounds calculation scan plain @c double arrays. See
+/// @c PlotInstanceData. Producers still add @c QPointF samples.
+///
+/// @par Sample Encoding
+/// Values may be stored with reduced precision or compressed to save memory on long
+/// recordings (see @c setSampleEncoding()). The encoding defaults to that of the
+/// @c PlotSource. Values are decoded on access: use a @c PlotSampleColumn::Cursor with
+/// @c sample() for sequential access.
+///
 /// @par Ring Buffer Mode
-/// The structure may be operating in ring buffer mode, in which case the @c data array
-/// is fixed size and added to as a ring buffer. The @c ringHead marks the start of the
-/// ring buffer. The ring buffer is full once the @c data size equals its capacity.
+/// The structure may be operating in ring buffer mode, in which case the data arrays
+/// are fixed size and added to as a ring buffer. The @c ringHead marks the start of the
+/// ring buffer. The ring buffer is full once the @c sampleCount() equals its capacity.
 ///
 /// The @c PlotInstanceSampler handles sampling in ring buffer mode.
 class PlotInstance
@@ -49,7 +128,7 @@ public:
     /// Set when all data have been loaded and the curve is complete.
     /// No further calls to @c migrateBuffer() required.
     DataComplete = (1 << 0),
-    /// Set if the @c data member acts as a ring buffer. Affects @c sample(), @c addPoint(), @c addPoints().
+    /// Set if the data arrays act as a ring buffer. Affects @c sample(), @c addPoint(), @c addPoints().
     RingBuffer = (1 << 1),
     /// Set if the graph has been assigned an explicit colour. No colour shift will be performed in plotting
     /// the curve.
@@ -132,9 +211,50 @@ public:
   /// @param size The new symbol size.
   inline void setSymbolSize(unsigned size) { _symbolSize = std::uint8_t(size); }
 
-  /// Direct access to the data buffer. Use @c sample() for controlled access including ring buffer handling.
-  /// @return The internal data buffer (visible buffer).
-  inline const std::vector<QPointF> &data() const { return _data; }
+  /// Query the number of samples in the visible buffer.
+  /// @return The sample count.
+  inline size_t sampleCount() const { return _d->values.size(); }
+
+  /// Direct access to the contiguous sample time (X) array of the visible buffer. Use
+  /// @c sample() for controlled access including ring buffer handling.
+  /// @return The time array of @c sampleCount() elements.
+  inline const double *timeData() const { return _d->times->data(); }
+
+  /// Access the sample value (Y) column of the visible buffer.
+  /// @return The value column of @c sampleCount() elements.
+  inline const PlotSampleColumn &values() const { return _d->values; }
+
+  /// Query the value encoding.
+  /// @return The encoding of @c values().
+  inline const PlotSampleEncoding &sampleEncoding() const { return _d->values.encoding(); }
+
+  /// Change the value encoding, converting any existing values. Main thread only.
+  ///
+  /// @c PlotSampleEncoding::XorDelta is append only and is replaced by
+  /// @c PlotSampleEncoding::Float32 in ring buffer mode.
+  /// @param encoding The new encoding.
+  void setSampleEncoding(const PlotSampleEncoding &encoding);
+
+  /// Is the time array shared with another curve?
+  /// @return True if the @c timeData() is shared.
+  inline bool timesShared() const { return !_d->times.unique(); }
+
+  /// Access the range of the @c timeData(), maintained by @c migrateBuffer().
+  /// @return The time range tree.
+  inline const PlotBoundsTree &timeBounds() const { return _d->timeBounds; }
+
+  /// Access the range of the @c values(), maintained by @c migrateBuffer().
+  ///
+  /// Unlike the @c levelOfDetail(), the range is maintained for ring buffers, covering
+  /// only the samples currently in the buffer.
+  /// @return The value range tree.
+  inline const PlotBoundsTree &valueBounds() const { return _d->valueBounds; }
+
+  /// Access the min/max level of detail pyramid for @c values().
+  ///
+  /// The pyramid is maintained by @c migrateBuffer() and is empty for ring buffers.
+  /// @return The level of detail pyramid.
+  inline const PlotLevelOfDetail &levelOfDetail() const { return _d->lod; }
 
   /// Get the display colour for the plot. May be colour shifted when @c explicitColour() is false.
   /// @return The preferred display colour.
@@ -160,6 +280,21 @@ public:
   /// @return The read head index.
   inline size_t ringHead() const { return _ringHead; }
 
+  /// Query the data generation. The generation changes whenever existing samples are
+  /// modified, replaced or evicted from a ring buffer, but not when samples are only
+  /// appended. This allows views to draw appended samples incrementally.
+  /// @return The data generation.
+  inline unsigned dataGeneration() const { return _generation; }
+
+  /// Query the total number of samples added to the visible buffer by @c migrateBuffer(),
+  /// including those since evicted from a ring buffer. Replacement data count as added.
+  ///
+  /// Allows incremental consumers to identify the new samples by count rather than by
+  /// time: the last <tt>appendedCount() - previousCount</tt> samples are new, clamped
+  /// to the @c sampleCount().
+  /// @return The number of samples added.
+  inline std::uint64_t appendedCount() const { return _appendedCount; }
+
   /// Get the status, control and display @c Flag values.
   /// @return The set @c Flag values.
   inline std::uint16_t flags() const { return _flags; }
@@ -222,6 +357,13 @@ public:
   /// @param index The sampling index.
   QPointF sample(size_t index) const;
 
+  /// Samples the point at the given index, decoding values via @p cursor.
+  ///
+  /// Preferred for sequential access with compressed encodings.
+  /// @param index The sampling index.
+  /// @param cursor Caches decoded values between calls.
+  QPointF sample(size_t index, PlotSampleColumn::Cursor &cursor) const;
+
   /// Add a point to the back buffer (thread-safe).
   /// @param p The point to add.
   void addPoint(const QPointF &p);
@@ -231,11 +373,59 @@ public:
   /// @param pointCount The element count of @p points.
   void addPoints(const QPointF *points, size_t pointCount);
 
-  /// Migrate from the back buffer to @c data(). Main thread only.
+  /// Replace all data with @p data on the next @c migrateBuffer() (thread-safe).
+  ///
+  /// Supports swapping a preview of the data for the full resolution data. The @p data
+  /// are prepared privately by the caller, including the @c PlotInstanceData::lod and
+  /// bounds, then swapped in without copying. Any points in the back buffer are discarded.
+  /// Not supported in ring buffer mode.
+  ///
+  /// @param data The replacement data. Ownership passes to this object.
+  void replaceData(PlotInstanceData *data);
+
+  /// Replace all data with those of @p other on the next @c migrateBuffer() (thread-safe).
+  ///
+  /// As @c replaceData(), except the data are shared with @p other, copy-on-write. This
+  /// supports populating a curve from a private copy prepared on another thread.
+  /// @p other must not be modified concurrently.
+  ///
+  /// @param other The curve to share data with.
+  void shareData(const PlotInstance &other);
+
+  /// Migrate from the back buffer to the visible buffer. Main thread only.
+  ///
+  /// New samples remain in the back buffer while the data are pinned by a snapshot,
+  /// unless the curve is @c dataComplete(). See @c pinData().
+  /// @return True if the visible data have changed.
   bool migrateBuffer();
 
+  /// Pin the sample data of this snapshot (see @c operator=()) while it is read on another
+  /// thread. Main thread only.
+  ///
+  /// While pinned, @c migrateBuffer() on the original leaves new samples in the back buffer
+  /// rather than detaching from the shared data, which copies all the data. The samples are
+  /// migrated once the pin is released, so release the snapshot as soon as it has been read.
+  /// Complete curves are migrated regardless. Must be balanced by @c releasePinnedData().
+  void pinData();
+
+  /// Unpin the data pinned by @c pinData() and release this snapshot's reference to them.
+  /// The snapshot has no data afterwards and may only be destroyed. May be called from the
+  /// reading thread.
+  void releasePinnedData();
+
+  /// Share the time array of @p other if the sample times are identical. Main thread only.
+  ///
+  /// Intended for curves from the same @c PlotSource once loading is complete. The shared
+  /// array is copied should either curve later be modified. Ring buffers are not shared.
+  /// Nor are times shared while this curve's data are shared with a snapshot (see
+  /// @c operator=()), as that would copy the values.
+  ///
+  /// @param other The curve to share times with.
+  /// @return True if the times are now shared.
+  bool shareTimes(const PlotInstance &other);
+
   /// Assignment operator.
-  /// Copies all members excluding the data back buffer.
+  /// Copies all members excluding the data back buffer. The sample data are shared.
   /// @param other The object to copy.
   PlotInstance &operator=(const PlotInstance &other);
 
@@ -245,13 +435,16 @@ private:
   /// @param set True to set, false to clear.
   void setFlagsState(std::uint16_t flags, bool set);
 
-  std::vector<QPointF> _data;  ///< Plot data: only for access on the main thread.
+  /// Plot data and level of detail. Shared, copy-on-write. Only modified on the main thread.
+  QSharedDataPointer<PlotInstanceData> _d;
   PlotSource::Ptr _source;  ///< The owning source of this plot instance.
   QString _name;       ///< Name or heading of the curve.
   QRgb _colour;
   const PlotExpression *_expression; ///< Set if generated from an expression.
   /// For when @c data array is used as a ring buffer. Marks the read head.
   size_t _ringHead;
+  unsigned _generation;     ///< See @c dataGeneration().
+  std::uint64_t _appendedCount; ///< See @c appendedCount().
   std::uint16_t _flags;     ///< Various @c Flag values set.
   std::int8_t _style;       ///< Style, matching @c QwtPlotCurve::CurveStyle.
   std::uint8_t _width;      ///< Draw width.
@@ -259,7 +452,10 @@ private:
   std::uint8_t _symbolSize; ///< Size for symbols.
 
   QMutex _mutex;
-  std::vector<QPointF> _buffer;  ///< Back buffer for loading thread.
+  std::vector<double> _bufferTimes;   ///< Back buffer sample times for loading thread.
+  std::vector<double> _bufferValues;  ///< Back buffer sample values for loading thread.
+  /// Data to replace the visible data on migration. Null when not replacing. See @c replaceData().
+  QSharedDataPointer<PlotInstanceData> _replacement;
 };
 
 
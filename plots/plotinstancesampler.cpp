@@ -8,6 +8,13 @@
 #include "plotinstance.h"
 #include "plotutil.h"
 
+#include <qwt_scale_map.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
 namespace
 {
   // From qwt_series_data.cpp
@@ -23,7 +30,44 @@ PlotInstanceSampler::PlotInstanceSampler(const PlotInstance *curveData)
   : _curve(curveData)
   , _lastRingHead(0)
   , _lastRingSize(0)
+  , _timeIndexCount(0)
+  , _timeIndexSize(0)
+  , _timeIndexHead(0)
+  , _timeIndexGeneration(0)
+  , _timeIndexTimeCurve(nullptr)
+  , _timeIndexTimeGeneration(0)
+  , _timeIndexTimeBase(0)
+  , _timeIndexTimeScale(1)
+  , _timeCursor(0)
+  , _timeIndexLastTime(0)
+  , _timeIndexValid(false)
+  , _timeOrdered(false)
+  , _lodActive(false)
+  , _fixedTimeCurve(nullptr)
+  , _fixedTimeBase(0)
+  , _fixedTimeScale(1)
+  , _fixedTiming(false)
+{
+}
+
+
+void PlotInstanceSampler::setFixedTiming(const PlotInstance *timeCurve, double timeBase, double timeScale)
+{
+  _fixedTimeCurve = timeCurve;
+  _fixedTimeBase = timeBase;
+  _fixedTimeScale = timeScale;
+  _fixedTiming = true;
+  _boundingRect = QRectF(0, 0, 0, 0);
+  _timeIndexValid = false;
+}
+
+
+void PlotInstanceSampler::clearFixedTiming()
 {
+  _fixedTimeCurve = nullptr;
+  _fixedTiming = false;
+  _boundingRect = QRectF(0, 0, 0, 0);
+  _timeIndexValid = false;
 }
 
 
@@ -31,22 +75,105 @@ void PlotInstanceSampler::setCurve(const PlotInstance *curveData)
 {
   _curve = curveData;
   _boundingRect = QRectF(0, 0, 0, 0);
+  _timeOrder.clear();
+  _timeIndexValid = false;
+  clearLevelOfDetail();
 }
 
 
 size_t PlotInstanceSampler::size() const
 {
-  return _curve->data().size();
+  return (!_lodActive) ? _curve->sampleCount() : _lodIndices.size();
 }
 
 
 QPointF PlotInstanceSampler::sample(size_t i) const
 {
-  if (!_curve->data().empty())
+  return fullSample((!_lodActive) ? i : _lodIndices[i]);
+}
+
+
+bool PlotInstanceSampler::setLevelOfDetail(const QwtScaleMap &xMap, const QRectF &canvasRect)
+{
+  clearLevelOfDetail();
+
+  const size_t count = _curve->sampleCount();
+  const int pixels = int(std::ceil(canvasRect.width()));
+  if (pixels <= 0 || count <= size_t(pixels) * 4u || _curve->isRingBuffer() ||
+      _curve->levelOfDetail().sampleCount() != count ||
+      (_curve->flags() & (PlotInstance::FilterNaN | PlotInstance::FilterInf)) ||
+      !timeMonotonic())
+  {
+    return false;
+  }
+
+  const double left = canvasRect.left();
+  const double minTime = xMap.invTransform(left);
+  const double maxTime = xMap.invTransform(left + pixels);
+  if (!(minTime < maxTime))
+  {
+    // Inverted or degenerate axis.
+    return false;
+  }
+
+  const PlotLevelOfDetail &lod = _curve->levelOfDetail();
+  const PlotSampleColumn &values = _curve->values();
+
+  size_t index = lowerBound(minTime, 0, count);
+  // Include the sample before the visible range to draw the line in to the edge.
+  if (index > 0)
+  {
+    _lodIndices.push_back(index - 1);
+  }
+
+  size_t pixelIndices[4];
+  for (int p = 0; p < pixels && index < count; ++p)
+  {
+    const double columnEnd = xMap.invTransform(left + p + 1);
+    const size_t end = lowerBound(columnEnd, index, count);
+    if (end > index)
+    {
+      // Add first, min, max and last in index order.
+      pixelIndices[0] = index;
+      lod.minMax(values, index, end - 1, pixelIndices[1], pixelIndices[2]);
+      pixelIndices[3] = end - 1;
+      std::sort(pixelIndices + 1, pixelIndices + 3);
+      for (size_t idx : pixelIndices)
+      {
+        if (_lodIndices.empty() || _lodIndices.back() < idx)
+        {
+          _lodIndices.push_back(idx);
+        }
+      }
+      index = end;
+    }
+  }
+
+  // Include the sample after the visible range.
+  if (index < count)
+  {
+    _lodIndices.push_back(index);
+  }
+
+  _lodActive = true;
+  return true;
+}
+
+
+void PlotInstanceSampler::clearLevelOfDetail()
+{
+  _lodIndices.clear();
+  _lodActive = false;
+}
+
+
+QPointF PlotInstanceSampler::fullSample(size_t i) const
+{
+  if (_curve->sampleCount())
   {
     // Fetch the initial sample.
     typedef std::numeric_limits<qreal> Limits;
-    QPointF sample = _curve->sample(i);
+    QPointF sample = _curve->sample(i, _valueCursor);
 
     // Filter NaN and infinite results.
     if (_curve->flags() & (PlotInstance::FilterNaN | PlotInstance::FilterInf))
@@ -71,15 +198,95 @@ QPointF PlotInstanceSampler::sample(size_t i) const
 }
 
 
+bool PlotInstanceSampler::interpolate(double time, double &value, PlotResampler::Policy policy) const
+{
+  updateTimeIndex();
+
+  const size_t count = _timeIndexCount;
+  const size_t index = findTime(time);
+  if (index >= count)
+  {
+    return false;
+  }
+
+  const QPointF to = fullSample(orderedIndex(index));
+  if (index == 0)
+  {
+    // Only matches exactly at the first sample.
+    if (to.x() == time)
+    {
+      value = to.y();
+      return true;
+    }
+    return false;
+  }
+
+  // from.x() < time <= to.x()
+  const QPointF from = fullSample(orderedIndex(index - 1));
+  switch (policy)
+  {
+  case PlotResampler::Hold:
+    value = (to.x() == time) ? to.y() : from.y();
+    break;
+  case PlotResampler::Nearest:
+    value = (time - from.x() < to.x() - time) ? from.y() : to.y();
+    break;
+  case PlotResampler::Linear:
+  case PlotResampler::NoExtrapolate:
+  default:
+  {
+    const double normalTime = (time - from.x()) / (to.x() - from.x());
+    value = from.y() + normalTime * (to.y() - from.y());
+    break;
+  }
+  }
+  return true;
+}
+
+
+size_t PlotInstanceSampler::timeOrderedCount() const
+{
+  updateTimeIndex();
+  return _timeIndexCount;
+}
+
+
+double PlotInstanceSampler::timeOrderedTime(size_t i) const
+{
+  return sampleTime(orderedIndex(i));
+}
+
+
+bool PlotInstanceSampler::timeRange(double &minTime, double &maxTime) const
+{
+  updateTimeIndex();
+  if (!_timeIndexCount)
+  {
+    return false;
+  }
+
+  minTime = sampleTime(orderedIndex(0));
+  maxTime = sampleTime(orderedIndex(_timeIndexCount - 1));
+  return true;
+}
+
+
 QRectF PlotInstanceSampler::boundingRect() const
 {
-  if (_boundingRect.width() == 0 || _lastRingHead != _curve->ringHead() || _lastRingSize != _curve->data().size())
+  // Use the maintained bounds where possible. These are always current.
+  QRectF rect;
+  if (_curve->sampleCount() && treeBoundingRect(rect))
+  {
+    return rect;
+  }
+
+  if (_boundingRect.width() == 0 || _lastRingHead != _curve->ringHead() || _lastRingSize != _curve->sampleCount())
   {
     _boundingRect = calculateBoundingRect();
   }
 
   _lastRingHead = _curve->ringHead();
-  _lastRingSize = _curve->data().size();
+  _lastRingSize = _curve->sampleCount();
   return _boundingRect;
 }
 
@@ -95,20 +302,31 @@ QRectF PlotInstanceSampler::calculateBoundingRect(size_t from, size_t to) const
   // From qwt_series_data.cpp
   QRectF boundingRect(1.0, 1.0, -2.0, -2.0); // invalid;
 
+  const size_t count = _curve->sampleCount();
   if (to == ~(size_t)(0u))
   {
-    to = size() - 1;
+    to = count - 1;
   }
 
-  if (!size() || to < from)
+  if (!count || to < from)
   {
     return boundingRect;
   }
 
+  if (from == 0 && to == count - 1)
+  {
+    // Full series: use the maintained bounds where possible.
+    QRectF rect;
+    if (treeBoundingRect(rect))
+    {
+      return rect;
+    }
+  }
+
   size_t i;
   for (i = from; i <= to; i++)
   {
-    const QRectF rect = qwtBoundingRect(sample(i));
+    const QRectF rect = qwtBoundingRect(fullSample(i));
     if (rect.width() >= 0.0 && rect.height() >= 0.0)
     {
       boundingRect = rect;
@@ -119,7 +337,7 @@ QRectF PlotInstanceSampler::calculateBoundingRect(size_t from, size_t to) const
 
   for (; i <= to; i++)
   {
-    const QRectF rect = qwtBoundingRect(sample(i));
+    const QRectF rect = qwtBoundingRect(fullSample(i));
     if (rect.width() >= 0.0 && rect.height() >= 0.0)
     {
       boundingRect.setLeft(qMin(boundingRect.left(), rect.left()));
@@ -133,19 +351,312 @@ QRectF PlotInstanceSampler::calculateBoundingRect(size_t from, size_t to) const
 }
 
 
+bool PlotInstanceSampler::treeBoundingRect(QRectF &rect) const
+{
+  double minX = 0, maxX = 0, minY = 0, maxY = 0;
+  if (!_curve->valueBounds().range(_curve->filterNaN(), _curve->filterInf(), minY, maxY))
+  {
+    // Leave NaN handling to the generic path.
+    return false;
+  }
+
+  if (_curve->explicitTime())
+  {
+    if (!_curve->timeBounds().range(false, false, minX, maxX))
+    {
+      return false;
+    }
+  }
+  else
+  {
+    if (const PlotInstance *timeCurve = timeColumnCurve())
+    {
+      // Times come from the time column curve, which must be indexed the same way.
+      if (_curve->isRingBuffer() || timeCurve->isRingBuffer() ||
+          timeCurve->sampleCount() != _curve->sampleCount() ||
+          !timeCurve->valueBounds().range(false, false, minX, maxX))
+      {
+        return false;
+      }
+    }
+    else if (!_curve->timeBounds().range(false, false, minX, maxX))
+    {
+      return false;
+    }
+
+    // The time shift and scale are linear, but a negative scale swaps the extents.
+    minX = (minX - timeBase()) * timeScale();
+    maxX = (maxX - timeBase()) * timeScale();
+    if (maxX < minX)
+    {
+      std::swap(minX, maxX);
+    }
+  }
+
+  rect = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+  return true;
+}
+
+
 double PlotInstanceSampler::lookupSampleTime(double initialTime, size_t i) const
 {
   double time = initialTime;
-  const PlotSource &source = _curve->source();
   // Lookup the requested sample in the time column if required.
-  if (PlotInstance *timeCurve = source.timeColumnCurve())
+  if (const PlotInstance *timeCurve = timeColumnCurve())
   {
-    time = timeCurve->sample(i).y();
+    time = timeCurve->sample(i, _timeColumnCursor).y();
   }
 
   // Time shift before scaling.
-  time -= source.timeBase();
+  time -= timeBase();
   // Scale.
-  time *= source.timeScale();
+  time *= timeScale();
   return time;
 }
+
+
+const PlotInstance *PlotInstanceSampler::timeColumnCurve() const
+{
+  return (_fixedTiming) ? _fixedTimeCurve : _curve->source().timeColumnCurve();
+}
+
+
+double PlotInstanceSampler::timeBase() const
+{
+  return (_fixedTiming) ? _fixedTimeBase : _curve->source().timeBase();
+}
+
+
+double PlotInstanceSampler::timeScale() const
+{
+  return (_fixedTiming) ? _fixedTimeScale : _curve->source().timeScale();
+}
+
+
+double PlotInstanceSampler::sampleTime(size_t i) const
+{
+  const double time = _curve->sample(i, _valueCursor).x();
+  return (_curve->explicitTime()) ? time : lookupSampleTime(time, i);
+}
+
+
+bool PlotInstanceSampler::timeMonotonic() const
+{
+  if (_curve->explicitTime())
+  {
+    return _curve->levelOfDetail().xMonotonic();
+  }
+
+  if (!(timeScale() > 0))
+  {
+    return false;
+  }
+
+  if (const PlotInstance *timeCurve = timeColumnCurve())
+  {
+    return !timeCurve->isRingBuffer() && timeCurve->levelOfDetail().yMonotonic() &&
+           timeCurve->levelOfDetail().sampleCount() >= _curve->sampleCount();
+  }
+
+  return _curve->levelOfDetail().xMonotonic();
+}
+
+
+void PlotInstanceSampler::updateTimeIndex() const
+{
+  const size_t count = (_curve) ? _curve->sampleCount() : 0u;
+  const size_t head = (_curve) ? _curve->ringHead() : 0u;
+  const unsigned generation = (_curve) ? _curve->dataGeneration() : 0u;
+  const PlotInstance *timeCurve = (_curve && !_curve->explicitTime()) ? timeColumnCurve() : nullptr;
+  const unsigned timeGeneration = (timeCurve) ? timeCurve->dataGeneration() : 0u;
+  const double base = (_curve) ? timeBase() : 0.0;
+  const double scale = (_curve) ? timeScale() : 1.0;
+  // Any change in timing invalidates the index. Bitwise equality so NaN settings match.
+  const bool sameTiming = timeCurve == _timeIndexTimeCurve && timeGeneration == _timeIndexTimeGeneration &&
+                          memcmp(&base, &_timeIndexTimeBase, sizeof(base)) == 0 &&
+                          memcmp(&scale, &_timeIndexTimeScale, sizeof(scale)) == 0;
+  if (_timeIndexValid && sameTiming && _timeIndexSize == count && _timeIndexHead == head &&
+      _timeIndexGeneration == generation)
+  {
+    return;
+  }
+
+  if (_timeIndexValid && sameTiming && !_timeOrdered && _timeIndexSize > 0)
+  {
+    // Samples appended to a monotonic curve need only be checked for continuity. This
+    // includes a ring buffer which has yet to wrap. A change in generation means existing
+    // samples have changed, such as when the data are replaced.
+    if (_timeIndexSize < count && head == 0 && _timeIndexHead == 0 && _timeIndexGeneration == generation &&
+        scanMonotonic(_timeIndexSize, count))
+    {
+      _timeIndexSize = _timeIndexCount = count;
+      _timeIndexLastTime = sampleTime(count - 1);
+      return;
+    }
+
+    // A full ring buffer evicts the oldest samples to add new ones, advancing the head and
+    // the generation. The retained samples are unchanged so long as the last indexed sample
+    // is still in place. Otherwise the buffer has been overwritten entirely and needs a full
+    // scan.
+    if (_curve->isRingBuffer() && _timeIndexSize == count)
+    {
+      const size_t shift = (head + count - _timeIndexHead) % count;
+      if (shift > 0 && sampleTime(count - shift - 1) == _timeIndexLastTime &&
+          scanMonotonic(count - shift, count))
+      {
+        _timeIndexHead = head;
+        _timeIndexGeneration = generation;
+        _timeCursor = (_timeCursor > shift) ? _timeCursor - shift : 0;
+        _timeIndexLastTime = sampleTime(count - 1);
+        return;
+      }
+    }
+  }
+
+  _timeIndexValid = true;
+  _timeIndexSize = count;
+  _timeIndexHead = head;
+  _timeIndexGeneration = generation;
+  _timeIndexTimeCurve = timeCurve;
+  _timeIndexTimeGeneration = timeGeneration;
+  _timeIndexTimeBase = base;
+  _timeIndexTimeScale = scale;
+  _timeIndexCount = count;
+  _timeCursor = 0;
+  _timeOrdered = false;
+  _timeOrder.clear();
+
+  if (!count)
+  {
+    return;
+  }
+
+  _timeIndexLastTime = sampleTime(count - 1);
+
+  // Check for monotonic time, preferably from the level of detail, otherwise by scanning.
+  const bool monotonic = (!_curve->isRingBuffer() && _curve->levelOfDetail().sampleCount() == count &&
+                          timeMonotonic()) || scanMonotonic(0, count);
+  if (monotonic)
+  {
+    return;
+  }
+
+  // Build a time ordered permutation of the samples, excluding NaN times.
+  std::vector<double> times(count);
+  _timeOrder.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    times[i] = sampleTime(i);
+    if (times[i] == times[i])
+    {
+      _timeOrder.push_back(i);
+    }
+  }
+
+  std::stable_sort(_timeOrder.begin(), _timeOrder.end(), [&times] (size_t a, size_t b)
+  {
+    return times[a] < times[b];
+  });
+
+  _timeIndexCount = _timeOrder.size();
+  _timeOrdered = true;
+}
+
+
+bool PlotInstanceSampler::scanMonotonic(size_t from, size_t to) const
+{
+  double previous = (from > 0) ? sampleTime(from - 1) : -std::numeric_limits<double>::infinity();
+  for (size_t i = from; i < to; ++i)
+  {
+    const double time = sampleTime(i);
+    // Fails for NaN values.
+    if (!(previous <= time))
+    {
+      return false;
+    }
+    previous = time;
+  }
+  return true;
+}
+
+
+size_t PlotInstanceSampler::findTime(double time) const
+{
+  const size_t count = _timeIndexCount;
+  size_t cursor = std::min(_timeCursor, count);
+  size_t from = 0;
+  size_t to = count;
+
+  // Gallop from the cursor to bracket the result in [from, to].
+  if (cursor < count && sampleTime(orderedIndex(cursor)) < time)
+  {
+    // Search forwards.
+    from = cursor + 1;
+    for (size_t step = 1; cursor + step < count; step *= 2)
+    {
+      const size_t probe = cursor + step;
+      if (!(sampleTime(orderedIndex(probe)) < time))
+      {
+        to = probe;
+        break;
+      }
+      from = probe + 1;
+    }
+  }
+  else
+  {
+    // Search backwards. The cursor time is not less than the search time.
+    to = cursor;
+    for (size_t step = 1; to > 0; step *= 2)
+    {
+      const size_t probe = (to >= step) ? to - step : 0;
+      if (sampleTime(orderedIndex(probe)) < time)
+      {
+        from = probe + 1;
+        break;
+      }
+      to = probe;
+    }
+  }
+
+  // Binary search the bracket.
+  size_t range = to - from;
+  while (range > 0)
+  {
+    const size_t step = range / 2;
+    const size_t mid = from + step;
+    if (sampleTime(orderedIndex(mid)) < time)
+    {
+      from = mid + 1;
+      range -= step + 1;
+    }
+    else
+    {
+      range = step;
+    }
+  }
+
+  _timeCursor = from;
+  return from;
+}
+
+
+size_t PlotInstanceSampler::lowerBound(double time, size_t from, size_t to) const
+{
+  size_t count = to - from;
+  while (count > 0)
+  {
+    const size_t step = count / 2;
+    const size_t mid = from + step;
+    if (sampleTime(mid) < time)
+    {
+      from = mid + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
+    }
+  }
+  return from;
+}
@@ -8,9 +8,15 @@
 
 #include "plotsconfig.h"
 
+#include "plotresampler.h"
+#include "plotsamplecolumn.h"
+
 #include "qwt_series_data.h"
 
+#include <vector>
+
 class PlotInstance;
+class QwtScaleMap;
 
 /// @ingroup plot
 /// An adaptor class converting from @c PlotInstance data to @c QwtSeriesData.
@@ -20,6 +26,20 @@ class PlotInstance;
 /// dictated by the @c PlotSource. This includes accessing the time column,
 /// adjusting the time-base and time scaling (in that order).
 ///
+/// The sampler may also reduce the samples it exposes for rendering. See
+/// @c setLevelOfDetail().
+///
+/// For expression evaluation, the sampler supports interpolating the curve at
+/// arbitrary times via @c interpolate(). This maintains a time index over the
+/// full series: a search cursor for monotonic time and a sorted permutation of the
+/// samples for non-monotonic time. The index for monotonic time is updated incrementally
+/// as samples are appended, including samples added to a full ring buffer.
+///
+/// The timing is normally resolved from the @c PlotSource on each access, so that timing
+/// changes take effect immediately. @c setFixedTiming() instead binds the sampler to a
+/// given time column curve and timing. This supports sampling a snapshot of the curve
+/// data on another thread, while the source is modified on the main thread.
+///
 /// A @c PlotInstance must outlive all its samplers.
 class PlotInstanceSampler : public QwtSeriesData<QPointF>
 {
@@ -35,18 +55,105 @@ public:
   /// @return The curve to sample.
   inline const PlotInstance *curve() const { return _curve; }
 
+  /// Fix the time column curve and timing rather than resolving them from the @c PlotSource.
+  ///
+  /// The @p timeCurve must outlive the sampler, or until @c clearFixedTiming() is called.
+  ///
+  /// @param timeCurve The curve providing time values, or null to use the curve sample
+  ///   times. Replaces @c PlotSource::timeColumnCurve().
+  /// @param timeBase Replaces @c PlotSource::timeBase().
+  /// @param timeScale Replaces @c PlotSource::timeScale().
+  void setFixedTiming(const PlotInstance *timeCurve, double timeBase, double timeScale);
+
+  /// Revert to resolving the timing from the @c PlotSource.
+  void clearFixedTiming();
+
   /// Returns the number of samples in the @c PlotInstance.
+  ///
+  /// Returns the reduced sample count while a level of detail is active.
+  ///
   /// @return The curve sample count.
   size_t size() const override;
 
   /// Samples the @p ith element of the plot. Respects timing conversions.
   ///
+  /// Samples the reduced sample set while a level of detail is active.
+  ///
   /// @param i The sample number to request: [0, @c size()).
   /// @return The plot sample. The y value is the sample value, while the x
   ///   value is the sample index or adjusted time.
   QPointF sample(size_t i) const override;
 
-  /// Overridden to recalculate the as required bounds.
+  /// Reduce the exposed samples to those required to render the visible range of the curve.
+  ///
+  /// The visible X range is divided into pixel columns. For each column, only the first,
+  /// last, minimum and maximum samples are exposed (M4 reduction), plus the samples on
+  /// either side of the visible range. Rendering the result as a line of width one is
+  /// identical to rendering the full series, but the number of samples is bounded by the
+  /// canvas width. The minimum and maximum are resolved via the
+  /// @c PlotInstance::levelOfDetail() pyramid.
+  ///
+  /// Reduction requires monotonic time values and is not used for ring buffers, curves
+  /// with NaN/infinite filtering, or when there are few samples compared to the canvas
+  /// width. The full series is exposed in such cases.
+  ///
+  /// The level of detail should be cleared by @c clearLevelOfDetail() after rendering.
+  /// The @c boundingRect() always considers the full series.
+  ///
+  /// @param xMap Maps between time values and canvas pixels.
+  /// @param canvasRect The canvas rectangle.
+  /// @return True if the reduction is active.
+  bool setLevelOfDetail(const QwtScaleMap &xMap, const QRectF &canvasRect);
+
+  /// Clear the level of detail, exposing the full series.
+  void clearLevelOfDetail();
+
+  /// Is a level of detail reduction active?
+  /// @return True if @c setLevelOfDetail() is in effect.
+  inline bool levelOfDetailActive() const { return _lodActive; }
+
+  /// Interpolate the curve value at @p time.
+  ///
+  /// Resolves the value between the samples either side of @p time according to the
+  /// @p policy: linear interpolation, holding the earlier sample or taking the nearest
+  /// sample. Where time is not monotonic, samples are interpolated in time order, using a
+  /// sorted permutation of the samples built on demand. Samples with NaN time values are
+  /// ignored.
+  ///
+  /// The search gallops from the previous result, so sequential lookups are
+  /// effectively constant time, while random lookups are O(log N).
+  ///
+  /// Ignores any level of detail reduction.
+  ///
+  /// @param time The time to interpolate at.
+  /// @param[out] value Set to the interpolated value on success.
+  /// @param policy How to resolve values between samples. @c PlotResampler::NoExtrapolate
+  ///   interpolates linearly; extrapolation is left to the caller.
+  /// @return True if @p time is within the @c timeRange() and @p value is set.
+  bool interpolate(double time, double &value, PlotResampler::Policy policy = PlotResampler::Linear) const;
+
+  /// Query the number of samples with valid times, as indexed for @c interpolate().
+  /// Ignores any level of detail reduction.
+  /// @return The number of samples in time order.
+  size_t timeOrderedCount() const;
+
+  /// Query the time of the @p ith sample in time order. Requires a prior call to
+  /// @c timeOrderedCount() to update the time index.
+  /// @param i The time ordered index: [0, @c timeOrderedCount()).
+  /// @return The sample time.
+  double timeOrderedTime(size_t i) const;
+
+  /// Query the range of sample time values. Ignores any level of detail reduction.
+  /// @param[out] minTime Set to the minimum sample time.
+  /// @param[out] maxTime Set to the maximum sample time.
+  /// @return True if there are samples with valid times, false otherwise.
+  bool timeRange(double &minTime, double &maxTime) const;
+
+  /// Overridden to recalculate the bounds as required.
+  ///
+  /// The bounds are generally resolved in constant time from the bounds maintained by the
+  /// @c PlotInstance as data are added. Otherwise the bounds are calculated by a full
+  /// scan, cached until the curve size or ring buffer head changes.
   /// @return The curve bounds.
   QRectF boundingRect() const override;
 
@@ -58,6 +165,78 @@ public:
   QRectF calculateBoundingRect(size_t from = 0, size_t to = ~(size_t)(0u)) const;
 
 private:
+  /// Calculate the bounds of the full series from the @c PlotInstance::timeBounds() and
+  /// @c PlotInstance::valueBounds(), applying the time shift, scale and value filtering
+  /// to the extents only. This is constant time, so changes to the timing or filtering
+  /// require no rescan.
+  ///
+  /// Not supported when time column indexing does not match the value array, nor when
+  /// either axis has only NaN values.
+  ///
+  /// @param[out] rect Set to the bounds on success.
+  /// @return True on success, false if the generic calculation is required.
+  bool treeBoundingRect(QRectF &rect) const;
+
+  /// Samples the @p ith element of the full series. See @c sample().
+  /// @param i The sample number to request.
+  /// @return The plot sample.
+  QPointF fullSample(size_t i) const;
+
+  /// Resolve just the time value for the @p ith element of the full series.
+  /// @param i The sample number to request.
+  /// @return The sample time.
+  double sampleTime(size_t i) const;
+
+  /// Resolve the time column curve from the fixed timing or the @c PlotSource.
+  /// @return The time column curve, or null if not using a time column.
+  const PlotInstance *timeColumnCurve() const;
+
+  /// Resolve the time base from the fixed timing or the @c PlotSource.
+  /// @return The time base.
+  double timeBase() const;
+
+  /// Resolve the time scale from the fixed timing or the @c PlotSource.
+  /// @return The time scale.
+  double timeScale() const;
+
+  /// Check if the @c sampleTime() values are known to be monotonic (non-decreasing).
+  /// @return True if time is monotonic.
+  bool timeMonotonic() const;
+
+  /// Find the first sample index in [@p from, @p to) with a time not less than @p time.
+  /// Requires @c timeMonotonic().
+  /// @param time The time value to search for.
+  /// @param from The first index to consider.
+  /// @param to The end of the search range (exclusive).
+  /// @return The index of the first sample at or after @p time, or @p to if there is none.
+  size_t lowerBound(double time, size_t from, size_t to) const;
+
+  /// Update the time index used by @c interpolate() if the curve has changed.
+  ///
+  /// The index is keyed by the curve size, ring head and @c PlotInstance::dataGeneration(),
+  /// as well as the time column curve and its generation, the time base and time scale.
+  /// Appended samples are indexed incrementally only when the data generation is unchanged.
+  void updateTimeIndex() const;
+
+  /// Check if the sample times in [@p from, @p to) are non-decreasing and continue
+  /// on from the sample before @p from. NaN times are not monotonic.
+  /// @param from The first sample index to check.
+  /// @param to The end of the range to check (exclusive).
+  /// @return True if time is monotonic over the range.
+  bool scanMonotonic(size_t from, size_t to) const;
+
+  /// Resolve the sample index for the @p ith element in time order.
+  /// @param i The time ordered index: [0, @c _timeIndexCount).
+  /// @return The sample index.
+  inline size_t orderedIndex(size_t i) const { return (_timeOrdered) ? _timeOrder[i] : i; }
+
+  /// Find the first time ordered index with a time not less than @p time. Galloping search
+  /// from @c _timeCursor.
+  /// @param time The time value to search for.
+  /// @return The time ordered index of the first sample at or after @p time, or
+  ///   @c _timeIndexCount if there is none.
+  size_t findTime(double time) const;
+
   /// Resolves sample time for the @p ith element.
   /// @param initialTime The initial time value as reported by the @c PlotInstance.
   /// @return The adjusted time value.
@@ -67,6 +246,27 @@ private:
   mutable QRectF _boundingRect; ///< Cache bounds.
   mutable size_t _lastRingHead; ///< Last ring buffer element head.
   mutable size_t _lastRingSize; ///< last ring buffer size.
+  std::vector<size_t> _lodIndices;  ///< Sample indices exposed while a level of detail is active.
+  mutable std::vector<size_t> _timeOrder; ///< Sample indices sorted by time. Used when not @c _timeMonotonic.
+  mutable size_t _timeIndexCount;   ///< Number of samples in the time index.
+  mutable size_t _timeIndexSize;    ///< Curve size when the time index was built.
+  mutable size_t _timeIndexHead;    ///< Curve ring head when the time index was built.
+  mutable unsigned _timeIndexGeneration;  ///< Curve data generation when the time index was built.
+  mutable const PlotInstance *_timeIndexTimeCurve;  ///< Time column curve when the time index was built.
+  mutable unsigned _timeIndexTimeGeneration;  ///< Time column curve data generation when the index was built.
+  mutable double _timeIndexTimeBase;  ///< Time base when the time index was built.
+  mutable double _timeIndexTimeScale; ///< Time scale when the time index was built.
+  mutable size_t _timeCursor;       ///< Time ordered index of the last @c findTime() result.
+  mutable double _timeIndexLastTime;  ///< Time of the last sample when the time index was updated.
+  mutable bool _timeIndexValid;     ///< True if the time index is up to date.
+  mutable bool _timeOrdered;        ///< True if using the @c _timeOrder permutation.
+  mutable PlotSampleColumn::Cursor _valueCursor;      ///< Decodes curve values for sequential access.
+  mutable PlotSampleColumn::Cursor _timeColumnCursor; ///< Decodes time column values.
+  bool _lodActive;              ///< True when a level of detail is active.
+  const PlotInstance *_fixedTimeCurve;  ///< Time column curve for @c setFixedTiming().
+  double _fixedTimeBase;        ///< Time base for @c setFixedTiming().
+  double _fixedTimeScale;       ///< Time scale for @c setFixedTiming().
+  bool _fixedTiming;            ///< True when @c setFixedTiming() is in effect.
 };
 
 #endif // PLOTINSTANCESAMPLER_H_
@@ -0,0 +1,192 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "plotlevelofdetail.h"
+
+#include <algorithm>
+
+namespace
+{
+  inline bool isNaN(double value)
+  {
+    return value != value;
+  }
+
+
+  /// Bucket size at @p level.
+  inline size_t bucketSize(size_t level)
+  {
+    return size_t(PlotLevelOfDetail::BaseBucketSize) << (level * PlotLevelOfDetail::LevelShift);
+  }
+}
+
+
+PlotLevelOfDetail::PlotLevelOfDetail()
+  : _sampleCount(0)
+  , _xMonotonic(true)
+  , _yMonotonic(true)
+{
+}
+
+
+void PlotLevelOfDetail::clear()
+{
+  _levels.clear();
+  _sampleCount = 0;
+  _xMonotonic = _yMonotonic = true;
+}
+
+
+void PlotLevelOfDetail::update(const double *x, const PlotSampleColumn &y, size_t count)
+{
+  if (count < _sampleCount)
+  {
+    clear();
+  }
+
+  if (count == _sampleCount)
+  {
+    return;
+  }
+
+  // Monotonic X check over the new samples. Y is checked as it is decoded below.
+  for (size_t i = std::max<size_t>(_sampleCount, 1u); i < count && _xMonotonic; ++i)
+  {
+    // False for NaN times, which are unordered.
+    _xMonotonic = x[i] >= x[i - 1];
+  }
+
+  // Update the first level from the samples. Start with the bucket containing the
+  // first new sample as it may have been partial.
+  size_t dirtyBucket = _sampleCount >> BaseBucketShift;
+  size_t bucketCount = (count + BaseBucketSize - 1) >> BaseBucketShift;
+
+  if (_levels.empty())
+  {
+    _levels.push_back(std::vector<Bucket>());
+  }
+
+  std::vector<Bucket> *level = &_levels[0];
+  level->resize(bucketCount);
+  double values[BaseBucketSize];
+  double previous = (_sampleCount) ? y.value(_sampleCount - 1) : 0.0;
+  for (size_t b = dirtyBucket; b < bucketCount; ++b)
+  {
+    Bucket &bucket = (*level)[b];
+    const size_t from = b << BaseBucketShift;
+    const size_t to = std::min<size_t>(from + BaseBucketSize, count);
+    // Decode the bucket in one pass.
+    y.decode(from, to - from, values);
+    bucket.minIndex = bucket.maxIndex = from;
+    bucket.minValue = bucket.maxValue = values[0];
+    for (size_t i = from + 1; i < to; ++i)
+    {
+      addSample(bucket, values[i - from], i);
+    }
+
+    for (size_t i = std::max(from, _sampleCount); i < to && _yMonotonic; ++i)
+    {
+      _yMonotonic = i == 0 || values[i - from] >= previous;
+      previous = values[i - from];
+    }
+  }
+
+  // Update the coarser levels from the level below.
+  size_t levelIndex = 1;
+  while (bucketCount > 1)
+  {
+    dirtyBucket >>= LevelShift;
+    const size_t childCount = bucketCount;
+    bucketCount = (bucketCount + LevelFactor - 1) >> LevelShift;
+
+    if (_levels.size() <= levelIndex)
+    {
+      _levels.push_back(std::vector<Bucket>());
+    }
+
+    const std::vector<Bucket> &children = _levels[levelIndex - 1];
+    level = &_levels[levelIndex];
+    level->resize(bucketCount);
+    for (size_t b = dirtyBucket; b < bucketCount; ++b)
+    {
+      Bucket &bucket = (*level)[b];
+      const size_t from = b << LevelShift;
+      const size_t to = std::min<size_t>(from + LevelFactor, childCount);
+      bucket = children[from];
+      for (size_t i = from + 1; i < to; ++i)
+      {
+        addBucket(bucket, children[i]);
+      }
+    }
+
+    ++levelIndex;
+  }
+
+  _sampleCount = count;
+}
+
+
+void PlotLevelOfDetail::minMax(const PlotSampleColumn &y, size_t from, size_t to, size_t &minIndex, size_t &maxIndex) const
+{
+  PlotSampleColumn::Cursor cursor;
+  Bucket result;
+  result.minIndex = result.maxIndex = from;
+  result.minValue = result.maxValue = cursor.value(y, from);
+
+  const size_t end = to + 1;
+  size_t i = from + 1;
+  while (i < end)
+  {
+    // Use the coarsest complete bucket aligned at i.
+    bool usedBucket = false;
+    for (size_t level = _levels.size(); level > 0; --level)
+    {
+      const size_t size = bucketSize(level - 1);
+      if (i % size == 0 && i + size <= end && i + size <= _sampleCount)
+      {
+        addBucket(result, _levels[level - 1][i / size]);
+        i += size;
+        usedBucket = true;
+        break;
+      }
+    }
+
+    if (!usedBucket)
+    {
+      addSample(result, cursor.value(y, i), i);
+      ++i;
+    }
+  }
+
+  minIndex = result.minIndex;
+  maxIndex = result.maxIndex;
+}
+
+
+void PlotLevelOfDetail::addSample(Bucket &bucket, double value, size_t index)
+{
+  if (isNaN(value))
+  {
+    return;
+  }
+
+  if (value < bucket.minValue || isNaN(bucket.minValue))
+  {
+    bucket.minIndex = index;
+    bucket.minValue = value;
+  }
+  if (value > bucket.maxValue || isNaN(bucket.maxValue))
+  {
+    bucket.maxIndex = index;
+    bucket.maxValue = value;
+  }
+}
+
+
+void PlotLevelOfDetail::addBucket(Bucket &bucket, const Bucket &other)
+{
+  addSample(bucket, other.minValue, other.minIndex);
+  addSample(bucket, other.maxValue, other.maxIndex);
+}
@@ -0,0 +1,115 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef PLOTLEVELOFDETAIL_H_
+#define PLOTLEVELOFDETAIL_H_
+
+#include "plotsconfig.h"
+
+#include "plotsamplecolumn.h"
+
+#include <cstddef>
+#include <vector>
+
+/// @ingroup plot
+/// A multi-resolution min/max pyramid over the Y values of a columnar sample array.
+///
+/// The pyramid supports fast queries for the indices of the minimum and maximum
+/// values in any range of samples, as required to reduce a series for rendering
+/// while preserving its visual extents (see @c PlotInstanceSampler::setLevelOfDetail()).
+///
+/// The first level buckets @c BaseBucketSize samples, with each subsequent level
+/// combining @c LevelFactor buckets from the previous level. Each bucket stores the
+/// indices of its minimum and maximum samples. The pyramid is only a fraction of the size
+/// of the sample array and may be updated incrementally as samples are appended.
+/// NaN values are ignored unless a bucket contains nothing else.
+///
+/// The pyramid also tracks whether the X and Y values are monotonic (non-decreasing).
+///
+/// The pyramid does not store the samples; the same sample arrays must be passed to
+/// @c update() and the query functions. Buckets cache their extreme values so queries
+/// need only decode the unaligned samples at either end of a range.
+class PlotLevelOfDetail
+{
+public:
+  /// Pyramid dimensions.
+  enum
+  {
+    BaseBucketShift = 5,                    ///< Log2 of @c BaseBucketSize.
+    BaseBucketSize = 1 << BaseBucketShift,  ///< Samples per bucket at the first level.
+    LevelShift = 2,                         ///< Log2 of @c LevelFactor.
+    LevelFactor = 1 << LevelShift           ///< Buckets per bucket in the next level.
+  };
+
+  /// Constructor.
+  PlotLevelOfDetail();
+
+  /// Clears the pyramid.
+  void clear();
+
+  /// Update the pyramid to cover @p count samples.
+  ///
+  /// Samples already covered must be unchanged; only appended samples are processed.
+  /// The pyramid is rebuilt if @p count is less than the current @c sampleCount().
+  ///
+  /// @param x The sample X values.
+  /// @param y The sample Y values.
+  /// @param count The number of elements in @p x and @p y.
+  void update(const double *x, const PlotSampleColumn &y, size_t count);
+
+  /// Query the indices of the minimum and maximum Y values in the inclusive range
+  /// [@p from, @p to].
+  /// @param y The sample Y values given to @c update().
+  /// @param from The first sample index. Must be less than @c sampleCount().
+  /// @param to The last sample index. Must be less than @c sampleCount() and not less than @p from.
+  /// @param[out] minIndex Set to the index of the minimum value.
+  /// @param[out] maxIndex Set to the index of the maximum value.
+  void minMax(const PlotSampleColumn &y, size_t from, size_t to, size_t &minIndex, size_t &maxIndex) const;
+
+  /// Query the number of samples covered by the pyramid.
+  /// @return The sample count.
+  inline size_t sampleCount() const { return _sampleCount; }
+
+  /// Are the sample X values monotonic, non-decreasing? NaN values are unordered, so
+  /// break monotonicity.
+  /// @return True if X is monotonic.
+  inline bool xMonotonic() const { return _xMonotonic; }
+
+  /// Are the sample Y values monotonic, non-decreasing? As for @c xMonotonic(), NaN
+  /// values break monotonicity.
+  ///
+  /// Used to check time column curves.
+  ///
+  /// @return True if Y is monotonic.
+  inline bool yMonotonic() const { return _yMonotonic; }
+
+private:
+  /// A pyramid bucket.
+  struct Bucket
+  {
+    size_t minIndex;  ///< Index of the minimum sample.
+    size_t maxIndex;  ///< Index of the maximum sample.
+    double minValue;  ///< The minimum sample value.
+    double maxValue;  ///< The maximum sample value.
+  };
+
+  /// Fold a sample into @p bucket.
+  /// @param bucket The bucket to update.
+  /// @param value The sample Y value.
+  /// @param index The sample index.
+  static void addSample(Bucket &bucket, double value, size_t index);
+
+  /// Fold @p other into @p bucket.
+  /// @param bucket The bucket to update.
+  /// @param other The bucket to add.
+  static void addBucket(Bucket &bucket, const Bucket &other);
+
+  std::vector<std::vector<Bucket>> _levels; ///< Pyramid levels. Level zero is the finest.
+  size_t _sampleCount;  ///< Number of samples covered.
+  bool _xMonotonic;     ///< X values are non-decreasing?
+  bool _yMonotonic;     ///< Y values are non-decreasing?
+};
+
+#endif // PLOTLEVELOFDETAIL_H_
@@ -0,0 +1,115 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "plotresampler.h"
+
+#include "plotinstancesampler.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace
+{
+  const char *PolicyNames[] =
+  {
+    "linear",
+    "hold",
+    "nearest",
+    "noextrapolate"
+  };
+
+  /// A merge cursor: the next time from a sampler and the sampler index.
+  typedef std::pair<double, size_t> MergeCursor;
+}
+
+
+const char *PlotResampler::policyName(Policy policy)
+{
+  return PolicyNames[policy];
+}
+
+
+bool PlotResampler::policyFromName(const QString &name, Policy &policy)
+{
+  for (int i = Linear; i <= NoExtrapolate; ++i)
+  {
+    if (name.compare(PolicyNames[i], Qt::CaseInsensitive) == 0)
+    {
+      policy = Policy(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void PlotResampler::mergeTimes(const PlotInstanceSampler *const *samplers, size_t count,
+                               double minTime, double maxTime, std::vector<double> &times)
+{
+  times.clear();
+
+  // Start each sampler at its first time not less than minTime.
+  std::vector<size_t> cursors(count, 0u);
+  std::vector<size_t> sizes(count, 0u);
+  std::priority_queue<MergeCursor, std::vector<MergeCursor>, std::greater<MergeCursor>> heap;
+  size_t total = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const PlotInstanceSampler *sampler = samplers[i];
+    if (!sampler || !sampler->curve())
+    {
+      continue;
+    }
+
+    sizes[i] = sampler->timeOrderedCount();
+    size_t from = 0;
+    size_t to = sizes[i];
+    while (from < to)
+    {
+      const size_t mid = from + (to - from) / 2;
+      if (sampler->timeOrderedTime(mid) < minTime)
+      {
+        from = mid + 1;
+      }
+      else
+      {
+        to = mid;
+      }
+    }
+
+    cursors[i] = from;
+    total += sizes[i] - from;
+    if (from < sizes[i])
+    {
+      heap.push(MergeCursor(sampler->timeOrderedTime(from), i));
+    }
+  }
+
+  times.reserve(total);
+  while (!heap.empty())
+  {
+    const MergeCursor next = heap.top();
+    heap.pop();
+
+    if (next.first > maxTime)
+    {
+      // All remaining times are later still for this sampler.
+      continue;
+    }
+
+    if (times.empty() || times.back() < next.first)
+    {
+      times.push_back(next.first);
+    }
+
+    const size_t i = next.second;
+    if (++cursors[i] < sizes[i])
+    {
+      heap.push(MergeCursor(samplers[i]->timeOrderedTime(cursors[i]), i));
+    }
+  }
+}
@@ -0,0 +1,65 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef PLOTRESAMPLER_H_
+#define PLOTRESAMPLER_H_
+
+#include "plotsconfig.h"
+
+#include <QString>
+
+#include <vector>
+
+class PlotInstanceSampler;
+
+/// @ingroup plot
+/// Supports aligning curves with different time bases when evaluating expressions.
+///
+/// A curve is sampled at times other than its own sample times according to a @c Policy.
+/// See @c PlotInstanceSampler::interpolate().
+///
+/// Alternatively, the time bases may be combined using @c mergeTimes(), so that each curve
+/// is sampled at the union of the native sample times of all curves. This is a k-way
+/// merge of the time ordered samples, performed in a single pass.
+class PlotResampler
+{
+public:
+  /// Policies for sampling a curve between its sample times.
+  enum Policy
+  {
+    Linear,         ///< Linear interpolation. Zero outside the curve time range.
+    Hold,           ///< Zero order hold of the preceding sample. Zero outside the curve time range.
+    Nearest,        ///< The nearest sample. Zero outside the curve time range.
+    NoExtrapolate   ///< Linear interpolation. NaN outside the curve time range.
+  };
+
+  /// Get the name of a resampling @c Policy: "linear", "hold", "nearest" or "noextrapolate".
+  /// @param policy The policy of interest.
+  /// @return The policy name.
+  static const char *policyName(Policy policy);
+
+  /// Convert a name from @c policyName() to a @c Policy. Case insensitive.
+  /// @param name The name to convert.
+  /// @param[out] policy Set to the matching policy on success.
+  /// @return True if @p name is recognised.
+  static bool policyFromName(const QString &name, Policy &policy);
+
+  /// Merges the sample times of several curves into a single, ascending time base.
+  ///
+  /// Each sampler is walked in time order, using the time index maintained for
+  /// @c PlotInstanceSampler::interpolate(). The results are merged using a heap over the
+  /// @p samplers, so the cost is O(N log K) for N samples from K curves. Duplicate times
+  /// are merged and times outside [@p minTime, @p maxTime] are excluded.
+  ///
+  /// @param samplers The curves to merge the times of. Null entries are ignored.
+  /// @param count The number of @p samplers.
+  /// @param minTime The minimum time to include.
+  /// @param maxTime The maximum time to include.
+  /// @param[out] times Set to the merged times.
+  static void mergeTimes(const PlotInstanceSampler *const *samplers, size_t count,
+                         double minTime, double maxTime, std::vector<double> &times);
+};
+
+#endif // PLOTRESAMPLER_H_
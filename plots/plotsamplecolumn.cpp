@@ -0,0 +1,611 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#include "plotsamplecolumn.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+  /// Marks the absence of an @c XorDelta window: at the start of a block.
+  const unsigned NoWindow = 64u;
+
+  const char *EncodingNames[] =
+  {
+    "double",
+    "float32",
+    "int16",
+    "int32",
+    "xor"
+  };
+
+  inline bool isNaN(double value)
+  {
+    return value != value;
+  }
+
+
+  inline std::uint64_t toBits(double value)
+  {
+    std::uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+  }
+
+
+  inline double fromBits(std::uint64_t bits)
+  {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+
+  /// Count leading zero bits. @p bits must not be zero.
+  inline unsigned leadingZeros(std::uint64_t bits)
+  {
+#ifdef __GNUC__
+    return unsigned(__builtin_clzll(bits));
+#else  // __GNUC__
+    unsigned count = 0;
+    while (!(bits & (std::uint64_t(1) << 63)))
+    {
+      bits <<= 1;
+      ++count;
+    }
+    return count;
+#endif // __GNUC__
+  }
+
+
+  /// Count trailing zero bits. @p bits must not be zero.
+  inline unsigned trailingZeros(std::uint64_t bits)
+  {
+#ifdef __GNUC__
+    return unsigned(__builtin_ctzll(bits));
+#else  // __GNUC__
+    unsigned count = 0;
+    while (!(bits & 1u))
+    {
+      bits >>= 1;
+      ++count;
+    }
+    return count;
+#endif // __GNUC__
+  }
+
+
+  inline std::uint64_t lowBits(unsigned n)
+  {
+    return (n < 64) ? (std::uint64_t(1) << n) - 1u : ~std::uint64_t(0);
+  }
+}
+
+
+const char *PlotSampleEncoding::typeName(Type type)
+{
+  return EncodingNames[type];
+}
+
+
+bool PlotSampleEncoding::typeFromName(const QString &name, Type &type)
+{
+  for (int i = Double; i <= XorDelta; ++i)
+  {
+    if (name.compare(EncodingNames[i], Qt::CaseInsensitive) == 0)
+    {
+      type = Type(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+PlotSampleColumn::Cursor::Cursor()
+  : _column(nullptr)
+  , _columnSize(0)
+  , _blockStart(0)
+  , _blockCount(0)
+{
+}
+
+
+double PlotSampleColumn::Cursor::value(const PlotSampleColumn &column, size_t index)
+{
+  if (column.writable())
+  {
+    return column.value(index);
+  }
+
+  if (_column != &column || _columnSize != column.size() ||
+      index < _blockStart || index >= _blockStart + _blockCount)
+  {
+    _column = &column;
+    _columnSize = column.size();
+    _blockStart = index - index % XorBlockSize;
+    _blockCount = std::min<size_t>(XorBlockSize, column.size() - _blockStart);
+    column.decodeBlock(_blockStart / XorBlockSize, _blockCount, _block);
+  }
+
+  return _block[index - _blockStart];
+}
+
+
+void PlotSampleColumn::Cursor::invalidate()
+{
+  _column = nullptr;
+  _blockCount = 0;
+}
+
+
+PlotSampleColumn::PlotSampleColumn(const PlotSampleEncoding &encoding)
+  : _encoding(encoding)
+  , _size(0)
+  , _capacity(0)
+  , _bitCount(0)
+  , _previous(0)
+  , _leading(NoWindow)
+  , _trailing(0)
+{
+}
+
+
+PlotSampleColumn::PlotSampleColumn(const PlotSampleColumn &other)
+  : _size(0)
+  , _capacity(0)
+  , _bitCount(0)
+  , _previous(0)
+  , _leading(NoWindow)
+  , _trailing(0)
+{
+  *this = other;
+}
+
+
+PlotSampleColumn &PlotSampleColumn::operator=(const PlotSampleColumn &other)
+{
+  if (this != &other)
+  {
+    _encoding = other._encoding;
+    _size = other._size;
+    _capacity = 0;
+    // Assignment need not preserve vector capacity, so reserve explicitly.
+    _doubles.clear();
+    _floats.clear();
+    _int16.clear();
+    _int32.clear();
+    reserve(other._capacity);
+    _doubles.insert(_doubles.end(), other._doubles.begin(), other._doubles.end());
+    _floats.insert(_floats.end(), other._floats.begin(), other._floats.end());
+    _int16.insert(_int16.end(), other._int16.begin(), other._int16.end());
+    _int32.insert(_int32.end(), other._int32.begin(), other._int32.end());
+    _bits = other._bits;
+    _blocks = other._blocks;
+    _bitCount = other._bitCount;
+    _previous = other._previous;
+    _leading = other._leading;
+    _trailing = other._trailing;
+  }
+  return *this;
+}
+
+
+void PlotSampleColumn::setEncoding(const PlotSampleEncoding &encoding)
+{
+  std::vector<double> values(_size);
+  decode(0, _size, values.data());
+  const size_t capacity = _capacity;
+  release();
+  _encoding = encoding;
+  reserve(capacity);
+  append(values.data(), values.size());
+}
+
+
+size_t PlotSampleColumn::byteSize() const
+{
+  return _doubles.capacity() * sizeof(double) + _floats.capacity() * sizeof(float) +
+         _int16.capacity() * sizeof(std::int16_t) + _int32.capacity() * sizeof(std::int32_t) +
+         _bits.capacity() * sizeof(std::uint64_t) + _blocks.capacity() * sizeof(size_t);
+}
+
+
+void PlotSampleColumn::reserve(size_t count)
+{
+  if (count <= _capacity)
+  {
+    return;
+  }
+
+  _capacity = count;
+  switch (_encoding.type)
+  {
+  case PlotSampleEncoding::Double:
+    _doubles.reserve(count);
+    break;
+  case PlotSampleEncoding::Float32:
+    _floats.reserve(count);
+    break;
+  case PlotSampleEncoding::Int16:
+    _int16.reserve(count);
+    break;
+  case PlotSampleEncoding::Int32:
+    _int32.reserve(count);
+    break;
+  case PlotSampleEncoding::XorDelta:
+    // Size unknown. Reserve the block index only.
+    _blocks.reserve((count + XorBlockSize - 1) / XorBlockSize);
+    break;
+  }
+}
+
+
+void PlotSampleColumn::resize(size_t count)
+{
+  if (count > _size)
+  {
+    const std::vector<double> zeros(count - _size, 0.0);
+    append(zeros.data(), zeros.size());
+    return;
+  }
+
+  if (count == _size)
+  {
+    return;
+  }
+
+  if (_encoding.type == PlotSampleEncoding::XorDelta)
+  {
+    // Re-encode the retained values to restore the stream state.
+    std::vector<double> values(count);
+    decode(0, count, values.data());
+    clear();
+    append(values.data(), values.size());
+    return;
+  }
+
+  _doubles.resize(std::min(_doubles.size(), count));
+  _floats.resize(std::min(_floats.size(), count));
+  _int16.resize(std::min(_int16.size(), count));
+  _int32.resize(std::min(_int32.size(), count));
+  _size = count;
+}
+
+
+void PlotSampleColumn::clear()
+{
+  _doubles.clear();
+  _floats.clear();
+  _int16.clear();
+  _int32.clear();
+  _bits.clear();
+  _blocks.clear();
+  _bitCount = 0;
+  _previous = 0;
+  _leading = NoWindow;
+  _trailing = 0;
+  _size = 0;
+}
+
+
+void PlotSampleColumn::release()
+{
+  clear();
+  std::vector<double>().swap(_doubles);
+  std::vector<float>().swap(_floats);
+  std::vector<std::int16_t>().swap(_int16);
+  std::vector<std::int32_t>().swap(_int32);
+  std::vector<std::uint64_t>().swap(_bits);
+  std::vector<size_t>().swap(_blocks);
+  _capacity = 0;
+}
+
+
+void PlotSampleColumn::append(const double *values, size_t count)
+{
+  switch (_encoding.type)
+  {
+  case PlotSampleEncoding::Double:
+    _doubles.insert(_doubles.end(), values, values + count);
+    break;
+  case PlotSampleEncoding::Float32:
+    for (size_t i = 0; i < count; ++i)
+    {
+      _floats.push_back(float(values[i]));
+    }
+    break;
+  case PlotSampleEncoding::Int16:
+    for (size_t i = 0; i < count; ++i)
+    {
+      _int16.push_back(std::int16_t(quantise(values[i], std::numeric_limits<std::int16_t>::min(),
+                                             std::numeric_limits<std::int16_t>::max())));
+    }
+    break;
+  case PlotSampleEncoding::Int32:
+    for (size_t i = 0; i < count; ++i)
+    {
+      _int32.push_back(quantise(values[i], std::numeric_limits<std::int32_t>::min(),
+                                std::numeric_limits<std::int32_t>::max()));
+    }
+    break;
+  case PlotSampleEncoding::XorDelta:
+    for (size_t i = 0; i < count; ++i)
+    {
+      appendXor(values[i]);
+    }
+    // appendXor() maintains the size.
+    count = 0;
+    break;
+  }
+
+  _size += count;
+  _capacity = std::max(_capacity, _size);
+}
+
+
+void PlotSampleColumn::write(size_t at, const double *values, size_t count)
+{
+  switch (_encoding.type)
+  {
+  case PlotSampleEncoding::Double:
+    memcpy(_doubles.data() + at, values, sizeof(*values) * count);
+    break;
+  case PlotSampleEncoding::Float32:
+    for (size_t i = 0; i < count; ++i)
+    {
+      _floats[at + i] = float(values[i]);
+    }
+    break;
+  case PlotSampleEncoding::Int16:
+    for (size_t i = 0; i < count; ++i)
+    {
+      _int16[at + i] = std::int16_t(quantise(values[i], std::numeric_limits<std::int16_t>::min(),
+                                             std::numeric_limits<std::int16_t>::max()));
+    }
+    break;
+  case PlotSampleEncoding::Int32:
+    for (size_t i = 0; i < count; ++i)
+    {
+      _int32[at + i] = quantise(values[i], std::numeric_limits<std::int32_t>::min(),
+                                std::numeric_limits<std::int32_t>::max());
+    }
+    break;
+  case PlotSampleEncoding::XorDelta:
+    // Not supported.
+    break;
+  }
+}
+
+
+double PlotSampleColumn::value(size_t index) const
+{
+  switch (_encoding.type)
+  {
+  case PlotSampleEncoding::Double:
+    return _doubles[index];
+  case PlotSampleEncoding::Float32:
+    return _floats[index];
+  case PlotSampleEncoding::Int16:
+    return dequantise(_int16[index], std::numeric_limits<std::int16_t>::min());
+  case PlotSampleEncoding::Int32:
+    return dequantise(_int32[index], std::numeric_limits<std::int32_t>::min());
+  case PlotSampleEncoding::XorDelta:
+  {
+    double block[XorBlockSize];
+    const size_t offset = index % XorBlockSize;
+    decodeBlock(index / XorBlockSize, offset + 1, block);
+    return block[offset];
+  }
+  }
+
+  return 0;
+}
+
+
+void PlotSampleColumn::decode(size_t from, size_t count, double *out) const
+{
+  switch (_encoding.type)
+  {
+  case PlotSampleEncoding::Double:
+    memcpy(out, _doubles.data() + from, sizeof(*out) * count);
+    break;
+  case PlotSampleEncoding::XorDelta:
+  {
+    double block[XorBlockSize];
+    const size_t end = from + count;
+    size_t index = from;
+    while (index < end)
+    {
+      const size_t blockStart = index - index % XorBlockSize;
+      const size_t blockEnd = std::min<size_t>(blockStart + XorBlockSize, end);
+      decodeBlock(blockStart / XorBlockSize, blockEnd - blockStart, block);
+      memcpy(out, block + (index - blockStart), sizeof(*out) * (blockEnd - index));
+      out += blockEnd - index;
+      index = blockEnd;
+    }
+    break;
+  }
+  default:
+    for (size_t i = 0; i < count; ++i)
+    {
+      out[i] = value(from + i);
+    }
+    break;
+  }
+}
+
+
+bool PlotSampleColumn::range(size_t from, size_t count, double &min, double &max) const
+{
+  bool haveValue = false;
+  auto fold = [&min, &max, &haveValue] (const double *values, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double v = values[i];
+      if (!isNaN(v))
+      {
+        min = (!haveValue || v < min) ? v : min;
+        max = (!haveValue || v > max) ? v : max;
+        haveValue = true;
+      }
+    }
+  };
+
+  if (const double *values = doubleData())
+  {
+    fold(values + from, count);
+    return haveValue;
+  }
+
+  double block[XorBlockSize];
+  for (size_t i = 0; i < count; i += XorBlockSize)
+  {
+    const size_t n = std::min<size_t>(XorBlockSize, count - i);
+    decode(from + i, n, block);
+    fold(block, n);
+  }
+  return haveValue;
+}
+
+
+void PlotSampleColumn::decodeBlock(size_t block, size_t count, double *out) const
+{
+  size_t pos = _blocks[block];
+  std::uint64_t previous = readBits(pos, 64);
+  unsigned leading = 0, meaningful = 0;
+  out[0] = fromBits(previous);
+
+  for (size_t i = 1; i < count; ++i)
+  {
+    if (readBits(pos, 1))
+    {
+      if (readBits(pos, 1))
+      {
+        // New window.
+        leading = unsigned(readBits(pos, 6));
+        meaningful = unsigned(readBits(pos, 6)) + 1;
+      }
+      const unsigned trailing = 64 - leading - meaningful;
+      previous ^= readBits(pos, meaningful) << trailing;
+    }
+    // else repeated value.
+    out[i] = fromBits(previous);
+  }
+}
+
+
+void PlotSampleColumn::appendXor(double value)
+{
+  const std::uint64_t bits = toBits(value);
+  if (_size % XorBlockSize == 0)
+  {
+    // Start a new block with the raw value.
+    _blocks.push_back(_bitCount);
+    writeBits(bits, 64);
+    _previous = bits;
+    _leading = NoWindow;
+    ++_size;
+    return;
+  }
+
+  const std::uint64_t delta = bits ^ _previous;
+  _previous = bits;
+  ++_size;
+  if (!delta)
+  {
+    writeBits(0, 1);
+    return;
+  }
+
+  const unsigned leading = leadingZeros(delta);
+  const unsigned trailing = trailingZeros(delta);
+  if (_leading != NoWindow && leading >= _leading && trailing >= _trailing)
+  {
+    // Fits the current window.
+    const unsigned meaningful = 64 - _leading - _trailing;
+    writeBits(1, 1);
+    writeBits(0, 1);
+    writeBits(delta >> _trailing, meaningful);
+  }
+  else
+  {
+    // New window.
+    const unsigned meaningful = 64 - leading - trailing;
+    writeBits(1, 1);
+    writeBits(1, 1);
+    writeBits(leading, 6);
+    writeBits(meaningful - 1, 6);
+    writeBits(delta >> trailing, meaningful);
+    _leading = leading;
+    _trailing = trailing;
+  }
+}
+
+
+void PlotSampleColumn::writeBits(std::uint64_t bits, unsigned n)
+{
+  bits &= lowBits(n);
+  const size_t word = _bitCount >> 6;
+  const unsigned shift = unsigned(_bitCount & 63u);
+  if (word >= _bits.size())
+  {
+    _bits.push_back(0);
+  }
+  _bits[word] |= bits << shift;
+  if (shift + n > 64)
+  {
+    _bits.push_back(bits >> (64 - shift));
+  }
+  _bitCount += n;
+}
+
+
+std::uint64_t PlotSampleColumn::readBits(size_t &pos, unsigned n) const
+{
+  const size_t word = pos >> 6;
+  const unsigned shift = unsigned(pos & 63u);
+  std::uint64_t bits = _bits[word] >> shift;
+  if (shift + n > 64)
+  {
+    bits |= _bits[word + 1] << (64 - shift);
+  }
+  pos += n;
+  return bits & lowBits(n);
+}
+
+
+std::int32_t PlotSampleColumn::quantise(double value, std::int32_t minValue, std::int32_t maxValue) const
+{
+  if (isNaN(value))
+  {
+    return minValue;
+  }
+
+  const double q = std::floor((value - _encoding.offset) / _encoding.scale + 0.5);
+  if (!(q > minValue))
+  {
+    return minValue + 1;
+  }
+  if (q > maxValue)
+  {
+    return maxValue;
+  }
+  return std::int32_t(q);
+}
+
+
+double PlotSampleColumn::dequantise(std::int32_t value, std::int32_t nanValue) const
+{
+  if (value == nanValue)
+  {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  return value * _encoding.scale + _encoding.offset;
+}
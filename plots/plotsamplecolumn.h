@@ -0,0 +1,239 @@
+//
+// author Kazys Stepanas
+//
+// Copyright (c) CSIRO 2015
+//
+#ifndef PLOTSAMPLECOLUMN_H_
+#define PLOTSAMPLECOLUMN_H_
+
+#include "plotsconfig.h"
+
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @ingroup plot
+/// Identifies how a @c PlotSampleColumn stores its values.
+///
+/// All encodings other than @c Double are lossy:
+/// - @c Float32 stores single precision values (4 bytes).
+/// - @c Int16 and @c Int32 store values quantised as <tt>(value - offset) / scale</tt>
+///   (2 or 4 bytes). Values are clamped to the integer range, while NaN values are
+///   preserved.
+/// - @c XorDelta compresses double precision values in blocks, storing each value as the
+///   XOR of the previous value using the Gorilla time series encoding. This is lossless
+///   and suits slowly varying signals, often requiring only a few bits per sample, but
+///   is append only and must be decoded block by block.
+struct PlotSampleEncoding
+{
+  /// Available encodings.
+  enum Type
+  {
+    Double,   ///< Double precision values. No encoding.
+    Float32,  ///< Single precision values.
+    Int16,    ///< Scaled 16-bit integer values.
+    Int32,    ///< Scaled 32-bit integer values.
+    XorDelta  ///< XOR delta compressed double precision values.
+  };
+
+  Type type;      ///< The encoding type.
+  double scale;   ///< Quantisation step for @c Int16 and @c Int32. Must not be zero.
+  double offset;  ///< Value offset for @c Int16 and @c Int32.
+
+  /// Constructor.
+  /// @param type The encoding type.
+  /// @param scale Quantisation step for integer types.
+  /// @param offset Value offset for integer types.
+  inline PlotSampleEncoding(Type type = Double, double scale = 1.0, double offset = 0.0)
+    : type(type), scale(scale), offset(offset) {}
+
+  /// Get the name of an encoding @c Type: "double", "float32", "int16", "int32" or "xor".
+  /// @param type The type of interest.
+  /// @return The type name.
+  static const char *typeName(Type type);
+
+  /// Convert a name from @c typeName() to a @c Type. Case insensitive.
+  /// @param name The name to convert.
+  /// @param[out] type Set to the matching type on success.
+  /// @return True if @p name is recognised.
+  static bool typeFromName(const QString &name, Type &type);
+};
+
+
+/// @ingroup plot
+/// A column of sample values stored with a @c PlotSampleEncoding.
+///
+/// Values are appended via @c append() and may be overwritten via @c write(), except
+/// with @c PlotSampleEncoding::XorDelta, which is append only. Values are decoded on
+/// access. Random access via @c value() is constant time, except for @c XorDelta,
+/// which decodes from the start of the block. Sequential access should use a @c Cursor,
+/// or @c decode() a range at once.
+///
+/// The column supports a logical @c capacity() for use as a ring buffer. The capacity
+/// is preserved on copy.
+class PlotSampleColumn
+{
+public:
+  /// Number of values in each compressed @c XorDelta block.
+  enum { XorBlockSize = 64 };
+
+  /// Caches a decoded block for sequential access to a column. A cursor is not
+  /// thread safe, but many cursors may read the same column concurrently.
+  class Cursor
+  {
+  public:
+    /// Constructor.
+    Cursor();
+
+    /// Fetch the value at @p index from @p column. Decoded blocks are cached until
+    /// the column or its size changes.
+    /// @param column The column to read.
+    /// @param index The value index. Must be in range.
+    /// @return The value.
+    double value(const PlotSampleColumn &column, size_t index);
+
+    /// Invalidate any cached block.
+    void invalidate();
+
+  private:
+    const PlotSampleColumn *_column;    ///< The column the block was decoded from.
+    size_t _columnSize;                 ///< The column size when the block was decoded.
+    size_t _blockStart;                 ///< Index of the first value in the cached block.
+    size_t _blockCount;                 ///< Number of cached values.
+    double _block[XorBlockSize];        ///< Cached values.
+  };
+
+  /// Constructor.
+  /// @param encoding The value encoding.
+  PlotSampleColumn(const PlotSampleEncoding &encoding = PlotSampleEncoding());
+
+  /// Copy constructor, preserving the capacity.
+  /// @param other The column to copy.
+  PlotSampleColumn(const PlotSampleColumn &other);
+
+  /// Assignment, preserving the capacity of @p other.
+  /// @param other The column to copy.
+  /// @return This column.
+  PlotSampleColumn &operator=(const PlotSampleColumn &other);
+
+  /// Access the encoding.
+  /// @return The current encoding.
+  inline const PlotSampleEncoding &encoding() const { return _encoding; }
+
+  /// Change the encoding, converting the existing values.
+  /// @param encoding The new encoding.
+  void setEncoding(const PlotSampleEncoding &encoding);
+
+  /// Can values be overwritten via @c write()?
+  /// @return True unless using @c PlotSampleEncoding::XorDelta.
+  inline bool writable() const { return _encoding.type != PlotSampleEncoding::XorDelta; }
+
+  /// Query the number of values.
+  /// @return The value count.
+  inline size_t size() const { return _size; }
+
+  /// Is the column empty?
+  /// @return True if there are no values.
+  inline bool empty() const { return _size == 0; }
+
+  /// Query the logical capacity as set by @c reserve().
+  /// @return The capacity.
+  inline size_t capacity() const { return _capacity; }
+
+  /// Query the memory used to store the values.
+  /// @return The storage size in bytes.
+  size_t byteSize() const;
+
+  /// Direct access to the values with @c PlotSampleEncoding::Double.
+  /// @return The contiguous values, or null for any other encoding.
+  inline const double *doubleData() const
+  {
+    return (_encoding.type == PlotSampleEncoding::Double) ? _doubles.data() : nullptr;
+  }
+
+  /// Reserve storage for @p count values.
+  /// @param count The number of values to reserve.
+  void reserve(size_t count);
+
+  /// Resize the column, adding zero values or truncating.
+  /// @param count The new size.
+  void resize(size_t count);
+
+  /// Remove all values, retaining the encoding and capacity.
+  void clear();
+
+  /// Remove all values and release memory, including the capacity.
+  void release();
+
+  /// Append values.
+  /// @param values The values to append.
+  /// @param count The number of @p values.
+  void append(const double *values, size_t count);
+
+  /// Overwrite existing values in [@p at, @p at + @p count). Requires @c writable().
+  /// @param at The first index to write.
+  /// @param values The values to write.
+  /// @param count The number of @p values. The range must lie within @c size().
+  void write(size_t at, const double *values, size_t count);
+
+  /// Decode the value at @p index.
+  /// @param index The value index. Must be in range.
+  /// @return The value.
+  double value(size_t index) const;
+
+  /// Decode values in [@p from, @p from + @p count) into @p out.
+  /// @param from The first index.
+  /// @param count The number of values. The range must lie within @c size().
+  /// @param[out] out Array to decode into.
+  void decode(size_t from, size_t count, double *out) const;
+
+  /// Find the range of values in [@p from, @p from + @p count), ignoring NaN values.
+  /// @param from The first index.
+  /// @param count The number of values. The range must lie within @c size().
+  /// @param[out] min Set to the minimum value.
+  /// @param[out] max Set to the maximum value.
+  /// @return True if there is a non-NaN value in the range.
+  bool range(size_t from, size_t count, double &min, double &max) const;
+
+private:
+  /// Decode the first @p count values of @c XorDelta block @p block.
+  /// @param block The block index.
+  /// @param count The number of values to decode: [1, @c XorBlockSize].
+  /// @param[out] out Array to decode into.
+  void decodeBlock(size_t block, size_t count, double *out) const;
+
+  /// Append a single value to the @c XorDelta stream, incrementing the size.
+  /// @param value The value to append.
+  void appendXor(double value);
+
+  /// Append @p n bits of @p bits to the @c XorDelta stream.
+  void writeBits(std::uint64_t bits, unsigned n);
+
+  /// Read @p n bits from the @c XorDelta stream at @p pos, advancing @p pos.
+  std::uint64_t readBits(size_t &pos, unsigned n) const;
+
+  /// Quantise @p value for an integer encoding in [@p minValue, @p maxValue].
+  /// The @p minValue is reserved for NaN.
+  std::int32_t quantise(double value, std::int32_t minValue, std::int32_t maxValue) const;
+
+  /// Convert a quantised value back to a double.
+  double dequantise(std::int32_t value, std::int32_t nanValue) const;
+
+  PlotSampleEncoding _encoding;     ///< The encoding.
+  size_t _size;                     ///< Number of values.
+  size_t _capacity;                 ///< Logical capacity.
+  std::vector<double> _doubles;     ///< @c Double storage.
+  std::vector<float> _floats;       ///< @c Float32 storage.
+  std::vector<std::int16_t> _int16; ///< @c Int16 storage.
+  std::vector<std::int32_t> _int32; ///< @c Int32 storage.
+  std::vector<std::uint64_t> _bits; ///< @c XorDelta bit stream.
+  std::vector<size_t> _blocks;      ///< Bit offset of each @c XorDelta block.
+  size_t _bitCount;                 ///< Number of bits used in @c _bits.
+  std::uint64_t _previous;          ///< Bits of the last @c XorDelta value.
+  unsigned _leading;                ///< Leading zeros in the current @c XorDelta window.
+  unsigned _trailing;               ///< Trailing zeros in the current @c XorDelta window.
+};
+
+#endif // PLOTSAMPLECOLUMN_H_
@@ -53,9 +53,9 @@ double PlotSource::firstTime() const
 {
   if (const PlotInstance *curve = timeColumnCurve())
   {
-    if (!curve->data().empty())
+    if (curve->sampleCount())
     {
-      return curve->data()[0].y();
+      return curve->values().value(0);
     }
   }
 
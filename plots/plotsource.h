@@ -8,6 +8,7 @@
 
 #include "plotsconfig.h"
 
+#include "plotsamplecolumn.h"
 #include "refcountobject.h"
 #include "refcountptr.h"
 
@@ -117,6 +118,15 @@ public:
   /// @param time The base time (origin).
   inline void setTimeBase(double time) { _timeBase = time; }
 
+  /// Query the default value encoding for curves created from this source.
+  /// @return The sample encoding.
+  inline const PlotSampleEncoding &sampleEncoding() const { return _sampleEncoding; }
+
+  /// Set the default value encoding for curves subsequently created from this source.
+  /// Existing curves are unaffected.
+  /// @param encoding The new encoding.
+  inline void setSampleEncoding(const PlotSampleEncoding &encoding) { _sampleEncoding = encoding; }
+
   /// Request the first time value from the time column.
   /// @return The first value in the time column. Zero with no such column.
   double firstTime() const;
@@ -180,6 +190,7 @@ private:
   unsigned _timeColumn; ///< Time column 1-based index.
   double _timeScale;    ///< Time scale multiplier (after @c _timeBase shift)
   double _timeBase;     ///< Considered time zero (before scaling).
+  PlotSampleEncoding _sampleEncoding; ///< Default encoding for new curves.
   QMutex *_curvesMutex; ///< To support expression generation modifying @c _curves.
   QVector<PlotInstance *> _curves;  ///< Curve list.
 };
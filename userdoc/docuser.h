@@ -169,6 +169,13 @@ image can then be paste into another program, such as an image editing program,
 A legend is present in the clipboard image only when the plot view legend is position is other than
 "shared".
 
+## Background Rendering ## {#ubackgroundrender}
+Drawing very large data sets can make the user interface slow to respond. The "View->Background
+Rendering" menu item draws the curves in each view on background threads instead. The view continues
+to show the last completed image while a new image is drawn. While zooming or panning, the last image
+is stretched to match the new view until the new image is ready. Copying a view to the clipboard
+always draws the curves directly.
+
 # Toolbar # {#utoolbar}
 The toolbar contains tools and controls affecting how data files are loaded and tools which control
 interaction with the plot view. This includes [time scaling] (#utimescale) and
@@ -340,7 +347,11 @@ transmission begin and end.
 Open Curves maintains a fixed size ring buffer for incoming data samples. The plot is periodically
 redrawn as new data arrive and are added to the ring buffer.
 
-Expressions are not supported with real time data.
+Expressions referencing real time data are evaluated as new data arrive. Each new sample of the
+first real time curve referenced by an expression yields a new sample of the expression curve, with
+other curves sampled at the same time. Only the new samples are evaluated, so functions such as
+@c mavg() continue from the previous update. Expression curves use the same ring buffer size as the
+real time curve and stop updating when the connection closes.
 
 - @subpage urtformat
 - @subpage urtex
@@ -572,6 +583,18 @@ the time column, time base and time scale. @ref xslicing expressions in particul
 time domain and must be recalculated if the time column, base or scale for the referenced curve
 changes.
 
+The expression is sampled at regular intervals across its domain, using the smallest average
+sample interval of the referenced curves. Curves are sampled between their sample times by linear
+interpolation and are zero outside their domain. The behaviour is configured by the following
+settings in the [load] section of the configuration file (see the README):
+- @c resample selects how curves are sampled between their sample times: "linear" interpolation,
+  "hold" the previous sample, take the "nearest" sample or "noextrapolate". The latter interpolates
+  linearly and yields NaN outside the curve domain, so combining curves covering different periods
+  leaves gaps rather than mixing in zeros.
+- @c nativeTimes set to "true" samples an expression at the union of the sample times of its
+  referenced curves rather than at regular intervals. Each input sample then appears in the result,
+  which better suits combining curves recorded at different rates.
+
 
 # Plot References # {#xplotreferences}
 Plot references are matched by name, with optional single or double quotes surrounding the plot
@@ -607,6 +630,26 @@ of expressions. From the previous example, we use @c S and add a new set
 the maximum sample of @c S and @c U and the constant 3 at each sample time:
 <tt>{ 5, 4, 3, 5, 4, 8, 6, 3, 3 }</tt>.
 
+The moving window functions - @c mavg, @c tmavg, @c mmin, @c mmax, @c mstddev and @c mmedian -
+evaluate a statistic over a window of recent samples. The @c window argument specifies the number
+of previous samples to include, or a duration in seconds when the optional @c bytime argument is
+non-zero. For example, <tt>mmax('S', 2)</tt> yields the maximum of each sample and the two before it:
+<tt>{ -1, 0, 2, 5, 5, 6, 6, 6, 3 }</tt>. The time weighted average @c tmavg windows by time unless
+@c bytime is zero, and weights each sample by the time between samples. This is better suited to
+irregularly sampled data.
+
+The spectral functions @c fft_mag and @c psd transform a curve into its frequency spectrum. The
+resulting curve plots frequency in Hertz along the X axis, from zero to half the sample rate. The
+sample rate is taken from the average time between samples of the referenced curve.
+- <tt>fft_mag(x,n=0,window=1)</tt> yields the amplitude spectrum of the first @c n samples of @c x,
+  or of all samples when @c n is zero. A sine wave in @c x yields a peak of its amplitude.
+- <tt>psd(x,window=1,n=1024)</tt> estimates the power spectral density of @c x by averaging the
+  spectra of overlapping segments of @c n samples. Units are the square of the units of @c x per
+  Hertz.
+
+The @c window selects the window function applied before transforming: 0 for rectangular, 1 for
+Hann or 2 for Hamming. Spectra are not available for real time sources.
+
 # Advanced Plot References # {#xadvancedreferences}
 Plot references also support the following advanced features:
 - Indexing
@@ -641,7 +684,9 @@ rather than indexes.
 
 Also note that a slice expression must be regenerated if the referenced curve changes it's time
 domain. This occurs when the time column, time base or time scale are changed (consult
-@ref utimescale for more information).
+@ref utimescale for more information). This occurs automatically, along with any expression curves
+generated from the slice. Expression curves which do not depend on the changed time domain are left
+as they are.
 
 ## File specific references ## {#xfilereferences}
 A plot reference may specify matching only a specific plot file using the following syntax: